@@ -0,0 +1,69 @@
+#ifndef _BITSET_H
+#define _BITSET_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "error.h"
+#include "set.h"
+#include "list.h"
+
+/* Subset of the integers 0 ... n-1 stored as an array of bits, one per
+ * integer, packed in 64-bit words. Set operations and counting work on whole
+ * words, using AVX2 instructions if compiled with them (eg, -mavx2), and are
+ * much faster than set_t for dense subsets such as frontiers and components.
+ */
+typedef struct bitset_t bitset_t;
+
+/**** Allocation and deallocation ****/
+// Creates an empty subset of 0 ... n-1, or returns NULL if there's no memory.
+bitset_t *new_bitset(int n);
+void delete_bitset(bitset_t *bitset);
+
+/**** Insertion and retrieval ****/
+void bitset_add(bitset_t *bitset, int v);
+bool bitset_contains(const bitset_t *bitset, int v);
+bool bitset_remove(bitset_t *bitset, int v);
+// Removes all elements.
+void bitset_clean(bitset_t *bitset);
+// Adds all elements 0 ... n-1.
+void bitset_fill(bitset_t *bitset);
+
+/**** Set operations ****/
+// Both operands must have the same capacity.
+void bitset_union(bitset_t *dest, const bitset_t *other);
+void bitset_difference(bitset_t *dest, const bitset_t *other);
+void bitset_intersection(bitset_t *dest, const bitset_t *other);
+
+/**** Data structure querying ****/
+// Number of elements.
+int bitset_size(const bitset_t *bitset);
+// Number of integers that may be stored, ie, n.
+int bitset_capacity(const bitset_t *bitset);
+bool bitset_is_empty(const bitset_t *bitset);
+bool bitset_equals(const bitset_t *a, const bitset_t *b);
+
+/* Returns the smallest element greater or equal than v, or -1 if there's none.
+ * Iterates over all elements in increasing order with
+ *   for (v = bitset_next(bitset, 0); v >= 0; v = bitset_next(bitset, v+1))
+ */
+int bitset_next(const bitset_t *bitset, int v);
+
+/**** Printing ****/
+void bitset_print(const bitset_t *bitset);
+void bitset_fprint(FILE *stream, const bitset_t *bitset);
+
+/**** Copying and conversion ****/
+bitset_t *bitset_copy(const bitset_t *bitset);
+// Copies elements in increasing order to arr, returning their number.
+int bitset_to_array(const bitset_t *bitset, int *arr);
+// Creates a set or a sorted list with the same elements, or NULL if there's
+//no memory.
+set_t *bitset_to_set(const bitset_t *bitset);
+list_t *bitset_to_list(const bitset_t *bitset);
+// Creates a subset of 0 ... n-1 with the elements of set or list, which must
+//be in this range, or NULL if there's no memory.
+bitset_t *bitset_from_set(const set_t *set, int n);
+bitset_t *bitset_from_list(const list_t *list, int n);
+
+#endif
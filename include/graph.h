@@ -5,23 +5,44 @@
 #include "set.h"
 #include "list.h"
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 
+// Minimum number of vertices processed by each thread.
+#ifndef GRAPH_MIN_TASK
+ #define GRAPH_MIN_TASK 1024
+#endif
+
+// Number of threads used by functions without a num_processors argument.
+#ifndef GRAPH_NUM_PROCESSORS
+ #define GRAPH_NUM_PROCESSORS 4
+#endif
+
 typedef struct graph_t graph_t;
 
 // Allocation and deallocation
 graph_t * new_graph(int n, bool is_weighted, bool is_directed);
 void delete_graph(graph_t *graph);
+// Creates a graph with the m edges (edges[2*e], edges[2*e+1]) and weights 
+//weight[e], or 1.0 if weight is NULL, as if they were added in order: repeated
+//edges keep the first weight and self-loops are ignored. The edge list is 
+//radix sorted and the adjacencies built over num_processors threads, much 
+//faster than adding edges one by one. Returns NULL if there's no memory.
+graph_t *new_graph_from_edges
+	(int n, const int *edges, const double *weight, int64_t m, 
+	 bool is_weighted, bool is_directed, int num_processors);
 
 // Data input
 graph_t * load_graph(char *file_name, bool is_directed);
 
 // Insertion
+// Edges of weighted graphs added without a weight have weight 1.0.
 error_t graph_add_edge(graph_t *g, int i, int j);
 error_t graph_add_weighted_edge(graph_t *g, int i, int j, double w);
 
-// Sorting
-void graph_sort_edges(graph_t *g);
+// Removal
+// Removes edge (i, j), returning false if it doesn't exist.
+bool graph_remove_edge(graph_t *g, int i, int j);
 
 // Retrieval
 bool graph_is_adjacent(const graph_t *g, int i, int j);
@@ -29,7 +50,8 @@ double graph_get(const graph_t *g, int i, int j);
 
 // Query
 int graph_num_vertices(const graph_t *g);
-int graph_num_edges(const graph_t *g);
+// Edges are counted in 64 bits, while vertices are indexed with int.
+int64_t graph_num_edges(const graph_t *g);
 bool graph_is_directed(const graph_t *g);
 bool graph_is_weighted(const graph_t *g);
 
@@ -37,14 +59,57 @@ bool graph_is_weighted(const graph_t *g);
 int graph_num_adjacents(const graph_t *g, int i);
 int graph_adjacents(const graph_t *g, int i, int *adj);
 set_entry_t *graph_adjacent_head(const graph_t *g, int i);
+// Weight of the edge from i to the neighbor in adj, an entry of i's adjacency
+//list, in O(1). Unweighted graphs have weight 1.0.
+double graph_adjacent_weight(const graph_t *g, int i, const set_entry_t *adj);
+// Copies neighbors of i and the weights of their edges, returning their number.
+int graph_weighted_adjacents(const graph_t *g, int i, int *adj, double *weight);
 error_t graph_adjacent_set(const graph_t *g, int i, set_t *adj);
 
+// In-adjacencies
+// Directed graphs only store out-neighbors, unless the in-adjacency index is
+//built with graph_build_in_adjacency. It's then kept up to date as edges are
+//added or removed, at the cost of storing each edge twice. Undirected graphs
+//always have it, being their own adjacencies. The functions below require it.
+error_t graph_build_in_adjacency(graph_t *g);
+void graph_delete_in_adjacency(graph_t *g);
+bool graph_has_in_adjacency(const graph_t *g);
+// In-degree of i in O(1).
+int graph_num_in_adjacents(const graph_t *g, int i);
+// Copies vertices j with an edge (j, i), returning their number.
+int graph_in_adjacents(const graph_t *g, int i, int *adj);
+set_entry_t *graph_in_adjacent_head(const graph_t *g, int i);
+// Weight of the edge from the neighbor in adj, an entry of i's in-adjacency
+//list, to i, in O(1). Unweighted graphs have weight 1.0.
+double graph_in_adjacent_weight(const graph_t *g, int i, const set_entry_t *adj);
+
+// Copies all adjacencies to contiguous arrays, where the neighbors of i are
+//adj[offset[i]] ... adj[offset[i+1]-1]. Free both with free().
+error_t graph_csr(const graph_t *g, int64_t **offset, int **adj);
+
+// Edge ids
+// Edges are numbered from 0 to m-1 in the order of graph_adjacents for each
+//vertex, counting (i, j) only if i < j in undirected graphs. The index is 
+//built on the first call to graph_edge_id and discarded when an edge is 
+//added; build it with graph_build_edge_index before concurrent calls.
+error_t graph_build_edge_index(const graph_t *g);
+// Returns the id of edge (i, j) in O(log k_i), or -1 if it doesn't exist.
+int64_t graph_edge_id(const graph_t *g, int i, int j);
+
 // Printing
 void graph_print(const graph_t *graph);
 void graph_fprint(FILE *stream, const graph_t *graph);
 
 // Copying
 graph_t *graph_copy(const graph_t *graph);
+// Same as graph_induced_subgraph, with GRAPH_NUM_PROCESSORS threads.
 graph_t *graph_subset(const graph_t *graph, const list_t *vertices);
+// Creates the subgraph induced by the distinct vertices[0] ... vertices[n_sub-1],
+//where vertices[k] has index k, in O(n + m). If remap != NULL, remap[v] is set
+//to the new index of each vertex v of g, or -1 if it's not in the subgraph.
+//Rows are built over num_processors threads. Returns NULL if there's no memory.
+graph_t *graph_induced_subgraph
+	(const graph_t *g, const int *vertices, int n_sub, int *remap, 
+	 int num_processors);
 
 #endif
@@ -0,0 +1,78 @@
+#ifndef _GRAPH_COMPRESSED_H
+#define _GRAPH_COMPRESSED_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "error.h"
+#include "graph.h"
+
+/*********************************** Types ************************************/
+
+/** Read-only graph with compressed adjacency lists.
+ *
+ * Neighbors of each vertex are sorted and stored as gaps between consecutive
+ * neighbors, encoded as variable-length integers with 7 bits per byte, so that
+ * most neighbors take a single byte. Each list starts with the vertex degree
+ * and the first neighbor is encoded relative to the vertex itself. Weights, if
+ * any, are stored uncompressed in the same order.
+ */
+typedef struct graph_compressed_t graph_compressed_t;
+
+/** Position in a vertex's adjacency list. key is the current neighbor, valid
+ * after graph_compressed_next returns true. */
+typedef struct {
+	const unsigned char *next;
+	int remaining;
+	int vertex;
+	int key;
+} graph_compressed_iterator_t;
+
+/******************************** Allocation **********************************/
+
+// Compresses g, returning NULL if there's no memory.
+graph_compressed_t *new_graph_compressed(const graph_t *g);
+void delete_graph_compressed(graph_compressed_t *cg);
+// Creates a graph_t with the same edges, or NULL if there's no memory.
+graph_t *graph_decompress(const graph_compressed_t *cg);
+
+/********************************** Query *************************************/
+
+int graph_compressed_num_vertices(const graph_compressed_t *cg);
+int64_t graph_compressed_num_edges(const graph_compressed_t *cg);
+bool graph_compressed_is_directed(const graph_compressed_t *cg);
+bool graph_compressed_is_weighted(const graph_compressed_t *cg);
+// Bytes used by the compressed graph, including offsets and weights.
+size_t graph_compressed_size(const graph_compressed_t *cg);
+
+/******************************** Adjacencies *********************************/
+
+int graph_compressed_num_adjacents(const graph_compressed_t *cg, int i);
+/* Decodes neighbors of i in increasing order into adj, returning their number.
+ * This is the fastest way to traverse a whole list. */
+int graph_compressed_adjacents(const graph_compressed_t *cg, int i, int *adj);
+/* Same as graph_compressed_adjacents, also copying the weights of the edges.
+ * Unweighted graphs have weight 1.0. */
+int graph_compressed_weighted_adjacents
+	(const graph_compressed_t *cg, int i, int *adj, double *weight);
+// Checks if j is a neighbor of i, decoding the list of i until j.
+bool graph_compressed_is_adjacent(const graph_compressed_t *cg, int i, int j);
+
+/* Iterates over the neighbors of i in increasing order:
+ *   graph_compressed_iterator_t it;
+ *   graph_compressed_head(cg, i, &it);
+ *   while (graph_compressed_next(&it)){ ... it.key ... }
+ */
+void graph_compressed_head
+	(const graph_compressed_t *cg, int i, graph_compressed_iterator_t *it);
+bool graph_compressed_next(graph_compressed_iterator_t *it);
+
+/********************************** Metrics ***********************************/
+
+// Same as graph_degree: directed graphs count in- and out-neighbors.
+void graph_compressed_degree(const graph_compressed_t *cg, int *degree);
+// Same as graph_geodesic_vertex.
+void graph_compressed_geodesic_vertex
+	(const graph_compressed_t *cg, int i, int *distance);
+
+#endif
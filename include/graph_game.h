@@ -4,6 +4,28 @@
 #include "graph.h"
 #include "graph_layout.h"
 
+/********************************* Constants **********************************/
+
+/* Vertices are split in blocks with independent random streams. */
+#ifndef GRAPH_GAME_BLOCK_SIZE
+ #define GRAPH_GAME_BLOCK_SIZE 1024
+#endif
+
+/* Number of threads used by graph_game_r. */
+#ifndef GRAPH_GAME_NUM_PROCESSORS
+ #define GRAPH_GAME_NUM_PROCESSORS 4
+#endif
+
+/* Asynchronous runs stop when the mean cooperator fraction of the last 
+ * GRAPH_GAME_WINDOW steps differs from the previous window by less than 
+ * GRAPH_GAME_TOLERANCE. */
+#ifndef GRAPH_GAME_WINDOW
+ #define GRAPH_GAME_WINDOW 100
+#endif
+#ifndef GRAPH_GAME_TOLERANCE
+ #define GRAPH_GAME_TOLERANCE 1e-3
+#endif
+
 typedef enum {GRAPH_GAME_COOP, GRAPH_GAME_DEFECT} graph_game_state_t;
 
 typedef struct {
@@ -15,16 +37,53 @@ typedef struct {
 graph_game_step_t *new_graph_game_steps(int num_steps, int n);
 void delete_graph_game_steps(graph_game_step_t *step, int num_steps);
 
+/* Simulates num_steps-1 synchronous rounds of an evolutionary game, where
+ * each vertex plays with all its neighbors and then imitates a random neighbor
+ * with probability proportional to their payoff difference.
+ *
+ * Payoff and imitation phases are split by vertex ranges among num_processors
+ * threads. Each block of GRAPH_GAME_BLOCK_SIZE vertices has its own random
+ * stream seeded from seedp, so results are the same for any number of
+ * processors.
+ */
 void graph_game_r
 	(const graph_t *g, graph_game_state_t *init_state, 
 	 float payoff[2][2], float spread, 
 	 graph_game_step_t *step, int num_steps, unsigned int *seedp);
+void graph_game_parallel_r
+	(const graph_t *g, graph_game_state_t *init_state, 
+	 float payoff[2][2], float spread, 
+	 graph_game_step_t *step, int num_steps, unsigned int *seedp,
+	 int num_processors);
+
+/* Simulates the same game with asynchronous (random sequential) updates: 
+ * each Monte Carlo step has n elementary updates of a random vertex. Only 
+ * the current state is kept, and payoffs of neighbors of a vertex that 
+ * switches strategy are updated incrementally.
+ *
+ * The run stops after max_steps, when all vertices have the same strategy or
+ * when the cooperator fraction is stationary.
+ *
+ * Pre:
+ *   state has dimension n, with the initial strategies.
+ * Post:
+ *   state has the final strategies.
+ *   if fp != NULL, a line "t coop_fraction" was written for every step t,
+ *  including t = 0.
+ * Return value:
+ *   Number of Monte Carlo steps, or -1 if there is no memory.
+ */
+int graph_game_async_r
+	(const graph_t *g, graph_game_state_t *state,
+	 float payoff[2][2], float spread,
+	 int max_steps, FILE *fp, unsigned int *seedp);
 
 void graph_game_prisioner_r
 	(const graph_t *g, double coop_fraction, float b,
 	 graph_game_step_t *step, int num_steps, unsigned int *seedp);
 
-void graph_animate_game
+// Prints frames of a game, returning an error if some frame couldn't be printed.
+error_t graph_animate_game
 	(const char *folder, const graph_t *g, const coord_t *p,
 	 graph_game_step_t *step, int num_steps);
 
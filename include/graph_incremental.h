@@ -0,0 +1,66 @@
+#ifndef _GRAPH_INCREMENTAL_H
+#define _GRAPH_INCREMENTAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "error.h"
+#include "graph.h"
+
+/*********************************** Types ************************************/
+
+/** Metrics of an undirected graph kept up to date under edge insertions and
+ * deletions. The graph must only be modified through graph_incremental_add_edge
+ * and graph_incremental_remove_edge while metrics are tracked, and all arrays
+ * are read-only for users.
+ */
+typedef struct {
+	graph_t *g;
+	int n;
+
+	int *degree;
+	int64_t *triangles;   // Number of triangles including each vertex
+	int64_t num_triangles;
+
+	int *component;       // Label of each vertex's component, from 0 to n-1
+	int *component_size;  // Number of vertices with each label
+	int num_components;
+
+	int *core;            // Core number of each vertex
+
+	// Workspace for traversals
+	int *free_label;      // Stack of labels not in use
+	int *queue, *queue_other;
+	int *mark;            // Vertex was visited in traversal if mark[v] == epoch
+	int epoch;
+	int *support;         // Neighbors supporting each vertex in k-core update
+} graph_incremental_t;
+
+/********************************* Functions **********************************/
+
+/* Computes all metrics of undirected graph g from scratch. Returns NULL if
+ * there's no memory. */
+graph_incremental_t *new_graph_incremental(graph_t *g);
+void delete_graph_incremental(graph_incremental_t *inc);
+
+/* Adds or removes edge (i, j) and updates metrics, in time proportional to
+ * the size of the affected neighborhood:
+ *   - degrees are updated in O(1);
+ *   - triangles in O(min(k_i, k_j)), checking common neighbors;
+ *   - components, when joined, relabel the smaller one, and when an edge is
+ *     removed, a search from both endpoints stops when they meet or when the
+ *     smaller side is exhausted, relabeling it;
+ *   - core numbers change by at most 1, and only for vertices with the core
+ *     number of the endpoints that are connected to them through such vertices
+ *     (their subcore), that are traversed and peeled.
+ * Adding an existing edge or removing a missing one does nothing, and
+ * graph_incremental_remove_edge returns false in the latter case. */
+error_t graph_incremental_add_edge(graph_incremental_t *inc, int i, int j);
+bool graph_incremental_remove_edge(graph_incremental_t *inc, int i, int j);
+
+// Local clustering of vertex i, as in graph_clustering.
+double graph_incremental_clustering(const graph_incremental_t *inc, int i);
+// Returns whether i and j are in the same component.
+bool graph_incremental_is_connected(const graph_incremental_t *inc, int i, int j);
+
+#endif
@@ -1,6 +1,52 @@
 #ifndef _GRAPH_LAYOUT_H
 #define _GRAPH_LAYOUT_H
 
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "error.h"
+
+/******************************** Constants ***********************************/
+
+/* Ideal distance between adjacent vertices in the force layout, in units of
+ * vertex radius. */
+#ifndef GRAPH_LAYOUT_DISTANCE
+ #define GRAPH_LAYOUT_DISTANCE 4.0f
+#endif
+/* Barnes-Hut opening criterion: a quadtree cell of side s at distance d is 
+ * approximated by its center of mass if s/d < GRAPH_LAYOUT_THETA. */
+#ifndef GRAPH_LAYOUT_THETA
+ #define GRAPH_LAYOUT_THETA 0.8f
+#endif
+/* Quadtree cells with this many vertices or less are not split. */
+#ifndef GRAPH_LAYOUT_LEAF_SIZE
+ #define GRAPH_LAYOUT_LEAF_SIZE 4
+#endif
+#ifndef GRAPH_LAYOUT_MAX_DEPTH
+ #define GRAPH_LAYOUT_MAX_DEPTH 32
+#endif
+/* Strength of the attraction towards the centroid, that keeps disconnected
+ * components together. */
+#ifndef GRAPH_LAYOUT_GRAVITY
+ #define GRAPH_LAYOUT_GRAVITY 0.01f
+#endif
+/* Minimum number of vertices per thread. */
+#ifndef GRAPH_LAYOUT_MIN_TASK
+ #define GRAPH_LAYOUT_MIN_TASK 1024
+#endif
+/* Number of threads printing animation frames. */
+#ifndef GRAPH_LAYOUT_NUM_PROCESSORS
+ #define GRAPH_LAYOUT_NUM_PROCESSORS 4
+#endif
+/* Multilevel layout stops coarsening at this number of vertices, or when the
+ * coarse graph has more than GRAPH_LAYOUT_COARSENING times the vertices. */
+#ifndef GRAPH_LAYOUT_COARSEST
+ #define GRAPH_LAYOUT_COARSEST 100
+#endif
+#ifndef GRAPH_LAYOUT_COARSENING
+ #define GRAPH_LAYOUT_COARSENING 0.8
+#endif
+
 /********************************* Types *************************************/
 typedef struct{
 	float x, y;
@@ -31,6 +77,17 @@ typedef struct{
 	color_t color;
 } path_style_t;
 
+// Reusable buffer where SVG files are formatted before being written at once.
+typedef struct {
+	char *data;
+	size_t size, capacity;
+	bool is_failure;
+} graph_svg_buffer_t;
+
+// Prints frame number frame using buffer, returning an error if it couldn't.
+typedef error_t (*graph_frame_f)
+	(int frame, graph_svg_buffer_t *buffer, void *data);
+
 /***************************** Color functions ********************************/
 // Copy color from original to copy
 void color_copy(color_t copy, const color_t original);
@@ -64,6 +121,22 @@ double graph_layout_degree_shell
 double graph_layout_core_shell
 	(const graph_t *g, int radius, bool is_random_angle, coord_t *p);
 
+/* Places points with a force-directed (Fruchterman-Reingold) layout, with 
+ * Barnes-Hut approximation of repulsion computed by num_processors threads.
+ * If is_multilevel, the graph is recursively coarsened by matching adjacent
+ * vertices, and each layout starts from the coarser one, which is much faster
+ * for large graphs. Directed edges are laid out as undirected.
+ * 
+ * The result depends only on the graph and on seedp, and all points have
+ * coordinates at least radius.
+ * 
+ * Returns the side of a square box containing all circles, or a negative 
+ * number if there is no memory.
+ */
+double graph_layout_force_r
+	(const graph_t *g, int radius, int num_iterations, bool is_multilevel,
+	 int num_processors, coord_t *p, unsigned int *seedp);
+
 /******************************* Printing *************************************/
 
 // Prints graph as SVG to file, using vertex coordinates given in p and
@@ -97,4 +170,36 @@ void graph_print_svg_some_styles
 	 const int *ps, const circle_style_t *point_style, int num_point_style,
 	 const int *es, const path_style_t *edge_style, int num_edge_style);
 
+// The buffered versions reuse the memory of buffer, that must be initialized
+//with graph_svg_buffer_init and released with graph_svg_buffer_free.
+void graph_svg_buffer_init(graph_svg_buffer_t *buffer);
+void graph_svg_buffer_free(graph_svg_buffer_t *buffer);
+
+/* Return ERROR_NO_MEMORY if there's no memory for the file contents, and
+ * ERROR_UNDEFINED if the file couldn't be written. */
+error_t graph_print_svg_buffered
+	(graph_svg_buffer_t *buffer,
+	 const char *filename,
+	 int width, int height, 
+	 const graph_t *g, 
+	 const coord_t *p, 
+	 const circle_style_t *point_style,
+	 const path_style_t *edge_style);
+error_t graph_print_svg_some_styles_buffered
+	(graph_svg_buffer_t *buffer,
+	 const char *filename,
+	 int width, int height, 
+	 const graph_t *g, 
+	 const coord_t *p, 
+	 const int *ps, const circle_style_t *point_style, int num_point_style,
+	 const int *es, const path_style_t *edge_style, int num_edge_style);
+
+// Calls print_frame for frames 0 ... num_frames-1, distributed among 
+//num_processors threads with a buffer each. print_frame must only read shared
+//data; call graph_build_edge_index before if it uses graph_edge_id. Returns
+//the error of a frame that failed, if any, after printing all others.
+error_t graph_print_frames
+	(int num_frames, int num_processors, 
+	 graph_frame_f print_frame, void *data);
+
 #endif
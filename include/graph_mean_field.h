@@ -0,0 +1,82 @@
+#ifndef _GRAPH_MEAN_FIELD_H
+#define _GRAPH_MEAN_FIELD_H
+
+#include "stat.h"
+#include "graph.h"
+#include "graph_propagation.h"
+
+/********************************* Constants **********************************/
+
+/* SIS integration stops when no fraction changes faster than this tolerance
+ * per time unit. It must be larger than the integration error. */
+#ifndef GRAPH_MEAN_FIELD_TOLERANCE
+ #define GRAPH_MEAN_FIELD_TOLERANCE 1e-4
+#endif
+
+/*********************************** Types ************************************/
+/** Mean-field approximations of the propagation models in graph_propagation.
+ *
+ * As in the stochastic simulation, each infectious vertex j sends a message
+ * per time unit to one of its k_j neighbors, so that the infection rate
+ * along an edge (j, i) is alpha/k_j, and infectious vertices recover with
+ * rate beta.
+ *
+ * GRAPH_MEAN_FIELD_HMF: heterogeneous mean-field, where all vertices with the
+ *  same degree are equivalent and neighbors' degrees are uncorrelated. It only
+ *  depends on the degree distribution.
+ * GRAPH_MEAN_FIELD_QMF: quenched mean-field, with one equation per vertex and
+ *  the adjacency matrix as a sparse operator.
+ * GRAPH_MEAN_FIELD_PAIR: pair approximation, with additional equations for
+ *  the state of each pair of adjacent vertices, closing triples as
+ *  [A_i B_j C_l] = [A_i B_j][B_j C_l]/[B_j].
+ */
+typedef enum {
+	GRAPH_MEAN_FIELD_HMF, GRAPH_MEAN_FIELD_QMF, GRAPH_MEAN_FIELD_PAIR,
+	GRAPH_MEAN_FIELD_NUM_TYPE
+} graph_mean_field_t;
+
+// Receives the fraction of vertices in each state at time t.
+typedef void (*graph_mean_field_sample_f)
+	(double t, const double *fraction, int num_state, void *data);
+
+/********************************* Functions **********************************/
+/* Integrates SIS mean-field equations from the given initial state, until
+ * the infection dies out, a stationary state is reached or t reaches t_max.
+ *
+ * Pre:
+ *   init_state has dimension n, with values in graph_state_sis_t.
+ * Post:
+ *   if sample != NULL, it was called with the fraction of vertices in each
+ *  state at times 0, dt, 2*dt, ... and at the final time.
+ *   if fraction != NULL, it has the final fraction of vertices in each state.
+ * Return value:
+ *   Final time, or a negative number if there is no memory.
+ * */
+double graph_mean_field_sis
+	(const graph_t *g, graph_mean_field_t type, graph_sis_params_t params,
+	 const short *init_state, double dt, double t_max,
+	 graph_mean_field_sample_f sample, void *data, double *fraction);
+
+/* Integrates SIR mean-field equations, with the same conventions as
+ * graph_mean_field_sis. Integration stops when the expected number of
+ * infectious vertices is less than 0.5.
+ * */
+double graph_mean_field_sir
+	(const graph_t *g, graph_mean_field_t type, graph_sir_params_t params,
+	 const short *init_state, double dt, double t_max,
+	 graph_mean_field_sample_f sample, void *data, double *fraction);
+
+/* Integrates HMF equations given only the degree distribution, as returned
+ * by stat_frequencies, with an initial fraction rho0 of infectious vertices
+ * in every degree class.
+ * */
+double graph_hmf_sis_distribution
+	(const pair_t *freq, int num_degree, graph_sis_params_t params,
+	 double rho0, double dt, double t_max,
+	 graph_mean_field_sample_f sample, void *data, double *fraction);
+double graph_hmf_sir_distribution
+	(const pair_t *freq, int num_degree, graph_sir_params_t params,
+	 double rho0, double dt, double t_max,
+	 graph_mean_field_sample_f sample, void *data, double *fraction);
+
+#endif
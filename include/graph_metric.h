@@ -27,7 +27,8 @@ graph_t * graph_giant_component(const graph_t *g);
 /***************************** Degree metrics *********************************/
 // List all vertices' degrees.
 void graph_degree(const graph_t *g, int *degree);
-// List all vertices' incoming and outgoing degrees.
+// List all vertices' incoming and outgoing degrees. Both are found in O(n) if
+//the in-adjacency index is built, and in O(n + m) otherwise.
 void graph_directed_degree(const graph_t *g, int *in_degree, int *out_degree);
 
 /***************************** Clustering metrics *****************************/
@@ -52,7 +53,7 @@ void graph_clustering(const graph_t *g, double *clustering);
  *   If num_triangle != NULL, *num_triangle has the number of triangles.
  * */
 void graph_num_triplets
-	(const graph_t *g, int *num_triplet, int *num_triangle);
+	(const graph_t *g, int64_t *num_triplet, int64_t *num_triangle);
 /* Compute the ratio between number of triangles and number of triplets.
  * This measure is only defined for undirected graphs.
  * 
@@ -107,6 +108,10 @@ int graph_geodesic_distance(const graph_t *g, int i, int j);
  *  if they are not reachable.
  * */
 void graph_geodesic_vertex(const graph_t *g, int i, int *distance);
+/* Same as graph_geodesic_vertex, following edges backwards, so that 
+ * distance[j] is the geodesic distance from j to i. Requires the in-adjacency
+ * index of directed graphs, see graph_build_in_adjacency. */
+void graph_in_geodesic_vertex(const graph_t *g, int i, int *distance);
 /* Calculates all geodesic distances between all pair of vertices.
  * If g is undirected, the resulting matrix is symmetric.
  * 
@@ -138,7 +143,51 @@ void graph_geodesic_all(const graph_t *g, int **distance);
  * Memory deallocation:
  *   free(distribution);
  * */
-int *graph_geodesic_distribution(const graph_t *g, int *diameter);
+int64_t *graph_geodesic_distribution(const graph_t *g, int *diameter);
+
+/******************** Weighted geodesic distance metrics **********************/
+/* In a weighted graph, the length of a path is the sum of the weights of its
+ * edges, and a weighted geodesic path is a path with the smallest length
+ * possible. Weights must be non-negative; unweighted graphs have all weights
+ * equal to 1, so weighted and unweighted geodesic distances coincide.
+ */
+/* Calculates weighted geodesic distance between a vertex and all other vertices.
+ * The algorithm is Dijkstra's, using a pairing heap as priority queue, in
+ * O(m + n log n).
+ * 
+ * Pre:
+ *   i is a valid vertex index (0 <= i < n).
+ *   distance is an array with dimension n.
+ * Post:
+ *   distance[j] is the weighted geodesic distance between i and j, or INFINITY
+ *  if they are not reachable.
+ * */
+void graph_weighted_geodesic_vertex(const graph_t *g, int i, double *distance);
+/* Same as graph_weighted_geodesic_vertex, using num_processors threads with 
+ * the delta-stepping algorithm.
+ * 
+ * Vertices are kept in buckets of width delta by their tentative distance,
+ * and each bucket is emptied relaxing its vertices' light edges (weight up to 
+ * delta) in parallel, until no more vertices enter it, and then their heavy 
+ * edges. Each thread owns the vertices with index equal to its own modulo
+ * num_processors, and relaxes the requests made to them by all threads.
+ * 
+ * If delta <= 0.0, it's chosen as the largest weight divided by the average
+ * degree. Small values of delta make more buckets with less parallel work,
+ * and large values relax more edges than needed.
+ * If a failure happens launching threads or allocating memory, distances are 
+ * calculated single-threaded.
+ * 
+ * Pre:
+ *   i is a valid vertex index (0 <= i < n).
+ *   distance is an array with dimension n.
+ *   num_processors > 0
+ * Post:
+ *   distance[j] is the weighted geodesic distance between i and j, or INFINITY
+ *  if they are not reachable.
+ * */
+void graph_delta_stepping
+	(const graph_t *g, int i, double delta, double *distance, int num_processors);
 
 /************************ Centrality measures *********************************/
 /* List all vertices' betweenness centrality.
@@ -161,6 +210,20 @@ int *graph_geodesic_distribution(const graph_t *g, int *diameter);
 void graph_betweenness(const graph_t *g, double *betweenness);
 void graph_parallel_betweenness
 	(const graph_t *g, double *betweenness, int num_processors);
+/* List all vertices' betweenness centrality using weighted geodesic paths.
+ * 
+ * Paths are found with Dijkstra's algorithm, and two paths have the same 
+ * length only if their sums of weights are exactly equal. Weights must be 
+ * positive.
+ * 
+ * Pre:
+ *   betweenness is an array with dimension n
+ * Post:
+ *   betweenness[v] = B_v, where P_st are the weighted geodesic paths.
+ * */
+void graph_weighted_betweenness(const graph_t *g, double *betweenness);
+void graph_parallel_weighted_betweenness
+	(const graph_t *g, double *betweenness, int num_processors);
 
 /* List all vertices' eigenvector centrality.
  * 
@@ -214,6 +277,15 @@ int graph_kcore(const graph_t *g, int *core);
 
 /* List all vertices' closenness. */
 void graph_closeness(const graph_t *g, double *closenness);
+/* List all vertices' closeness using weighted geodesic distances.
+ * 
+ * The closeness of a vertex is the inverse of the sum of its weighted geodesic
+ * distances to all reachable vertices, or 0.0 if it can't reach any other.
+ * 
+ * Pre:
+ *   closeness is an array with dimension n
+ * */
+void graph_weighted_closeness(const graph_t *g, double *closeness);
 
 /************************ Correlation measures ********************************/
 /* Calculates the distribution matrix of degrees (ki,kj).
@@ -3,8 +3,10 @@
 
 #include <stdbool.h>
 
+#include "error.h"
 #include "graph.h"
 #include "graph_layout.h"
+#include "graph_raster.h"
 
 /********************************* Constants **********************************/
 
@@ -60,22 +62,48 @@ propagation_step_t *graph_propagation_r
 // Deallocate a step array that was allocated with graph_propagation.
 void delete_propagation_steps(propagation_step_t *step, int num_step);
 
-// Creates animation frames of a propagation in the given graph.
-void graph_animate_propagation
+// Creates animation frames of a propagation in the given graph. Returns
+//ERROR_NO_MEMORY if frames couldn't be printed.
+error_t graph_animate_propagation
 	(const char *folder, const graph_t *g, const coord_t *p, 
 	 int num_state,
 	 const propagation_step_t *step, int num_step);
 	 
 	 // Creates animation frames of a propagation in the given graph.
-void graph_animate_propagation_steps
+error_t graph_animate_propagation_steps
 	(const char *folder, const graph_t *g, const coord_t *p, 
 	 int num_state,
 	 const propagation_step_t *step, int num_step, int steps);
 
+// Creates animation frames as PPM or PNG images of size x size pixels, or 
+//with one pixel per unit of p if size <= 0. Edges are drawn only once, and
+//each frame is a copy of them with messages and vertices drawn over it.
+//Returns ERROR_NO_MEMORY if frames couldn't be printed.
+error_t graph_animate_propagation_raster
+	(const char *folder, const graph_t *g, const coord_t *p, 
+	 int num_state,
+	 const propagation_step_t *step, int num_step, int steps,
+	 int size, graph_raster_format_t format);
+
 // Compute the number of individuals in each state at each propagation step.
 void graph_propagation_freq
 	(const propagation_step_t *step, int num_step, int **freq, int num_state);
 
+/* Saves a propagation as an animation file, with the graph geometry written 
+ * once, followed by the vertices that changed state and the messages of each
+ * step. It is much smaller than the frames, which may be created later from 
+ * the file with bin/animate.
+ * */
+error_t graph_save_propagation
+	(const char *filename, const graph_t *g, const coord_t *p,
+	 int num_state, const propagation_step_t *step, int num_step);
+
+// Loads an animation file, returning its steps or NULL in case of error.
+//Graph and coordinates are allocated in *g and *p.
+propagation_step_t *graph_load_propagation
+	(const char *filename, graph_t **g, coord_t **p,
+	 int *num_state, int *num_step);
+
 /********************************* SI model ***********************************/
 typedef struct { 
 	double alpha; // Infection probability
@@ -0,0 +1,65 @@
+#ifndef _GRAPH_RASTER_H
+#define _GRAPH_RASTER_H
+
+#include "error.h"
+#include "graph.h"
+#include "graph_layout.h"
+
+/********************************* Constants **********************************/
+
+/* Curved edges are drawn as this number of straight segments. */
+#ifndef GRAPH_RASTER_SEGMENTS
+ #define GRAPH_RASTER_SEGMENTS 16
+#endif
+
+/*********************************** Types ************************************/
+typedef enum {GRAPH_RASTER_PPM, GRAPH_RASTER_PNG} graph_raster_format_t;
+
+/** RGBA framebuffer, with 8 bits per channel and pixels stored row by row
+ * from the top left corner. Graph coordinates are multiplied by scale to give
+ * pixel coordinates.
+ */
+typedef struct {
+	int width, height;
+	float scale;
+	unsigned char *pixel;
+} graph_raster_t;
+
+/********************************* Functions **********************************/
+// Creates a transparent raster with the given size in pixels.
+graph_raster_t *new_graph_raster(int width, int height, float scale);
+void delete_graph_raster(graph_raster_t *r);
+
+// Fills all pixels with color, without blending.
+void graph_raster_clear(graph_raster_t *r, const color_t color);
+// Copies all pixels from original, that must have the same size.
+void graph_raster_copy(graph_raster_t *copy, const graph_raster_t *original);
+
+/* Draws anti-aliased primitives with alpha blending. Parabolas are quadratic
+ * Bézier curves with the control point from style, and circular edges are
+ * arcs as printed in SVG. */
+void graph_raster_path
+	(graph_raster_t *r, const coord_t from, const coord_t to,
+	 const path_style_t style);
+void graph_raster_circle
+	(graph_raster_t *r, const coord_t p, const circle_style_t style);
+
+/* Draws all edges and then all vertices, in the same order and with the same
+ * style mappings as graph_print_svg and graph_print_svg_some_styles. Any of
+ * the style arrays may be NULL to skip drawing edges or vertices. */
+void graph_raster_draw
+	(graph_raster_t *r, const graph_t *g, const coord_t *p,
+	 const circle_style_t *point_style, const path_style_t *edge_style);
+void graph_raster_draw_some_styles
+	(graph_raster_t *r, const graph_t *g, const coord_t *p,
+	 const int *ps, const circle_style_t *point_style,
+	 const int *es, const path_style_t *edge_style);
+
+// Writes raster as binary PPM, blending it over a white background.
+error_t graph_raster_write_ppm(const graph_raster_t *r, const char *filename);
+// Writes raster as an RGBA PNG, with uncompressed (stored) deflate blocks.
+error_t graph_raster_write_png(const graph_raster_t *r, const char *filename);
+error_t graph_raster_write
+	(const graph_raster_t *r, const char *filename, graph_raster_format_t format);
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef _GRAPH_REORDER_H
+#define _GRAPH_REORDER_H
+
+#include "error.h"
+#include "graph.h"
+
+/********************************* Constants **********************************/
+
+// Maximum number of label propagation rounds in graph_reorder_community.
+#ifndef GRAPH_REORDER_MAX_ITERATIONS
+ #define GRAPH_REORDER_MAX_ITERATIONS 20
+#endif
+
+/********************************* Orderings **********************************/
+/* Vertex orderings that place vertices accessed together close in memory,
+ * speeding up traversals of the relabeled graph.
+ *
+ * An ordering is an array order with dimension n, where order[k] is the
+ * original index of the vertex placed at position k. It's also the map from
+ * new to original indices, used to report results in original indices.
+ *
+ * Return value:
+ *   Array order, or NULL if there's no memory.
+ * Memory deallocation:
+ *   free(order);
+ */
+// Hub sorting: vertices in decreasing order of degree, ties by index.
+int *graph_reorder_degree(const graph_t *g);
+/* Reverse Cuthill-McKee: each component is traversed in breadth-first order
+ * from a vertex with minimum degree, visiting neighbors in increasing order of
+ * degree, and the whole sequence is reversed. This reduces the bandwidth of
+ * the adjacency matrix, ie, the largest difference between adjacent indices. */
+int *graph_reorder_rcm(const graph_t *g);
+/* Community ordering: communities are found by label propagation, where each
+ * vertex repeatedly takes the most frequent label among its neighbors, and
+ * vertices are grouped by community, larger communities first, ties by index.
+ * Vertices are visited in random order with a fixed seed, so the ordering is
+ * reproducible. */
+int *graph_reorder_community(const graph_t *g);
+
+/******************************** Relabeling **********************************/
+
+/* Returns the inverse of order, where label[v] is the new index of original
+ * vertex v, or NULL if there's no memory. */
+int *graph_reorder_inverse(const int *order, int n);
+/* Creates a copy of g where the vertex at position k of order has index k,
+ * keeping weights and direction. Returns NULL if there's no memory. */
+graph_t *graph_reorder_apply(const graph_t *g, const int *order);
+/* Permutes in place an array x with dimension n indexed by new indices, such
+ * as a metric computed on the relabeled graph, to original indices. */
+error_t graph_reorder_restore(const int *order, int n, double *x);
+
+#endif
@@ -6,6 +6,11 @@
 #include <stdbool.h>
 #include <stdio.h>
 
+// Lists with at least this size are sorted with radix sort by list_sort.
+#ifndef LIST_RADIX_SORT_SIZE
+ #define LIST_RADIX_SORT_SIZE 256
+#endif
+
 typedef struct list_t list_t;
 
 /**** Allocation and deallocation ****/
@@ -0,0 +1,73 @@
+#ifndef _ODE_H
+#define _ODE_H
+
+#include <stdbool.h>
+
+/********************************* Constants **********************************/
+
+/* Relative and absolute error tolerances for adaptive steps. */
+#ifndef ODE_RELATIVE_TOLERANCE
+ #define ODE_RELATIVE_TOLERANCE 1e-6
+#endif
+#ifndef ODE_ABSOLUTE_TOLERANCE
+ #define ODE_ABSOLUTE_TOLERANCE 1e-9
+#endif
+/* Maximum number of accepted and rejected steps before giving up. */
+#ifndef ODE_MAX_STEPS
+ #define ODE_MAX_STEPS 1000000
+#endif
+/* Number of bisections used to locate a stop event inside a step. */
+#ifndef ODE_EVENT_ITERATIONS
+ #define ODE_EVENT_ITERATIONS 40
+#endif
+
+/*********************************** Types ************************************/
+/** Ensembles are stored in structure-of-arrays layout: for a system with n
+ * components and m members, component k of member j is at x[k*m + j]. A single
+ * integration is simply an ensemble with m == 1.
+ *
+ * Keeping all members' values of a component contiguous lets the derivative
+ * callbacks be written as plain loops over j, which compilers vectorize.
+ */
+
+// Computes y = dx/dt for all m members of the ensemble.
+typedef void (*ode_deriv_f)
+	(double *y, const double *x, int m, const void *params);
+
+// Tests whether member j has reached its stop condition at time t.
+typedef bool (*ode_stop_f)
+	(double t, const double *x, int m, int j, const void *params);
+
+// Receives the interpolated state of all members at a sample time t.
+typedef void (*ode_sample_f)
+	(double t, const double *x, int n, int m, void *data);
+
+/********************************* Functions **********************************/
+/* Integrates x' = f(x) from t = 0 with Dormand-Prince 5(4) adaptive steps.
+ *
+ * Each member j stops being tracked when stop(t, x, m, j, params) first holds;
+ * the exact time is located by bisection over the dense output of the step.
+ * Integration ends when all members have stopped, or when t reaches t_max.
+ *
+ * Pre:
+ *   x has dimension n*m and holds the initial state.
+ *   dt >= 0.0 and t_max > 0.0.
+ * Post:
+ *   x holds the state at the final time.
+ *   if t_stop != NULL, t_stop[j] is the stop time of member j, or t_max if it
+ *  never stopped.
+ *   if x_stop != NULL, it holds each member's state at its stop time.
+ *   if sample != NULL, it was called at t = 0, dt, 2*dt, ... up to the final
+ *  time, and then once more at the final time. If dt == 0.0, it is only called
+ *  at t = 0 and at the final time.
+ * Return value:
+ *   Number of accepted steps, or -1 if there is no memory or the step size
+ *  underflowed.
+ * */
+int ode_dopri5
+	(ode_deriv_f f, ode_stop_f stop, const void *params,
+	 double *x, int n, int m, double dt, double t_max,
+	 double *t_stop, double *x_stop,
+	 ode_sample_f sample, void *data);
+
+#endif
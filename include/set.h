@@ -21,6 +21,16 @@ void delete_set(set_t *set);
 error_t set_put(set_t *set, int v);
 
 bool set_contains(const set_t *set, int v);
+
+/* Each element may have a value, stored along its position so that it is
+ * found in O(1) by key or while traversing the linked list. Elements put
+ * without a value, or missing, have value 0.0. */
+error_t set_put_value(set_t *set, int v, double value);
+double set_value(const set_t *set, int v);
+double set_entry_value(const set_t *set, const set_entry_t *entry);
+
+/* Elements are kept in a dense array, in the same order as the linked list.
+ * Both functions take O(1), and set_index returns -1 if v is missing. */
 int set_get(const set_t *set, int pos);
 int set_index(const set_t *set, int v);
 
@@ -29,6 +39,7 @@ int set_get_random(const set_t *set);
 int set_get_random_r(const set_t *set, unsigned int *seedp);
 
 /**** Removing ****/
+// Moves the last element to the position of v, in O(1).
 bool set_remove(set_t *set, int v);
 void set_clean(set_t *set);
 
@@ -1,6 +1,16 @@
 #ifndef _SORTING_H
 #define _SORTING_H
 
+#include <stddef.h>
+#include <stdint.h>
+
+#include "error.h"
+
+// Minimum number of elements sorted by each thread.
+#ifndef SORTING_MIN_TASK
+ #define SORTING_MIN_TASK 65536
+#endif
+
 typedef int (*comparator_fn_t)(const void*, const void*);
 
 typedef void* (*search_f)
@@ -23,4 +33,22 @@ int comp_int_desc(const void *p_i1, const void *p_i2);
 int comp_double_asc(const void *p_d1, const void *p_d2);
 int comp_double_desc(const void *p_d1, const void *p_d2);
 
+/* Radix sorts
+ * Stable least significant digit radix sorts, with one byte per pass, in 
+ * O(n) for each byte that differs among the elements. Passes are split over
+ * num_processors threads, each counting and then moving a block of elements.
+ * 
+ * Return value:
+ *   ERROR_NO_MEMORY if there's no memory for the buffer, leaving the array
+ *  unchanged, and ERROR_SUCCESS otherwise.
+ */
+// Sorts n ints in increasing order, as 32-bit keys with a buffer of n ints.
+error_t radix_sort_int(int *v, size_t n, int num_processors);
+// Sorts n pairs (v[2*i], v[2*i+1]) by the first and then by the second int.
+error_t radix_sort_pairs(int *v, size_t n, int num_processors);
+// Sorts n keys in increasing order, moving value[i] with key[i] if value is 
+//not NULL.
+error_t radix_sort_keys
+	(uint64_t *key, double *value, size_t n, int num_processors);
+
 #endif
@@ -1,6 +1,35 @@
 #ifndef _STAT_H
 #define _STAT_H
 
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "error.h"
+
+/********************************* Constants **********************************/
+
+/* Streaming kernels process values in blocks of this size, that fit in cache,
+ * computing exact moments of each block and merging them. */
+#ifndef STAT_BLOCK_SIZE
+ #define STAT_BLOCK_SIZE 256
+#endif
+/* stat_frequencies counts values directly in an array, instead of sorting
+ * them, if their range is at most STAT_COUNTING_RANGE times their number. */
+#ifndef STAT_COUNTING_RANGE
+ #define STAT_COUNTING_RANGE 4
+#endif
+
+/* Default accuracy parameter of KLL sketches. The rank error is about 
+ * 1.7/STAT_KLL_K with high probability. */
+#ifndef STAT_KLL_K
+ #define STAT_KLL_K 200
+#endif
+#ifndef STAT_LOG_BINS_PER_DECADE
+ #define STAT_LOG_BINS_PER_DECADE 10
+#endif
+
+/*********************************** Types ************************************/
+
 typedef struct {
 	int key;
 	int value;
@@ -12,6 +41,55 @@ typedef struct {
 	int value;
 } interval_t;
 
+// Running moments of a stream of values, that may be merged.
+typedef struct {
+	double n;    // Number of values
+	double mean;
+	double m2;   // Sum of squared deviations from the mean
+	double min, max;
+} stat_stream_t;
+
+/** KLL quantile sketch: a hierarchy of compactors, where level h keeps items
+ * with weight 2^h. When a level is full, it is sorted and every other item is
+ * promoted to the next level, starting at a random offset. Sketches with the 
+ * same k may be merged, such as partial sketches built by different threads.
+ */
+typedef struct {
+	int k;
+	int num_levels;
+	double **level;  // Items in each level
+	int *size;       // Number of items in each level
+	int *capacity;   // Allocated items in each level
+	double n;        // Number of values added
+	double min, max;
+	unsigned int seed;
+} stat_kll_t;
+
+/** Counts of values in logarithmic bins, where bin i is 
+ * [xmin * 10^(i/bins_per_decade), xmin * 10^((i+1)/bins_per_decade)). 
+ * Counters with the same xmin and bins_per_decade may be merged.
+ */
+typedef struct {
+	double xmin;
+	int bins_per_decade;
+	int num_bins;
+	double *count;
+	double n;         // Number of values added, including those below xmin
+} stat_log_bins_t;
+
+/** Sufficient statistics for the maximum-likelihood exponent alpha of a
+ * power-law p(x) ~ x^-alpha for x >= xmin. Discrete values use the 
+ * approximation of Clauset, Shalizi and Newman (2009).
+ */
+typedef struct {
+	double xmin;
+	bool is_discrete;
+	double n;        // Number of values at least xmin
+	double sum_log;  // Sum of log(x/xmin), or log(x/(xmin-0.5)) if discrete
+} stat_power_law_t;
+
+/********************************* Functions **********************************/
+
 int my_rand_r(unsigned int *seedp);
 int uniform(int n, unsigned int *seedp);
 
@@ -26,9 +104,10 @@ double stat_int_average(const int *v, int n);
 double stat_int_variance(const int *v, int n);
 double stat_int_entropy(const int *v, int n);
 
-double stat_int_dist_average(const int *v, int n);
-double stat_int_dist_sum(const int *v, int n);
-double stat_int_dist_harmonic_sum(const int *v, int n);
+// Distributions where v[i] counts occurrences of value i, with 64-bit counts.
+double stat_int_dist_average(const int64_t *v, int n);
+double stat_int_dist_sum(const int64_t *v, int n);
+double stat_int_dist_harmonic_sum(const int64_t *v, int n);
 
 double stat_double_sum(const double *v, int n);
 double stat_double_average(const double *v, int n);
@@ -37,9 +116,56 @@ double stat_double_variance(const double *v, int n);
 void stat_double_normalization(double *v, int n);
 
 int *stat_sort_copy(const int *v, int n);
+// Returns the distinct values in v and their counts, in increasing order.
 pair_t *stat_frequencies(const int *v, int n, int *num_keys);
+// Counts values in num_bins bins of equal width from the minimum to the 
+//maximum value, which is included in the last bin.
 interval_t *stat_histogram(const double *v, int n, int num_bins);
+// Counts positive values in num_bins bins of equal width in logarithmic
+//scale, from the minimum to the maximum positive value. Returns NULL if
+//there are no positive values.
+interval_t *stat_log_histogram(const double *v, int n, int num_bins);
+
+// Streaming moments, with Welford's update for single values and blocks
+//of STAT_BLOCK_SIZE for arrays.
+void stat_stream_init(stat_stream_t *s);
+void stat_stream_push(stat_stream_t *s, double x);
+void stat_stream_push_array(stat_stream_t *s, const double *v, int n);
+void stat_stream_merge(stat_stream_t *s, const stat_stream_t *other);
+double stat_stream_variance(const stat_stream_t *s);
+
+// Quantile sketches. new_stat_kll returns NULL if there is no memory.
+stat_kll_t *new_stat_kll(int k, unsigned int seed);
+void delete_stat_kll(stat_kll_t *s);
+error_t stat_kll_push(stat_kll_t *s, double x);
+error_t stat_kll_push_array(stat_kll_t *s, const double *v, int n);
+error_t stat_kll_merge(stat_kll_t *s, const stat_kll_t *other);
+// Returns an approximate q-quantile, with 0 <= q <= 1, or NaN if empty.
+double stat_kll_quantile(const stat_kll_t *s, double q);
+// Returns the approximate fraction of values less or equal than x.
+double stat_kll_rank(const stat_kll_t *s, double x);
+
+// Logarithmic bins. Values below xmin are only counted in n.
+void stat_log_bins_init(stat_log_bins_t *b, double xmin, int bins_per_decade);
+void stat_log_bins_free(stat_log_bins_t *b);
+error_t stat_log_bins_push(stat_log_bins_t *b, double x);
+error_t stat_log_bins_merge(stat_log_bins_t *b, const stat_log_bins_t *other);
+// Lower edge of bin i
+double stat_log_bins_edge(const stat_log_bins_t *b, int i);
+// Probability density of bin i, that is, count/(n * width)
+double stat_log_bins_density(const stat_log_bins_t *b, int i);
+
+// Power-law exponent estimation
+void stat_power_law_init(stat_power_law_t *p, double xmin, bool is_discrete);
+void stat_power_law_push(stat_power_law_t *p, double x);
+void stat_power_law_merge(stat_power_law_t *p, const stat_power_law_t *other);
+// Returns the estimated exponent, and its standard error in error if given.
+double stat_power_law_alpha(const stat_power_law_t *p, double *error);
 
 double stat_pearson(const double *x, const double *y, int n);
+// Fills r with the Pearson correlation of each pair of the num_var arrays in 
+//v, with n values each, in a single pass. r has dimension num_var*num_var.
+error_t stat_correlation_matrix
+	(const double * const *v, int num_var, int n, double *r);
 
 #endif
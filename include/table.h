@@ -0,0 +1,44 @@
+#ifndef _TABLE_H
+#define _TABLE_H
+
+#include "error.h"
+
+/********************************* Constants **********************************/
+
+/* Files start with this magic string, followed by a byte-order mark that is
+ * the integer 1 in the byte order of the machine that wrote the file. */
+#ifndef TABLE_MAGIC
+ #define TABLE_MAGIC "CGTB"
+#endif
+
+/*********************************** Types ************************************/
+typedef enum {TABLE_INT, TABLE_DOUBLE, TABLE_NUM_TYPE} table_type_t;
+
+/** Column of a table, with num_row values of type int or double. */
+typedef struct {
+	char *name;
+	table_type_t type;
+	void *data;
+} table_column_t;
+
+/********************************* Functions **********************************/
+
+/* Writes columns in a binary columnar format: a header with the number of
+ * columns and rows and the type and name of each column, followed by the data
+ * of each column stored contiguously. Data is not copied, so it's read directly
+ * from the arrays given in column. */
+error_t table_write
+	(const char *filename, const table_column_t *column, int num_column,
+	 int num_row);
+
+/* Reads a table written by table_write, allocating names and data of all
+ * columns. Returns NULL if the file can't be read or was written by a machine
+ * with different byte order. */
+table_column_t *table_read
+	(const char *filename, int *num_column, int *num_row);
+void delete_table_columns(table_column_t *column, int num_column);
+
+// Size in bytes of a value of type.
+int table_type_size(table_type_t type);
+
+#endif
@@ -5,5 +5,10 @@ framerate=$2
 size=$3
 output=$4
 
-ls $folder/*.svg | parallel --gnu convert {} -depth 8 -resize ${size}x${size} {.}.png
-avconv -f image2 -r $framerate -i $folder/frame%03d.png -r $framerate -qscale 10 -pix_fmt yuv420p $output
+# Frames from graph_animate_propagation_raster are already PNG images
+if ls $folder/frame*.png > /dev/null 2>&1; then
+	echo "Using PNG frames in $folder"
+elif ls $folder/*.svg > /dev/null 2>&1; then
+	ls $folder/*.svg | parallel --gnu convert {} -depth 8 -resize ${size}x${size} {.}.png
+fi
+avconv -f image2 -r $framerate -i $folder/frame%05d.png -r $framerate -qscale 10 -pix_fmt yuv420p $output
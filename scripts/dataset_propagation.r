@@ -1,13 +1,15 @@
 #!/usr/bin/Rscript
 
+source("scripts/read_table.r")
+
 dataset <- commandArgs(trailingOnly=TRUE)
-sir <- read.table(sprintf("test/%s-sir.dat", dataset))
+sir <- read.cgraph.table(sprintf("test/%s-sir.bin", dataset))
 
-time_avg <- mean(sir$V1)
-time_stddev <- sd(sir$V1)
+time_avg <- mean(sir$num_step)
+time_stddev <- sd(sir$num_step)
 
-n <- sir[1,3] + sir[1,5] # Number of vertices
-s_avg <- mean(sir$V3)/n
-s_stddev <- sd(sir$V3)/n
+n <- sir$state_0[1] + sir$state_2[1] # Number of vertices
+s_avg <- mean(sir$state_0)/n
+s_stddev <- sd(sir$state_0)/n
 
 cat(sprintf("%*s & %d & $%.2f \\pm %.1f$ & $%.2f \\pm %.1f$ \\\\\n", 12, dataset, as.integer(n), time_avg, time_stddev, 100*s_avg, 100*s_stddev))
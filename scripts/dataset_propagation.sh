@@ -4,7 +4,7 @@ datasets="mac95 cat mangwet mangdry baywet baydry netscience email facebook powe
 
 for dataset in $datasets
 do
-	bin/propagation -d datasets/$dataset -p SIR 1.0 0.5 -r 50 -o test/$dataset-sir.dat &
+	bin/propagation -d datasets/$dataset -p SIR 1.0 0.5 -r 50 -o test/$dataset-sir.bin -b &
 done
 wait
 
@@ -0,0 +1,33 @@
+# Reads a table written by table_write (include/table.h) into a data frame.
+# Columns are stored contiguously, so each one is read with a single readBin.
+read.cgraph.table <- function(filename) {
+	con <- file(filename, "rb")
+	on.exit(close(con))
+
+	if (readChar(con, 4, useBytes=TRUE) != "CGTB") {
+		stop(sprintf("%s is not a cgraph table", filename))
+	}
+	endian <- "little"
+	if (readBin(con, "integer", size=4, endian=endian) != 1) {
+		endian <- "big"
+	}
+	read.int <- function(n=1) readBin(con, "integer", n=n, size=4, endian=endian)
+
+	num_column <- read.int()
+	num_row <- read.int()
+	type <- integer(num_column)
+	name <- character(num_column)
+	for (i in seq_len(num_column)) {
+		type[i] <- read.int()
+		length <- read.int()
+		name[i] <- if (length > 0) readChar(con, length, useBytes=TRUE) else ""
+	}
+
+	column <- vector("list", num_column)
+	for (i in seq_len(num_column)) {
+		column[[i]] <- if (type[i] == 0) read.int(num_row) else
+			readBin(con, "double", n=num_row, size=8, endian=endian)
+	}
+	names(column) <- name
+	as.data.frame(column, check.names=FALSE)
+}
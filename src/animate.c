@@ -0,0 +1,64 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "graph.h"
+#include "graph_layout.h"
+#include "graph_raster.h"
+#include "graph_propagation.h"
+
+void print_usage(){
+	printf(
+		"Usage: animate <file> <folder> [(svg|ppm|png) [<size> [<frames>]]]\n"
+		"\n"
+		"Expands an animation file saved by graph_save_propagation into frames\n"
+		"in an existing folder. Raster frames have size x size pixels, or one\n"
+		"pixel per coordinate unit if size is 0 (default). If frames is given,\n"
+		"only that number of evenly spaced steps is printed.\n");
+}
+
+int main(int argc, const char *argv[]){
+	if (argc < 3){
+		print_usage();
+		return 0;
+	}
+
+	const char *filename = argv[1];
+	const char *folder = argv[2];
+	const char *format = argc > 3 ? argv[3] : "svg";
+	int size = argc > 4 ? atoi(argv[4]) : 0;
+	int steps = argc > 5 ? atoi(argv[5]) : 0;
+
+	if (strcmp(format, "svg") && strcmp(format, "ppm") && strcmp(format, "png")){
+		fprintf(stderr, "Invalid format: %s\n", format);
+		return 1;
+	}
+	if (size < 0 || steps < 0){
+		fprintf(stderr, "Size and number of frames can't be negative\n");
+		return 1;
+	}
+
+	graph_t *g;
+	coord_t *p;
+	int num_state, num_step;
+	propagation_step_t *step =
+		graph_load_propagation(filename, &g, &p, &num_state, &num_step);
+	if (!step){
+		return 1;
+	}
+
+	error_t error;
+	if (!strcmp(format, "svg")){
+		error = graph_animate_propagation_steps
+			(folder, g, p, num_state, step, num_step, steps);
+	} else {
+		error = graph_animate_propagation_raster
+			(folder, g, p, num_state, step, num_step, steps, size,
+			 !strcmp(format, "png") ? GRAPH_RASTER_PNG : GRAPH_RASTER_PPM);
+	}
+
+	delete_propagation_steps(step, num_step);
+	free(p);
+	delete_graph(g);
+	return error ? 1 : 0;
+}
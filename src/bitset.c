@@ -0,0 +1,318 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#ifdef __AVX2__
+ #include <immintrin.h>
+#endif
+
+#include "error.h"
+#include "set.h"
+#include "list.h"
+#include "bitset.h"
+
+#define BITSET_WORD_BITS 64
+
+struct bitset_t {
+	int n;
+	int num_words;
+	uint64_t *word;   // Bits after n in the last word are always zero
+};
+
+// Index of v's word and mask of v's bit in it.
+#define BITSET_WORD(v) ((v) / BITSET_WORD_BITS)
+#define BITSET_MASK(v) ((uint64_t)1 << ((v) % BITSET_WORD_BITS))
+
+/**** Allocation and deallocation ****/
+
+bitset_t *new_bitset(int n){
+	if (n < 0){ return NULL; }
+	bitset_t *bitset = malloc(sizeof(*bitset));
+	if (!bitset){ return NULL; }
+
+	bitset->n = n;
+	bitset->num_words = (n + BITSET_WORD_BITS - 1) / BITSET_WORD_BITS;
+	// One spare word, so that even empty bitsets have an array
+	bitset->word = calloc(bitset->num_words + 1, sizeof(*bitset->word));
+	if (!bitset->word){ free(bitset); return NULL; }
+
+	return bitset;
+}
+
+void delete_bitset(bitset_t *bitset){
+	assert(bitset);
+	free(bitset->word);
+	free(bitset);
+}
+
+/**** Insertion and retrieval ****/
+
+void bitset_add(bitset_t *bitset, int v){
+	assert(bitset);
+	assert(v >= 0 && v < bitset->n);
+	bitset->word[BITSET_WORD(v)] |= BITSET_MASK(v);
+}
+
+bool bitset_contains(const bitset_t *bitset, int v){
+	assert(bitset);
+	assert(v >= 0 && v < bitset->n);
+	return (bitset->word[BITSET_WORD(v)] & BITSET_MASK(v)) != 0;
+}
+
+bool bitset_remove(bitset_t *bitset, int v){
+	assert(bitset);
+	assert(v >= 0 && v < bitset->n);
+	uint64_t *word = &bitset->word[BITSET_WORD(v)];
+	bool is_member = (*word & BITSET_MASK(v)) != 0;
+	*word &= ~BITSET_MASK(v);
+	return is_member;
+}
+
+void bitset_clean(bitset_t *bitset){
+	assert(bitset);
+	memset(bitset->word, 0, bitset->num_words * sizeof(*bitset->word));
+}
+
+void bitset_fill(bitset_t *bitset){
+	assert(bitset);
+	memset(bitset->word, 0xFF, bitset->num_words * sizeof(*bitset->word));
+	if (bitset->n % BITSET_WORD_BITS != 0){
+		bitset->word[bitset->num_words-1] = BITSET_MASK(bitset->n) - 1;
+	}
+}
+
+/**** Set operations ****/
+/* Operations are done 4 words at a time with AVX2, and the remaining words
+ * one at a time. */
+
+void bitset_union(bitset_t *dest, const bitset_t *other){
+	assert(dest);
+	assert(other);
+	assert(dest->n == other->n);
+
+	int i = 0, num_words = dest->num_words;
+	uint64_t *a = dest->word;
+	const uint64_t *b = other->word;
+#ifdef __AVX2__
+	for (; i+4 <= num_words; i += 4){
+		__m256i x = _mm256_loadu_si256((const __m256i *)(a + i));
+		__m256i y = _mm256_loadu_si256((const __m256i *)(b + i));
+		_mm256_storeu_si256((__m256i *)(a + i), _mm256_or_si256(x, y));
+	}
+#endif
+	for (; i < num_words; i++){
+		a[i] |= b[i];
+	}
+}
+
+void bitset_difference(bitset_t *dest, const bitset_t *other){
+	assert(dest);
+	assert(other);
+	assert(dest->n == other->n);
+
+	int i = 0, num_words = dest->num_words;
+	uint64_t *a = dest->word;
+	const uint64_t *b = other->word;
+#ifdef __AVX2__
+	for (; i+4 <= num_words; i += 4){
+		__m256i x = _mm256_loadu_si256((const __m256i *)(a + i));
+		__m256i y = _mm256_loadu_si256((const __m256i *)(b + i));
+		_mm256_storeu_si256((__m256i *)(a + i), _mm256_andnot_si256(y, x));
+	}
+#endif
+	for (; i < num_words; i++){
+		a[i] &= ~b[i];
+	}
+}
+
+void bitset_intersection(bitset_t *dest, const bitset_t *other){
+	assert(dest);
+	assert(other);
+	assert(dest->n == other->n);
+
+	int i = 0, num_words = dest->num_words;
+	uint64_t *a = dest->word;
+	const uint64_t *b = other->word;
+#ifdef __AVX2__
+	for (; i+4 <= num_words; i += 4){
+		__m256i x = _mm256_loadu_si256((const __m256i *)(a + i));
+		__m256i y = _mm256_loadu_si256((const __m256i *)(b + i));
+		_mm256_storeu_si256((__m256i *)(a + i), _mm256_and_si256(x, y));
+	}
+#endif
+	for (; i < num_words; i++){
+		a[i] &= b[i];
+	}
+}
+
+/**** Data structure querying ****/
+
+#ifdef __AVX2__
+/* Counts bits of each byte with a 16-entry table lookup for each nibble, and
+ * sums bytes of each 64-bit lane, returning the 4 lane counts. */
+__m256i bitset_popcount256(__m256i x){
+	const __m256i table = _mm256_setr_epi8(
+		0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+		0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+	const __m256i low_mask = _mm256_set1_epi8(0x0F);
+	__m256i low  = _mm256_and_si256(x, low_mask);
+	__m256i high = _mm256_and_si256(_mm256_srli_epi16(x, 4), low_mask);
+	__m256i count = _mm256_add_epi8(_mm256_shuffle_epi8(table, low),
+	                                _mm256_shuffle_epi8(table, high));
+	return _mm256_sad_epu8(count, _mm256_setzero_si256());
+}
+#endif
+
+int bitset_size(const bitset_t *bitset){
+	assert(bitset);
+
+	int i = 0, num_words = bitset->num_words;
+	const uint64_t *a = bitset->word;
+	int64_t size = 0;
+#ifdef __AVX2__
+	__m256i sum = _mm256_setzero_si256();
+	for (; i+4 <= num_words; i += 4){
+		__m256i x = _mm256_loadu_si256((const __m256i *)(a + i));
+		sum = _mm256_add_epi64(sum, bitset_popcount256(x));
+	}
+	int64_t lane[4];
+	_mm256_storeu_si256((__m256i *)lane, sum);
+	size = lane[0] + lane[1] + lane[2] + lane[3];
+#endif
+	for (; i < num_words; i++){
+		size += __builtin_popcountll(a[i]);
+	}
+	return (int)size;
+}
+
+int bitset_capacity(const bitset_t *bitset){
+	assert(bitset);
+	return bitset->n;
+}
+
+bool bitset_is_empty(const bitset_t *bitset){
+	assert(bitset);
+	int i;
+	for (i=0; i < bitset->num_words; i++){
+		if (bitset->word[i]){ return false; }
+	}
+	return true;
+}
+
+bool bitset_equals(const bitset_t *a, const bitset_t *b){
+	assert(a);
+	assert(b);
+	if (a->n != b->n){ return false; }
+	return !memcmp(a->word, b->word, a->num_words * sizeof(*a->word));
+}
+
+int bitset_next(const bitset_t *bitset, int v){
+	assert(bitset);
+	assert(v >= 0);
+	if (v >= bitset->n){ return -1; }
+
+	// Bits before v in its word are discarded, and then whole words skipped
+	int i = BITSET_WORD(v);
+	uint64_t word = bitset->word[i] & ~(BITSET_MASK(v) - 1);
+	while (!word){
+		if (++i >= bitset->num_words){ return -1; }
+		word = bitset->word[i];
+	}
+	return i * BITSET_WORD_BITS + __builtin_ctzll(word);
+}
+
+/**** Printing ****/
+
+void bitset_print(const bitset_t *bitset){
+	bitset_fprint(stdout, bitset);
+}
+
+void bitset_fprint(FILE *stream, const bitset_t *bitset){
+	assert(stream);
+	assert(bitset);
+
+	int v = bitset_next(bitset, 0);
+	fprintf(stream, "{");
+	while (v >= 0){
+		fprintf(stream, "%d", v);
+		v = bitset_next(bitset, v+1);
+		if (v >= 0){ fprintf(stream, ", "); }
+	}
+	fprintf(stream, "}");
+}
+
+/**** Copying and conversion ****/
+
+bitset_t *bitset_copy(const bitset_t *bitset){
+	assert(bitset);
+	bitset_t *copy = new_bitset(bitset->n);
+	if (!copy){ return NULL; }
+	memcpy(copy->word, bitset->word, bitset->num_words * sizeof(*copy->word));
+	return copy;
+}
+
+int bitset_to_array(const bitset_t *bitset, int *arr){
+	assert(bitset);
+	assert(arr);
+
+	int i, k = 0;
+	for (i=0; i < bitset->num_words; i++){
+		uint64_t word = bitset->word[i];
+		while (word){
+			arr[k++] = i * BITSET_WORD_BITS + __builtin_ctzll(word);
+			word &= word - 1; // Clears the lowest bit
+		}
+	}
+	return k;
+}
+
+set_t *bitset_to_set(const bitset_t *bitset){
+	assert(bitset);
+	set_t *set = new_set(bitset_size(bitset));
+	if (!set){ return NULL; }
+
+	int v;
+	for (v = bitset_next(bitset, 0); v >= 0; v = bitset_next(bitset, v+1)){
+		if (set_put(set, v)){ delete_set(set); return NULL; }
+	}
+	return set;
+}
+
+list_t *bitset_to_list(const bitset_t *bitset){
+	assert(bitset);
+	list_t *list = new_list(bitset_size(bitset));
+	if (!list){ return NULL; }
+
+	int v;
+	for (v = bitset_next(bitset, 0); v >= 0; v = bitset_next(bitset, v+1)){
+		if (list_push(list, v)){ delete_list(list); return NULL; }
+	}
+	list_sort(list); // Already sorted, but marks it so for list_find
+	return list;
+}
+
+bitset_t *bitset_from_set(const set_t *set, int n){
+	assert(set);
+	bitset_t *bitset = new_bitset(n);
+	if (!bitset){ return NULL; }
+
+	set_entry_t *p;
+	for (p = set_head(set); p != NULL; p = p->next){
+		bitset_add(bitset, p->key);
+	}
+	return bitset;
+}
+
+bitset_t *bitset_from_list(const list_t *list, int n){
+	assert(list);
+	bitset_t *bitset = new_bitset(n);
+	if (!bitset){ return NULL; }
+
+	int i, k = list_size(list);
+	for (i=0; i < k; i++){
+		bitset_add(bitset, list_get(list, i));
+	}
+	return bitset;
+}
@@ -6,298 +6,437 @@
 #include <stdbool.h>
 #include <string.h>
 
-// Preguica de fazer alocacao dinamica...
-#define MAX_STATE 10
+#include "ode.h"
+#include "graph.h"
+#include "graph_propagation.h"
+#include "graph_mean_field.h"
 
-typedef enum {N, ALFA, BETA, GAMMA} param_order_t;
+typedef enum {N, ALFA, BETA, GAMMA, NUM_PARAM} param_order_t;
 
-typedef void (*deriv)(double *y, double *x, double params[]);
-typedef bool (*stop_pred)(double t, double *x, double params[]);
+/** Parametros e estados sao armazenados em estrutura de vetores: o parametro
+ * k do membro j do ensemble esta em params[k*m + j], e o mesmo vale para os
+ * compartimentos. Assim as derivadas sao lacos simples em j, vetorizaveis.
+ */
+#define PARAM(params, k, m) ((const double *)(params) + (k)*(m))
 
 typedef struct model_t model_t;
 struct model_t {
-	int n_state;    // Numero de compartimentos
+	const char *name;
+	int n_state;          // Numero de compartimentos
 	int infectious_state; // Estado infeccioso
-	deriv f;        // Equacao diferencial
-	stop_pred stop; // Predicado de parada
+	int num_params;       // Numero de parametros, incluindo n
+	ode_deriv_f f;        // Equacao diferencial
+	ode_stop_f stop;      // Predicado de parada
 };
 
 /******************** SI Model ********************/
 
-void si_deriv(double *y, double *x, double params[]){
-    double alfa = params[ALFA];
-    double s = x[0], i = x[1];
-    y[0] = - alfa * s * i;
-    y[1] =   alfa * s * i;
+void si_deriv(double *y, const double *x, int m, const void *params){
+	const double *alfa = PARAM(params, ALFA, m);
+	const double *s = x, *i = x + m;
+	double *ds = y, *di = y + m;
+	int j;
+	for (j=0; j < m; j++){
+		ds[j] = - alfa[j] * s[j] * i[j];
+		di[j] =   alfa[j] * s[j] * i[j];
+	}
 }
 
-bool si_stop(double t, double *x, double params[]){
-	return x[0] < 1.0/params[N];
+bool si_stop(double t, const double *x, int m, int j, const void *params){
+	const double *n = PARAM(params, N, m);
+	return x[j] < 1.0/n[j];
 }
 
-model_t si = {2, 1, si_deriv, si_stop};
+model_t si_model = {"SI", 2, 1, 2, si_deriv, si_stop};
 
 /******************** SIS Model ********************/
 
-void sis_deriv(double *y, double *x, double params[]){
-    double alfa = params[ALFA];
-    double beta = params[BETA];
-    double s = x[0], i = x[1];
-    y[0] = - alfa * s * i + beta * i;
-    y[1] =   alfa * s * i - beta * i;
+void sis_deriv(double *y, const double *x, int m, const void *params){
+	const double *alfa = PARAM(params, ALFA, m);
+	const double *beta = PARAM(params, BETA, m);
+	const double *s = x, *i = x + m;
+	double *ds = y, *di = y + m;
+	int j;
+	for (j=0; j < m; j++){
+		ds[j] = - alfa[j] * s[j] * i[j] + beta[j] * i[j];
+		di[j] =   alfa[j] * s[j] * i[j] - beta[j] * i[j];
+	}
 }
 
-bool sis_stop(double t, double *x, double params[]){
-	double alfa = params[ALFA];
-  double beta = params[BETA];  
-	return fabs(x[0] - beta/alfa) < 1.0/params[N];
+bool sis_stop(double t, const double *x, int m, int j, const void *params){
+	const double *n    = PARAM(params, N, m);
+	const double *alfa = PARAM(params, ALFA, m);
+	const double *beta = PARAM(params, BETA, m);
+	return fabs(x[j] - beta[j]/alfa[j]) < 1.0/n[j];
 }
 
-model_t sis = {2, 1, sis_deriv, sis_stop};
+model_t sis_model = {"SIS", 2, 1, 3, sis_deriv, sis_stop};
 
 /******************** SIR Model ********************/
 
-void sir_deriv(double *y, double *x, double params[]){
-    double alfa = params[ALFA];
-    double beta = params[BETA];
-    double s = x[0], i = x[1];
-    y[0] = - alfa * s * i;
-    y[1] =   alfa * s * i - beta * i;
-    y[2] =                  beta * i;
+void sir_deriv(double *y, const double *x, int m, const void *params){
+	const double *alfa = PARAM(params, ALFA, m);
+	const double *beta = PARAM(params, BETA, m);
+	const double *s = x, *i = x + m;
+	double *ds = y, *di = y + m, *dr = y + 2*m;
+	int j;
+	for (j=0; j < m; j++){
+		ds[j] = - alfa[j] * s[j] * i[j];
+		di[j] =   alfa[j] * s[j] * i[j] - beta[j] * i[j];
+		dr[j] =                           beta[j] * i[j];
+	}
 }
 
-bool sir_stop(double t, double *x, double params[]){
-	return x[1] < 0.5/params[N];
+bool sir_stop(double t, const double *x, int m, int j, const void *params){
+	const double *n = PARAM(params, N, m);
+	return x[m + j] < 0.5/n[j];
 }
 
-model_t sir = {3, 1, sir_deriv, sir_stop};
+model_t sir_model = {"SIR", 3, 1, 3, sir_deriv, sir_stop};
 
 /******************** SEIR Model ********************/
 
-void seir_deriv(double *y, double *x, double params[]){
-		double alfa = params[ALFA];
-    double beta = params[BETA];
-    double gamma = params[GAMMA];
-    double s = x[0], e = x[1], i = x[2];
-    y[0] = - alfa * s * i;
-    y[1] =   alfa * s * i - gamma * e;
-    y[2] =                  gamma * e - beta * i;
-    y[3] =                              beta * i;
+void seir_deriv(double *y, const double *x, int m, const void *params){
+	const double *alfa  = PARAM(params, ALFA, m);
+	const double *beta  = PARAM(params, BETA, m);
+	const double *gamma = PARAM(params, GAMMA, m);
+	const double *s = x, *e = x + m, *i = x + 2*m;
+	double *ds = y, *de = y + m, *di = y + 2*m, *dr = y + 3*m;
+	int j;
+	for (j=0; j < m; j++){
+		ds[j] = - alfa[j] * s[j] * i[j];
+		de[j] =   alfa[j] * s[j] * i[j] - gamma[j] * e[j];
+		di[j] =                           gamma[j] * e[j] - beta[j] * i[j];
+		dr[j] =                                             beta[j] * i[j];
+	}
 }
 
-bool seir_stop(double t, double *x, double params[]){
-	return x[1]+x[2] < 1.0/params[N];
+bool seir_stop(double t, const double *x, int m, int j, const void *params){
+	const double *n = PARAM(params, N, m);
+	return x[m + j] + x[2*m + j] < 1.0/n[j];
 }
 
-model_t seir = {4, 2, seir_deriv, seir_stop};
+model_t seir_model = {"SEIR", 4, 2, 4, seir_deriv, seir_stop};
 
 /**************** Daley-Kendall Model **************/
 
-void dk_deriv(double *y, double *x, double params[]){
-    double alfa = params[ALFA];
-    double beta = params[BETA];
-    double d = x[0], i = x[1], c = x[2];
-    y[0] = - alfa * d * i;
-    y[1] =   alfa * d * i - beta * i * (i + c);
-    y[2] =                  beta * i * (i + c);
+void dk_deriv(double *y, const double *x, int m, const void *params){
+	const double *alfa = PARAM(params, ALFA, m);
+	const double *beta = PARAM(params, BETA, m);
+	const double *d = x, *i = x + m, *c = x + 2*m;
+	double *dd = y, *di = y + m, *dc = y + 2*m;
+	int j;
+	for (j=0; j < m; j++){
+		dd[j] = - alfa[j] * d[j] * i[j];
+		di[j] =   alfa[j] * d[j] * i[j] - beta[j] * i[j] * (i[j] + c[j]);
+		dc[j] =                           beta[j] * i[j] * (i[j] + c[j]);
+	}
 }
 
-bool dk_stop(double t, double *x, double params[]){
-	return x[1] < 1.0/params[N];
+bool dk_stop(double t, const double *x, int m, int j, const void *params){
+	const double *n = PARAM(params, N, m);
+	return x[m + j] < 1.0/n[j];
 }
 
-model_t dk = {3, 1, dk_deriv, dk_stop};
+model_t dk_model = {"DK", 3, 1, 3, dk_deriv, dk_stop};
+
+model_t *models[] = {&si_model, &sis_model, &sir_model, &seir_model, &dk_model};
+#define NUM_MODELS (int)(sizeof(models)/sizeof(models[0]))
 
-/**************** Vector utility **************/
+/**************** Output **************/
 
-void fprint_vec(FILE *fp, double t, double *x, int n){
+// Prints one line per sample time, with all compartments of a single member
+void fprint_sample(double t, const double *x, int n, int m, void *data){
+	FILE *fp = (FILE *)data;
 	if (fp){
 		fprintf(fp, "%lf ", t);
 		int i;
 		for (i=0; i < n; i++){
-			fprintf(fp, "%lf ", x[i]);
+			fprintf(fp, "%lf ", x[i*m]);
 		}
 		fprintf(fp, "\n");
 	}
 }
 
-void copy_vec(double *to, double *from, int n){
-		int i;
-    for (i=0; i < n; i++){
-			to[i] = from[i];
+// Prints parameters, stop time and final compartments of each member
+void fprint_ensemble
+		(FILE *fp, model_t model, const double *params, int m,
+		 const double *t_stop, const double *x_stop){
+	int i, j;
+	for (j=0; j < m; j++){
+		for (i=0; i < model.num_params; i++){
+			fprintf(fp, "%lf ", params[i*m + j]);
+		}
+		fprintf(fp, "%lf ", t_stop[j]);
+		for (i=0; i < model.n_state; i++){
+			fprintf(fp, "%lf ", x_stop[i*m + j]);
 		}
+		fprintf(fp, "\n");
+	}
 }
 
-/**************** Numerical integration **************/
+// Prints the fraction of vertices in each state of a graph approximation
+void fprint_fraction(double t, const double *fraction, int num_state, void *data){
+	FILE *fp = (FILE *)data;
+	fprintf(fp, "%lf ", t);
+	int i;
+	for (i=0; i < num_state; i++){
+		fprintf(fp, "%lf ", fraction[i]);
+	}
+	fprintf(fp, "\n");
+}
+
+/******** Input functions ********/
+
+void print_usage(){
+	printf("Usage: dynamic [-d <dt>] [-T <tmax>] <model> <params> [<file>]\n"
+	       "       dynamic [-d <dt>] [-T <tmax>] -e <model> <grid> [<file>]\n"
+	       "       dynamic [-d <dt>] [-T <tmax>] -g <edges> <approx> <model> <alfa> <beta> [<file>]\n"
+	       "if file is not given, output to stdout\n"
+	       "  -d: interval between printed samples (default 0.01)\n"
+	       "  -T: maximum integration time (default 1e6)\n"
+	       "  -e: integrate all parameter sets in file grid at once, one set\n"
+	       "      per line, printing params, stop time and final state\n"
+	       "  -g: integrate mean-field equations on the graph in file edges,\n"
+	       "      with vertex 0 initially infected. approx is one of HMF, QMF or\n"
+	       "      PAIR, and model is either SIS or SIR\n"
+	       "Available models and mandatory parameters:\n"
+	       "   SI:   <n> <alfa>\n"
+	       "   SIS:  <n> <alfa> <beta>\n"
+	       "   SIR:  <n> <alfa> <beta>\n"
+	       "   SEIR: <n> <alfa> <beta> <gamma>\n"
+	       "   DK:   <n> <alfa> <beta>\n");
+}
 
-void rk2_step(deriv f, double *x_next, double *x, int n, double h, double params[]){
-    int i;
-    double k1[MAX_STATE], y1[MAX_STATE], y2[MAX_STATE];
-    
-    f(&y1[0], x, params);
-    
-    for (i=0; i < n; i++){
-			k1[i] = x[i] + h*y1[i];
+model_t *find_model(const char *model_str){
+	int i;
+	for (i=0; i < NUM_MODELS; i++){
+		if (!strcmp(model_str, models[i]->name)){ return models[i]; }
+	}
+	printf("Unknown model type: %s. Available types are: SI SIS SIR SEIR DK\n",
+	       model_str);
+	return NULL;
+}
+
+// Reads one parameter set per line, returning them in structure-of-arrays
+//layout with NUM_PARAM rows.
+double *read_grid(const char *filename, model_t model, int *_m){
+	FILE *fp = fopen(filename, "rt");
+	if (!fp){
+		fprintf(stderr, "Can't open file %s\n", filename);
+		return NULL;
+	}
+
+	int i, m = 0, size = 16;
+	double *params = NULL;
+	double *rows = malloc(size * NUM_PARAM * sizeof(*rows));
+	if (!rows){ goto failure; }
+
+	while (true){
+		double row[NUM_PARAM] = {0.0, 0.0, 0.0, 0.0};
+		int count = 0;
+		for (i=0; i < model.num_params; i++){
+			count += fscanf(fp, "%lf", &row[i]);
+		}
+		if (count != model.num_params){ break; }
+
+		if (m == size){
+			double *tmp = realloc(rows, 2 * size * NUM_PARAM * sizeof(*rows));
+			if (!tmp){ goto failure; }
+			rows = tmp;
+			size *= 2;
 		}
-    
-    f(&y2[0], &k1[0], params);
-    
-    for (i=0; i < n; i++){
-			x_next[i] = x[i] + h/2 * (y1[i] + y2[i]);
+		memcpy(&rows[m*NUM_PARAM], row, sizeof(row));
+		m++;
+	}
+	fclose(fp);
+	fp = NULL;
+
+	if (m == 0){
+		fprintf(stderr, "No parameter set in file %s\n", filename);
+		free(rows);
+		return NULL;
+	}
+
+	params = malloc(NUM_PARAM * m * sizeof(*params));
+	if (!params){ goto failure; }
+	int j;
+	for (j=0; j < m; j++){
+		for (i=0; i < NUM_PARAM; i++){
+			params[i*m + j] = rows[j*NUM_PARAM + i];
 		}
+	}
+	free(rows);
+
+	*_m = m;
+	return params;
+
+failure:
+	fprintf(stderr, "No memory to read parameters from %s\n", filename);
+	if (fp){ fclose(fp); }
+	free(rows);
+	return NULL;
 }
 
-void rk2(model_t model, double *x0, double params[], FILE *fp, double *_t){
-    int i, n = model.n_state;
-    double x_next[MAX_STATE], x[MAX_STATE];
-		copy_vec(&x[0], x0, n);
-		
-    double h = 1e-3;
-    double t = 0.0;
-    fprint_vec(fp, t, x, n);
-    for (i=0; !model.stop(t, x, params); i++){
-        rk2_step(model.f, &x_next[0], &x[0], n, h, params);
-        copy_vec(&x[0], &x_next[0], n);
-        
-        t = (i+1)*h;
-        fprint_vec(fp, t, x, n);
-    }
-    
-    if (_t) *_t = t;
+graph_mean_field_t find_approximation(const char *approx_str){
+	const char *names[] = {"HMF", "QMF", "PAIR"};
+	int i;
+	for (i=0; i < GRAPH_MEAN_FIELD_NUM_TYPE; i++){
+		if (!strcmp(approx_str, names[i])){ return i; }
+	}
+	printf("Unknown approximation: %s. Available types are: HMF QMF PAIR\n",
+	       approx_str);
+	return GRAPH_MEAN_FIELD_NUM_TYPE;
 }
 
-/******** Input functions ********/
+int graph_main(int argc, char *argv[], double dt, double t_max){
+	if (argc != 5 && argc != 6){ print_usage(); exit(EXIT_SUCCESS); }
 
-void print_usage(){
-	printf("Usage: dynamic <model> <params> [<file>]\n"
-         "if file is not given, output to stdout\n"
-         "Available models and mandatory parameters:\n"
-         "   SI:   <n> <alfa>\n"
-         "   SIS:  <n> <alfa> <beta>\n"
-         "   SIR:  <n> <alfa> <beta>\n"
-         "   SEIR: <n> <alfa> <beta> <gamma>\n"
-         "   DK:   <n> <alfa> <beta>\n");
-}
+	graph_mean_field_t type = find_approximation(argv[1]);
+	bool is_sir = !strcmp(argv[2], "SIR");
+	if (type == GRAPH_MEAN_FIELD_NUM_TYPE || (!is_sir && strcmp(argv[2], "SIS"))){
+		print_usage();
+		exit(EXIT_SUCCESS);
+	}
+	double alfa = atof(argv[3]), beta = atof(argv[4]);
+
+	graph_t *g = load_graph(argv[0], false);
+	if (!g){
+		fprintf(stderr, "Can't read graph from %s\n", argv[0]);
+		exit(EXIT_FAILURE);
+	}
 
-FILE* parse_args(int argc, char *argv[], model_t *model, double params[]){
-	if (argc < 4) return NULL;
-	
-	char *model_str = argv[1];
-	char *n_str     = argv[2];
-	char *alfa_str  = argv[3];
-	FILE *outfile = NULL;
-	
-	if (!strcmp(model_str, "SI"))
+	FILE *outfile = argc == 6 ? fopen(argv[5], "wt") : stdout;
+	if (!outfile){
+		fprintf(stderr, "Can't open file %s\n", argv[5]);
+		exit(EXIT_FAILURE);
+	}
+
+	int n = graph_num_vertices(g);
+	short *state = malloc(n * sizeof(*state));
+	memset(state, 0, n * sizeof(*state));
+
+	double t;
+	if (is_sir)
 	{
-		*model = si;
-		if       (argc == 4) outfile = stdout;
-		else if (argc == 5) outfile = fopen(argv[argc-1], "wt");
-		else return NULL;
-		
-		int n; 
-		sscanf(n_str, "%d", &n); 
-		params[N] = (double)n;
-		
-		sscanf(alfa_str, "%lf", &params[ALFA]);
-	} 
-	else if (!strcmp(model_str, "SIS"))
+		graph_sir_params_t params = {alfa, beta};
+		state[0] = GRAPH_SIR_I;
+		t = graph_mean_field_sir(g, type, params, state, dt, t_max,
+		                         fprint_fraction, outfile, NULL);
+	}
+	else
 	{
-		*model = sis;
-		if       (argc == 5) outfile = stdout;
-		else if (argc == 6) outfile = fopen(argv[argc-1], "wt");
-		else return NULL;
-		
-		char *beta_str = argv[4];
-		
-		int n; 
-		sscanf(n_str, "%d", &n); 
-		params[N] = (double)n;
-		
-		sscanf(alfa_str, "%lf", &params[ALFA]);
-		sscanf(beta_str, "%lf", &params[BETA]);
-	}
-	else if (!strcmp(model_str, "SIR"))
+		graph_sis_params_t params = {alfa, beta};
+		state[0] = GRAPH_SIS_I;
+		t = graph_mean_field_sis(g, type, params, state, dt, t_max,
+		                         fprint_fraction, outfile, NULL);
+	}
+
+	if (t < 0.0){
+		fprintf(stderr, "Integration failed: no memory or step size too small\n");
+	}
+
+	free(state);
+	delete_graph(g);
+	if (outfile != stdout){
+		fclose(outfile);
+	}
+
+	return t < 0.0 ? EXIT_FAILURE : 0;
+}
+
+int main(int argc, char *argv[]){
+	double dt = 0.01, t_max = 1e6;
+	bool is_ensemble = false, is_graph = false;
+
+	int arg = 1;
+	while (arg < argc && argv[arg][0] == '-'){
+		if      (!strcmp(argv[arg], "-d") && arg+1 < argc){ dt = atof(argv[++arg]); }
+		else if (!strcmp(argv[arg], "-T") && arg+1 < argc){ t_max = atof(argv[++arg]); }
+		else if (!strcmp(argv[arg], "-e")){ is_ensemble = true; }
+		else if (!strcmp(argv[arg], "-g")){ is_graph = true; }
+		else { print_usage(); exit(EXIT_SUCCESS); }
+		arg++;
+	}
+
+	if (arg == argc || dt < 0.0 || t_max <= 0.0){
+		print_usage();
+		exit(EXIT_SUCCESS);
+	}
+
+	if (is_graph){
+		return graph_main(argc - arg, argv + arg, dt, t_max);
+	}
+
+	model_t *model = find_model(argv[arg++]);
+	if (!model){ print_usage(); exit(EXIT_SUCCESS); }
+
+	// Parameter sets and number of ensemble members
+	int i, j, m;
+	double *params;
+	if (is_ensemble)
 	{
-		*model = sir;
-		if       (argc == 5) outfile = stdout;
-		else if (argc == 6) outfile = fopen(argv[argc-1], "wt");
-		else return NULL;
-		
-		char *beta_str = argv[4];
-		
-		int n; 
-		sscanf(n_str, "%d", &n); 
-		params[N] = (double)n;
-		
-		sscanf(alfa_str, "%lf", &params[ALFA]);
-		sscanf(beta_str, "%lf", &params[BETA]);
-	}
-	else if (!strcmp(model_str, "SEIR"))
+		if (argc - arg != 1 && argc - arg != 2){ print_usage(); exit(EXIT_SUCCESS); }
+		params = read_grid(argv[arg++], *model, &m);
+		if (!params){ exit(EXIT_FAILURE); }
+	}
+	else
 	{
-		*model = seir;
-		if       (argc == 6) outfile = stdout;
-		else if (argc == 7) outfile = fopen(argv[argc-1], "wt");
-		else return NULL;
-		
-		char *beta_str = argv[4];
-		char *gamma_str = argv[5];
-		
-		int n; 
-		sscanf(n_str, "%d", &n); 
-		params[N] = (double)n;
-		
-		sscanf(alfa_str, "%lf", &params[ALFA]);
-		sscanf(beta_str, "%lf", &params[BETA]);
-		sscanf(gamma_str, "%lf", &params[GAMMA]);
-	}
-	else if (!strcmp(model_str, "DK"))
+		if (argc - arg != model->num_params && argc - arg != model->num_params+1){
+			print_usage();
+			exit(EXIT_SUCCESS);
+		}
+		m = 1;
+		params = malloc(NUM_PARAM * sizeof(*params));
+		memset(params, 0, NUM_PARAM * sizeof(*params));
+		for (i=0; i < model->num_params; i++){
+			sscanf(argv[arg++], "%lf", &params[i]);
+		}
+	}
+
+	FILE *outfile = arg < argc ? fopen(argv[arg], "wt") : stdout;
+	if (!outfile){
+		fprintf(stderr, "Can't open file %s\n", argv[arg]);
+		exit(EXIT_FAILURE);
+	}
+
+	int n_state = model->n_state;
+	double *x = malloc(n_state * m * sizeof(*x));
+	memset(x, 0, n_state * m * sizeof(*x));
+	for (j=0; j < m; j++){
+		int n = params[N*m + j];
+		x[j] = 1 - 1.0/n;
+		x[model->infectious_state*m + j] = 1.0/n;
+	}
+
+	int num_steps;
+	if (is_ensemble)
 	{
-		*model = dk;
-		if       (argc == 5) outfile = stdout;
-		else if (argc == 6) outfile = fopen(argv[argc-1], "wt");
-		else return NULL;
-		
-		char *beta_str = argv[4];
-		
-		int n; 
-		sscanf(n_str, "%d", &n); 
-		params[N] = (double)n;
-		
-		sscanf(alfa_str, "%lf", &params[ALFA]);
-		sscanf(beta_str, "%lf", &params[BETA]);
+		double *t_stop = malloc(m * sizeof(*t_stop));
+		double *x_stop = malloc(n_state * m * sizeof(*x_stop));
+		num_steps = ode_dopri5(model->f, model->stop, params, x, n_state, m,
+		                       dt, t_max, t_stop, x_stop, NULL, NULL);
+		if (num_steps >= 0){
+			fprint_ensemble(outfile, *model, params, m, t_stop, x_stop);
+		}
+		free(t_stop);
+		free(x_stop);
 	}
 	else
 	{
-		printf("Unknown model type: %s. Available types are: SI SIS SIR SEIR DK\n", model_str);
-		return NULL;
-	}	
-	
-	return outfile;
-}
+		num_steps = ode_dopri5(model->f, model->stop, params, x, n_state, m,
+		                       dt, t_max, NULL, NULL, fprint_sample, outfile);
+	}
 
-int main(int argc, char *argv[]){
-		model_t model;
-		double params[MAX_STATE];
-		FILE *outfile = parse_args(argc, argv, &model, &params[0]);
-		
-    if (!outfile){
-				print_usage();
-        exit(EXIT_SUCCESS);
-    }
-    
-    int i, n = params[N];
-    double x[MAX_STATE];
-    for (i=0; i < model.n_state; i++){
-			x[i] = 0.0;
-		}
-    
-    x[0] = 1 - 1.0/n;
-    x[model.infectious_state] = 1.0/n;
-    
-    rk2(model, &x[0], params, outfile, NULL);
-    if (outfile != stdout){
-        fclose(outfile);
-    }
-    
-    return 0;
+	if (num_steps < 0){
+		fprintf(stderr, "Integration failed: no memory or step size too small\n");
+	}
+
+	free(x);
+	free(params);
+	if (outfile != stdout){
+		fclose(outfile);
+	}
+
+	return num_steps < 0 ? EXIT_FAILURE : 0;
 }
@@ -1,71 +1,77 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
 #include <math.h>
 #include <assert.h>
 #include <string.h>	
+#include <pthread.h>
 
 #include "error.h"
 #include "sorting.h"
+#include "stat.h"
 #include "set.h"
 #include "list.h"
 #include "graph.h"
 
+// Edge ids of each adjacency, where the row of vertex i is 
+//entry[offset[i]] ... entry[offset[i+1]-1], sorted by neighbor.
 typedef struct {
-	int from;
-	int to;
-	double weight;
-} edge_t;
+	int key;
+	int64_t id;
+} edge_entry_t;
 
-int comp_edge_asc(const void *p_e1, const void *p_e2){
-	edge_t e1 = *(edge_t *)p_e1;
-	edge_t e2 = *(edge_t *)p_e2;
-	
-	if (e1.from < e2.from){ return -1; }
-	if (e1.from > e2.from){ return +1; }
-	if (e1.to   < e2.to)  { return -1; }
-	if (e1.to   > e2.to)  { return +1; }
-	return 0;
+typedef struct {
+	int64_t *offset;
+	edge_entry_t *entry;
+} edge_index_t;
+
+int comp_edge_entry_asc(const void *p1, const void *p2){
+	const edge_entry_t *a = p1, *b = p2;
+	return (a->key > b->key) - (a->key < b->key);
 }
 
 struct graph_t {
 	bool is_weighted;
 	bool is_directed;
 	
-	int n, m;
+	int n;
+	int64_t m;
 	
+	// Weights are stored as values of the adjacency sets
 	set_t **adjacencies;
+	// In-neighbors of directed graphs, NULL unless built. Kept up to date 
+	//when edges are added or removed.
+	set_t **in_adjacencies;
 	
-	int size_edge;
-	bool is_edges_sorted;
-	edge_t *edge;
+	edge_index_t *edge_index; // Built on demand, NULL if outdated
 };
 
 /****************** Allocation and deallocation ***********************/
 
-graph_t * new_graph(int n, bool is_weighted, bool is_directed){
+// Allocates a graph without edges whose adjacency sets are all NULL.
+graph_t *graph_alloc(int n, bool is_weighted, bool is_directed){
 	if (n < 0) { return NULL; }
 	graph_t *graph = malloc (sizeof(*graph));
+	if (!graph){ return NULL; }
 	graph->n = n;
 	
 	graph->m = 0;
-	graph->is_edges_sorted = false;
-	
 	graph->is_weighted = is_weighted;
-	if (is_weighted)
-	{
-		graph->size_edge = 4*n;
-		graph->edge = malloc(graph->size_edge * sizeof(*graph->edge));
-	}
-	else 
-	{
-		graph->size_edge = 0;
-		graph->edge = NULL;
-	}
-	
 	graph->is_directed = is_directed;
+	graph->edge_index = NULL;
+	graph->in_adjacencies = NULL;
+	
+	graph->adjacencies = calloc(n, sizeof(*graph->adjacencies));
+	if (!graph->adjacencies && n > 0){ free(graph); return NULL; }
+	return graph;
+}
+
+graph_t * new_graph(int n, bool is_weighted, bool is_directed){
+	graph_t *graph = graph_alloc(n, is_weighted, is_directed);
+	if (!graph){ return NULL; }
 	
-	graph->adjacencies = malloc(n * sizeof(*graph->adjacencies));
 	int i;
 	for (i=0; i < n; i++){
 		graph->adjacencies[i] = new_set(0);
@@ -74,15 +80,35 @@ graph_t * new_graph(int n, bool is_weighted, bool is_directed){
 	return graph;
 }
 
+void graph_clear_edge_index(graph_t *graph){
+	if (graph->edge_index){
+		free(graph->edge_index->offset);
+		free(graph->edge_index->entry);
+		free(graph->edge_index);
+		graph->edge_index = NULL;
+	}
+}
+
+void graph_delete_in_adjacency(graph_t *g){
+	assert(g);
+	if (!g->in_adjacencies){ return; }
+	
+	int i;
+	for (i=0; i < g->n; i++){
+		if (g->in_adjacencies[i]){ delete_set(g->in_adjacencies[i]); }
+	}
+	free(g->in_adjacencies);
+	g->in_adjacencies = NULL;
+}
+
 void delete_graph(graph_t *graph){
 	assert(graph);
-	if (graph->is_weighted){
-		free(graph->edge);
-	}
+	graph_clear_edge_index(graph);
+	graph_delete_in_adjacency(graph);
 	
 	int i;
 	for (i=0; i < graph->n; i++){
-		delete_set(graph->adjacencies[i]);
+		if (graph->adjacencies[i]){ delete_set(graph->adjacencies[i]); }
 	}
 	free(graph->adjacencies);
 	free(graph);
@@ -95,7 +121,19 @@ void graph_check(const graph_t *g, int i, int j){
 }
 
 /**************************  Insertion ********************************/
-error_t graph_add_edge(graph_t *g, int i, int j){
+// Puts j in the adjacencies of i, with weight w if the graph is weighted.
+error_t graph_put_adjacent(graph_t *g, int i, int j, double w){
+	if (g->is_weighted){ return set_put_value(g->adjacencies[i], j, w); }
+	else               { return set_put(g->adjacencies[i], j); }
+}
+
+// Puts i in the in-adjacencies of j, with weight w if the graph is weighted.
+error_t graph_put_in_adjacent(graph_t *g, int j, int i, double w){
+	if (g->is_weighted){ return set_put_value(g->in_adjacencies[j], i, w); }
+	else               { return set_put(g->in_adjacencies[j], i); }
+}
+
+error_t graph_add_weighted_edge(graph_t *g, int i, int j, double w){
 	graph_check(g, i, j);
 	
 	if (!set_contains(g->adjacencies[i], j) && i != j){
@@ -103,14 +141,16 @@ error_t graph_add_edge(graph_t *g, int i, int j){
 		
 		if (g->is_directed)
 		{
-			error_ij = set_put(g->adjacencies[i], j);
+			error_ij = graph_put_adjacent(g, i, j, w);
+			if (g->in_adjacencies){ error_ji = graph_put_in_adjacent(g, j, i, w); }
 		}
 		else
 		{
-			error_ij = set_put(g->adjacencies[i], j);
-			error_ji = set_put(g->adjacencies[j], i);
+			error_ij = graph_put_adjacent(g, i, j, w);
+			error_ji = graph_put_adjacent(g, j, i, w);
 		}
 		g->m++;
+		graph_clear_edge_index(g);
 		
 		if (error_ij || error_ji){
 			if (error_ij == ERROR_NO_MEMORY || error_ji == ERROR_NO_MEMORY)
@@ -122,49 +162,161 @@ error_t graph_add_edge(graph_t *g, int i, int j){
 	return ERROR_SUCCESS;
 }
 
-error_t graph_edge_realloc(graph_t *graph){
-	if (graph->m == graph->size_edge){
-		int s = graph->size_edge;
-		edge_t *new_arr = realloc(graph->edge, 2*s*sizeof(*graph->edge));
-		if (!new_arr){ return ERROR_NO_MEMORY; }
-		
-		graph->edge      = new_arr;
-		graph->size_edge = 2*s;
+error_t graph_add_edge(graph_t *g, int i, int j){
+	return graph_add_weighted_edge(g, i, j, 1.0);
+}
+
+typedef struct {
+	graph_t *graph;
+	const uint64_t *key;
+	const double *weight;
+	const int64_t *offset;
+	int first, last;
+} graph_build_task_params_t;
+
+// Builds rows first ... last-1 from the sorted keys, each with a single 
+//allocation. Returns NULL if there is no memory, and the params otherwise.
+void *graph_build_task(void *args){
+	graph_build_task_params_t *params = args;
+	graph_t *g = params->graph;
+	const int64_t *offset = params->offset;
+	
+	int i;
+	int64_t e;
+	for (i=params->first; i < params->last; i++){
+		set_t *row = new_set(offset[i+1] - offset[i]);
+		if (!row){ return NULL; }
+		g->adjacencies[i] = row;
+		for (e=offset[i]; e < offset[i+1]; e++){
+			int j = (int)(uint32_t)params->key[e];
+			double w = params->weight ? params->weight[e] : 1.0;
+			if (graph_put_adjacent(g, i, j, w)){ return NULL; }
+		}
+		set_optimize(row);
 	}
-	return ERROR_SUCCESS;
+	return params;
 }
 
-error_t graph_add_weighted_edge (graph_t *g, int i, int j, double w){
-	graph_check(g, i, j);
-	assert(g->is_weighted);
+graph_t *new_graph_from_edges
+		(int n, const int *edges, const double *weight, int64_t m, 
+		 bool is_weighted, bool is_directed, int num_processors){
+	assert(edges || m == 0);
+	assert(m >= 0);
+	
+	graph_t *g = graph_alloc(n, is_weighted, is_directed);
+	if (!g){ return NULL; }
+	
+	// Each adjacency is a key i << 32 | j, in both directions if undirected
+	int64_t e, k = 0, size = is_directed ? m : 2*m;
+	uint64_t *key = malloc(size * sizeof(*key));
+	double *w = is_weighted ? malloc(size * sizeof(*w)) : NULL;
+	int64_t *offset = calloc(n+1, sizeof(*offset));
+	pthread_t *thread = NULL;
+	graph_build_task_params_t *params = NULL;
+	if ((!key && size > 0) || (is_weighted && !w && size > 0) || !offset){ 
+		goto failure; 
+	}
 	
-	if (!graph_is_adjacent(g, i, j)){
-		error_t error = graph_add_edge(g, i, j);
-		if (error) return error;
-		
-		g->is_edges_sorted = false;
-		
-		//The key must have i < j
-		int min = i < j ? i : j;
-		int max = i < j ? j : i;
-		edge_t edge = {min, max, w};
-		
-		g->edge[g->m-1] = edge;
-		
-		error = graph_edge_realloc(g);
-		if (error) return error;
+	for (e=0; e < m; e++){
+		int i = edges[2*e], j = edges[2*e+1];
+		graph_check(g, i, j);
+		if (i == j){ continue; }
+		double w_e = weight ? weight[e] : 1.0;
+		key[k] = (uint64_t)i << 32 | (uint32_t)j;
+		if (w){ w[k] = w_e; }
+		k++;
+		if (!is_directed){
+			key[k] = (uint64_t)j << 32 | (uint32_t)i;
+			if (w){ w[k] = w_e; }
+			k++;
+		}
 	}
-	return ERROR_SUCCESS;
+	
+	// Sorting is stable, so the first of repeated edges is kept
+	if (radix_sort_keys(key, w, k, num_processors)){ goto failure; }
+	int64_t num_unique = 0;
+	for (e=0; e < k; e++){
+		if (e > 0 && key[e] == key[e-1]){ continue; }
+		key[num_unique] = key[e];
+		if (w){ w[num_unique] = w[e]; }
+		offset[(key[e] >> 32) + 1]++;
+		num_unique++;
+	}
+	int i;
+	for (i=0; i < n; i++){
+		offset[i+1] += offset[i];
+	}
+	g->m = is_directed ? num_unique : num_unique/2;
+	
+	if (num_processors > n/GRAPH_MIN_TASK){ num_processors = n/GRAPH_MIN_TASK; }
+	if (num_processors < 1){ num_processors = 1; }
+	thread = malloc(num_processors * sizeof(*thread));
+	params = malloc(num_processors * sizeof(*params));
+	bool *is_running = malloc(num_processors * sizeof(*is_running));
+	if (!thread || !params || !is_running){ free(is_running); goto failure; }
+	
+	for (i=0; i < num_processors; i++){
+		params[i].graph = g;
+		params[i].key = key;
+		params[i].weight = w;
+		params[i].offset = offset;
+		params[i].first = (int)((long)i * n / num_processors);
+		params[i].last  = (int)((long)(i+1) * n / num_processors);
+	}
+	
+	// Thread 0 is the caller; ranges of threads that fail are run by it
+	bool is_failure = false;
+	is_running[0] = false;
+	for (i=1; i < num_processors; i++){
+		is_running[i] = 
+			pthread_create(&thread[i], NULL, graph_build_task, &params[i]) == 0;
+	}
+	for (i=0; i < num_processors; i++){
+		if (!is_running[i] && !graph_build_task(&params[i])){ 
+			is_failure = true;
+		}
+	}
+	for (i=1; i < num_processors; i++){
+		void *result;
+		if (is_running[i]){
+			pthread_join(thread[i], &result);
+			if (!result){ is_failure = true; }
+		}
+	}
+	free(is_running);
+	if (is_failure){ goto failure; }
+	
+	free(key);
+	free(w);
+	free(offset);
+	free(thread);
+	free(params);
+	return g;
+	
+failure:
+	free(key);
+	free(w);
+	free(offset);
+	free(thread);
+	free(params);
+	delete_graph(g);
+	return NULL;
 }
 
-void graph_sort_edges(graph_t *g){
-	assert(g);
-	assert(g->is_weighted);
+/**************************  Removal *********************************/
+bool graph_remove_edge(graph_t *g, int i, int j){
+	graph_check(g, i, j);
 	
-	if (!g->is_edges_sorted){
-		g->is_edges_sorted = true;
-		qsort(g->edge, g->m, sizeof(*g->edge), comp_edge_asc);
+	if (!set_remove(g->adjacencies[i], j)){ return false; }
+	if (!g->is_directed){
+		set_remove(g->adjacencies[j], i);
+	} else if (g->in_adjacencies){
+		set_remove(g->in_adjacencies[j], i);
 	}
+	
+	g->m--;
+	graph_clear_edge_index(g);
+	return true;
 }
 
 graph_t * load_graph(char *file_name, bool is_directed){
@@ -178,26 +330,29 @@ graph_t * load_graph(char *file_name, bool is_directed){
 	fscanf(fp, "G%d", &version);
 	if (version != 1){ 
 		fprintf(stderr, "Bad version in file %s\n", file_name); 
+		fclose(fp);
 		return NULL;
 	}
 	
 	bool is_weighted;
 	char is_weighted_str[16];
-	fscanf(fp, "%16s", is_weighted_str);
+	fscanf(fp, "%15s", is_weighted_str);
 	if (!strncmp(is_weighted_str, "weighted", 16))       { is_weighted = true; }
 	else if (!strncmp(is_weighted_str, "unweighted", 16)){ is_weighted = false; }
 	else {
 		fprintf(stderr, "Bad weighted string in file %s: %*s\n", file_name, 
 		                16, is_weighted_str); 
+		fclose(fp);
 		return NULL;
 	}
 	
-	int size = 4;
+	size_t size = 4;
 	int *data = malloc(2 * size * sizeof(*data));
 	double *w = is_weighted ? malloc(size * sizeof(*w)) : NULL;
 	
 	// Count number of lines
-	int n = -1, m;
+	int n = -1;
+	int64_t m;
 	for (m=0; !feof(fp); m++){
 		if (m == size){
 			data = realloc(data, 2 * (2*size) * sizeof(*data));
@@ -206,7 +361,6 @@ graph_t * load_graph(char *file_name, bool is_directed){
 		}
 		
 		int from, to;
-		double weight = 1.0;
 		
 		int count_items = fscanf(fp, "%d %d", &from, &to);
 		if (is_weighted){
@@ -214,53 +368,26 @@ graph_t * load_graph(char *file_name, bool is_directed){
 		}
 		
 		if (count_items != (is_weighted ? 3 : 2)){
-			fprintf(stderr, "Bad file %s, stopping in edge %d\n", file_name, m); 
+			fprintf(stderr, "Bad file %s, stopping in edge %" PRId64 "\n", file_name, m); 
 			break;
 		}
 		
 		data[2*m + 0] = from-1;
 		data[2*m + 1] = to-1;
-		if (is_weighted){ w[m] = weight; }
 		
 		if (n < from){ n = from; }
 		if (n < to)  { n = to; }
 	}
 	fclose(fp);
 	
-	graph_t *graph = new_graph(n, is_weighted, is_directed);
+	graph_t *graph = new_graph_from_edges(n, data, w, m, is_weighted, is_directed, 1);
+	free(data);
+	free(w);
 	if (!graph){ 
-		fprintf(stderr, "No memory for %s\n", file_name); free(data);
+		fprintf(stderr, "No memory for %s\n", file_name);
 		return NULL;
 	}
 	
-	int i;
-	for (i=0; i < m; i++){
-		int error;
-		
-		if (is_weighted)
-		{
-			error = graph_add_weighted_edge(graph, data[2*i+0], data[2*i+1], w[i]);
-		}
-		else
-		{
-			error = graph_add_edge(graph, data[2*i+0], data[2*i+1]);
-		}
-		if (error){
-			fprintf(stderr, "No memory for %s\n", file_name);
-			delete_graph(graph); free(data); return NULL;
-		}
-	}
-	free(data);
-	
-	if (is_weighted){
-		graph_sort_edges(graph);
-		free(w); 
-	}
-	
-	for (i=0; i < n; i++){
-		set_optimize(graph->adjacencies[i]);
-	}
-	
 	return graph;
 }
 
@@ -269,7 +396,7 @@ int graph_num_vertices(const graph_t *g){
 	return g->n;
 }
 
-int graph_num_edges(const graph_t *g){
+int64_t graph_num_edges(const graph_t *g){
 	assert(g);
 	return g->m;
 }
@@ -306,6 +433,30 @@ set_entry_t *graph_adjacent_head(const graph_t *g, int i){
 	return set_head(g->adjacencies[i]);
 }
 
+double graph_adjacent_weight(const graph_t *g, int i, const set_entry_t *adj){
+	assert(g);
+	assert(i >= 0 && i < g->n);
+	assert(adj);
+	
+	if (!g->is_weighted){ return 1.0; }
+	return set_entry_value(g->adjacencies[i], adj);
+}
+
+int graph_weighted_adjacents(const graph_t *g, int i, int *adj, double *weight){
+	assert(g);
+	assert(i >= 0 && i < g->n);
+	assert(adj);
+	assert(weight);
+	
+	int k = 0;
+	set_entry_t *p;
+	for (p = set_head(g->adjacencies[i]); p != NULL; p = p->next, k++){
+		adj[k] = p->key;
+		weight[k] = graph_adjacent_weight(g, i, p);
+	}
+	return k;
+}
+
 error_t graph_adjacent_set(const graph_t *g, int i, set_t *adj){
 	assert(g);
 	assert(i >= 0 && i < g->n);
@@ -314,6 +465,169 @@ error_t graph_adjacent_set(const graph_t *g, int i, set_t *adj){
 	return set_union(adj, g->adjacencies[i]);
 }
 
+error_t graph_build_in_adjacency(graph_t *g){
+	assert(g);
+	if (!g->is_directed || g->in_adjacencies){ return ERROR_SUCCESS; }
+	
+	int i, n = g->n;
+	int *in_degree = calloc(n, sizeof(*in_degree));
+	g->in_adjacencies = calloc(n, sizeof(*g->in_adjacencies));
+	if (!in_degree || (!g->in_adjacencies && n > 0)){ goto failure; }
+	
+	set_entry_t *p;
+	for (i=0; i < n; i++){
+		for (p = set_head(g->adjacencies[i]); p; p = p->next){
+			in_degree[p->key]++;
+		}
+	}
+	for (i=0; i < n; i++){
+		g->in_adjacencies[i] = new_set(in_degree[i]);
+		if (!g->in_adjacencies[i]){ goto failure; }
+	}
+	for (i=0; i < n; i++){
+		for (p = set_head(g->adjacencies[i]); p; p = p->next){
+			double w = graph_adjacent_weight(g, i, p);
+			if (graph_put_in_adjacent(g, p->key, i, w)){ goto failure; }
+		}
+	}
+	for (i=0; i < n; i++){
+		set_optimize(g->in_adjacencies[i]);
+	}
+	
+	free(in_degree);
+	return ERROR_SUCCESS;
+	
+failure:
+	free(in_degree);
+	graph_delete_in_adjacency(g);
+	return ERROR_NO_MEMORY;
+}
+
+bool graph_has_in_adjacency(const graph_t *g){
+	assert(g);
+	return !g->is_directed || g->in_adjacencies;
+}
+
+// In-adjacencies of undirected graphs are the adjacencies themselves.
+const set_t *graph_in_set(const graph_t *g, int i){
+	assert(g);
+	assert(i >= 0 && i < g->n);
+	assert(graph_has_in_adjacency(g));
+	return g->is_directed ? g->in_adjacencies[i] : g->adjacencies[i];
+}
+
+int graph_num_in_adjacents(const graph_t *g, int i){
+	return set_size(graph_in_set(g, i));
+}
+
+int graph_in_adjacents(const graph_t *g, int i, int *adj){
+	assert(adj);
+	const set_t *in = graph_in_set(g, i);
+	set_to_array(in, adj);
+	return set_size(in);
+}
+
+set_entry_t *graph_in_adjacent_head(const graph_t *g, int i){
+	return set_head(graph_in_set(g, i));
+}
+
+double graph_in_adjacent_weight(const graph_t *g, int i, const set_entry_t *adj){
+	assert(adj);
+	const set_t *in = graph_in_set(g, i);
+	if (!g->is_weighted){ return 1.0; }
+	return set_entry_value(in, adj);
+}
+
+error_t graph_csr(const graph_t *g, int64_t **_offset, int **_adj){
+	assert(g);
+	assert(_offset);
+	assert(_adj);
+	
+	int i, n = g->n;
+	int64_t *offset = malloc((n+1) * sizeof(*offset));
+	if (!offset){ return ERROR_NO_MEMORY; }
+	
+	offset[0] = 0;
+	for (i=0; i < n; i++){
+		offset[i+1] = offset[i] + set_size(g->adjacencies[i]);
+	}
+	
+	int *adj = malloc(offset[n] * sizeof(*adj));
+	if (!adj && offset[n] > 0){ free(offset); return ERROR_NO_MEMORY; }
+	
+	for (i=0; i < n; i++){
+		set_to_array(g->adjacencies[i], adj + offset[i]);
+	}
+	
+	*_offset = offset;
+	*_adj = adj;
+	return ERROR_SUCCESS;
+}
+
+error_t graph_build_edge_index(const graph_t *g){
+	assert(g);
+	if (g->edge_index){ return ERROR_SUCCESS; }
+	
+	int i, n = g->n;
+	int64_t e;
+	int64_t *offset;
+	int *adj;
+	error_t error = graph_csr(g, &offset, &adj);
+	if (error){ return error; }
+	
+	edge_index_t *index = malloc(sizeof(*index));
+	edge_entry_t *entry = malloc(offset[n] * sizeof(*entry));
+	if (!index || (!entry && offset[n] > 0)){
+		free(index); free(entry); free(offset); free(adj);
+		return ERROR_NO_MEMORY;
+	}
+	
+	// Ids follow adjacency order, counting (i, v) with i < v if undirected
+	int64_t id = 0;
+	for (i=0; i < n; i++){
+		for (e=offset[i]; e < offset[i+1]; e++){
+			int v = adj[e];
+			entry[e].key = v;
+			entry[e].id = (g->is_directed || i < v) ? id++ : -1;
+		}
+		qsort(entry + offset[i], offset[i+1] - offset[i], sizeof(*entry), 
+		      comp_edge_entry_asc);
+	}
+	
+	// The reverse of an undirected edge has the same id
+	for (i=0; i < n; i++){
+		for (e=offset[i]; e < offset[i+1]; e++){
+			if (entry[e].id < 0){
+				int v = entry[e].key;
+				edge_entry_t key = {i, 0};
+				edge_entry_t *rev = bsearch(&key, entry + offset[v], 
+				                      offset[v+1] - offset[v], sizeof(*entry), 
+				                      comp_edge_entry_asc);
+				assert(rev);
+				entry[e].id = rev->id;
+			}
+		}
+	}
+	free(adj);
+	
+	index->offset = offset;
+	index->entry = entry;
+	((graph_t *)g)->edge_index = index;
+	return ERROR_SUCCESS;
+}
+
+int64_t graph_edge_id(const graph_t *g, int i, int j){
+	graph_check(g, i, j);
+	if (graph_build_edge_index(g)){ return -1; }
+	
+	const edge_index_t *index = g->edge_index;
+	edge_entry_t key = {j, 0};
+	edge_entry_t *p = bsearch(&key, index->entry + index->offset[i], 
+	                    index->offset[i+1] - index->offset[i], 
+	                    sizeof(*index->entry), comp_edge_entry_asc);
+	return p ? p->id : -1;
+}
+
 bool graph_is_adjacent(const graph_t *g, int i, int j){
 	graph_check(g, i, j);
 	
@@ -328,17 +642,7 @@ double graph_get(const graph_t *g, int i, int j){
 	if (!is_adjacent)   { return +1.0/0.0; }
 	if (!g->is_weighted){ return 1.0; }
 	
-	//The key must have i < j
-	int min = i < j ? i : j;
-	int max = i < j ? j : i;
-	edge_t key = {min, max, 0.0};
-	
-	search_f search = g->is_edges_sorted ? bsearch : linsearch;
-	edge_t *result = search((void *)&key, g->edge, g->m, 
-													 sizeof(*g->edge), comp_edge_asc);
-	assert(result);
-	
-	return result->weight;
+	return set_value(g->adjacencies[i], j);
 }
 
 void graph_print(const graph_t *graph){
@@ -375,61 +679,154 @@ graph_t *graph_copy(const graph_t *graph){
 	bool is_weighted = graph_is_weighted(graph);
 	graph_t *copy = new_graph(n, is_weighted, is_directed);
 	if (!copy){ return NULL; }
+	if (graph->in_adjacencies && graph_build_in_adjacency(copy)){
+		delete_graph(copy); 
+		return NULL;
+	}
 	
 	int i;
 	for (i=0; i < n; i++){
 		set_entry_t *adj = graph_adjacent_head(graph, i);
 		for (; adj != NULL; adj = adj->next){
-			if (is_weighted)
-			{
-				double w = graph_get(graph, i, adj->key);
-				error_t error = graph_add_weighted_edge(copy, i, adj->key, w);
-				if (error){ delete_graph(copy); return NULL; }
-			} 
-			else 
-			{
-				error_t error = graph_add_edge(copy, i, adj->key);
-				if (error){ delete_graph(copy); return NULL; }
-			}
+			double w = graph_adjacent_weight(graph, i, adj);
+			error_t error = graph_add_weighted_edge(copy, i, adj->key, w);
+			if (error){ delete_graph(copy); return NULL; }
 		}
 	}
 	
 	return copy;
 }
 
-graph_t *graph_subset(const graph_t *graph, const list_t *vertices){
-	assert(graph);
-	assert(vertices);
+typedef struct {
+	const graph_t *graph;
+	graph_t *sub;
+	const int *vertices, *remap;
+	int first, last;
+	int64_t m;
+} graph_subgraph_task_params_t;
+
+// Builds rows first ... last-1 of the subgraph, each with a single allocation.
+//Returns NULL if there is no memory, and the params otherwise.
+void *graph_subgraph_task(void *args){
+	graph_subgraph_task_params_t *params = args;
+	const graph_t *g = params->graph;
+	graph_t *sub = params->sub;
+	const int *remap = params->remap;
+	
+	params->m = 0;
+	int k;
+	for (k=params->first; k < params->last; k++){
+		int v = params->vertices[k], degree = 0;
+		set_entry_t *adj;
+		for (adj = graph_adjacent_head(g, v); adj != NULL; adj = adj->next){
+			if (remap[adj->key] >= 0){ degree++; }
+		}
+		
+		set_t *row = new_set(degree);
+		if (!row){ return NULL; }
+		sub->adjacencies[k] = row;
+		for (adj = graph_adjacent_head(g, v); adj != NULL; adj = adj->next){
+			int j = remap[adj->key];
+			if (j < 0){ continue; }
+			error_t error = graph_put_adjacent
+				(sub, k, j, graph_adjacent_weight(g, v, adj));
+			if (error){ return NULL; }
+			if (sub->is_directed || k < j){ params->m++; }
+		}
+		set_optimize(row);
+	}
+	return params;
+}
+
+graph_t *graph_induced_subgraph
+		(const graph_t *g, const int *vertices, int n_sub, int *remap, 
+		 int num_processors){
+	assert(g);
+	assert(vertices || n_sub == 0);
+	assert(n_sub >= 0 && n_sub <= g->n);
 	
-	int n_sub = list_size(vertices);
-	bool is_directed = graph_is_directed(graph);
-	bool is_weighted = graph_is_weighted(graph);
+	int i, n = g->n;
+	if (num_processors > n_sub/GRAPH_MIN_TASK){ 
+		num_processors = n_sub/GRAPH_MIN_TASK;
+	}
+	if (num_processors < 1){ num_processors = 1; }
 	
-	graph_t *sub = new_graph(n_sub, is_weighted, is_directed);
-	if (!sub){ return NULL; }
+	int *label = remap ? remap : malloc(n * sizeof(*label));
+	graph_t *sub = graph_alloc(n_sub, g->is_weighted, g->is_directed);
+	pthread_t *thread = malloc(num_processors * sizeof(*thread));
+	graph_subgraph_task_params_t *params 
+		= malloc(num_processors * sizeof(*params));
+	bool *is_running = malloc(num_processors * sizeof(*is_running));
+	if (!label || !sub || !thread || !params || !is_running){ goto failure; }
 	
-	int i, j;
+	for (i=0; i < n; i++){
+		label[i] = -1;
+	}
 	for (i=0; i < n_sub; i++){
-		int origin = list_get(vertices, i);
-		set_entry_t *adj = graph_adjacent_head(graph, origin);
-		for (; adj != NULL; adj = adj->next){
-			int dest = adj->key; 
-			j = list_find(vertices, dest);
-			if (j >= 0){
-				if (is_weighted)
-				{
-					double w = graph_get(graph, origin, dest);
-					error_t error = graph_add_weighted_edge(sub, i, j, w);
-					if (error){ delete_graph(sub); return NULL; }
-				}
-				else
-				{
-					error_t error = graph_add_edge(sub, i, j);
-					if (error){ delete_graph(sub); return NULL; }
-				}
-			}
+		assert(vertices[i] >= 0 && vertices[i] < n);
+		assert(label[vertices[i]] < 0);
+		label[vertices[i]] = i;
+	}
+	
+	for (i=0; i < num_processors; i++){
+		params[i].graph = g;
+		params[i].sub = sub;
+		params[i].vertices = vertices;
+		params[i].remap = label;
+		params[i].first = (int)((long)i * n_sub / num_processors);
+		params[i].last  = (int)((long)(i+1) * n_sub / num_processors);
+	}
+	
+	// Thread 0 is the caller; ranges of threads that fail are run by it
+	bool is_failure = false;
+	is_running[0] = false;
+	for (i=1; i < num_processors; i++){
+		is_running[i] = 
+			pthread_create(&thread[i], NULL, graph_subgraph_task, &params[i]) == 0;
+	}
+	for (i=0; i < num_processors; i++){
+		if (!is_running[i] && !graph_subgraph_task(&params[i])){ 
+			is_failure = true;
 		}
 	}
+	for (i=1; i < num_processors; i++){
+		void *result;
+		if (is_running[i]){
+			pthread_join(thread[i], &result);
+			if (!result){ is_failure = true; }
+		}
+	}
+	if (is_failure){ goto failure; }
+	
+	for (i=0; i < num_processors; i++){
+		sub->m += params[i].m;
+	}
+	
+	if (!remap){ free(label); }
+	free(thread);
+	free(params);
+	free(is_running);
+	return sub;
+	
+failure:
+	if (!remap){ free(label); }
+	if (sub){ delete_graph(sub); }
+	free(thread);
+	free(params);
+	free(is_running);
+	return NULL;
+}
+
+graph_t *graph_subset(const graph_t *graph, const list_t *vertices){
+	assert(graph);
+	assert(vertices);
+	
+	int n_sub;
+	int *array = list_to_dynamic_array(vertices, &n_sub);
+	if (!array && n_sub > 0){ return NULL; }
 	
+	graph_t *sub = graph_induced_subgraph(graph, array, n_sub, NULL,
+		GRAPH_NUM_PROCESSORS);
+	free(array);
 	return sub;
 }
@@ -0,0 +1,366 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "error.h"
+#include "sorting.h"
+#include "graph.h"
+#include "graph_compressed.h"
+
+struct graph_compressed_t {
+	bool is_weighted;
+	bool is_directed;
+
+	int n;
+	int64_t m;
+	int max_degree;
+
+	// List of i is data[offset[i]] ... data[offset[i+1]-1]
+	size_t *offset;
+	unsigned char *data;
+
+	// Weights of i are weight[first[i]] ... weight[first[i+1]-1], if weighted
+	size_t *first;
+	double *weight;
+};
+
+/********************************* Encoding ***********************************/
+
+// Writes x with 7 bits per byte, lowest first, returning the next position.
+unsigned char *graph_varint_encode(unsigned char *p, unsigned int x){
+	while (x >= 0x80){
+		*p++ = (x & 0x7F) | 0x80;
+		x >>= 7;
+	}
+	*p++ = x;
+	return p;
+}
+
+const unsigned char *graph_varint_decode(const unsigned char *p, unsigned int *x){
+	unsigned int value = *p++;
+	if (value >= 0x80){
+		value &= 0x7F;
+		int shift = 7;
+		unsigned int byte;
+		do {
+			byte = *p++;
+			value |= (byte & 0x7F) << shift;
+			shift += 7;
+		} while (byte >= 0x80);
+	}
+	*x = value;
+	return p;
+}
+
+// Maps signed to unsigned integers, so that small magnitudes are small.
+unsigned int graph_zigzag_encode(int x){
+	return ((unsigned int)x << 1) ^ (unsigned int)(x >> 31);
+}
+
+int graph_zigzag_decode(unsigned int x){
+	return (int)(x >> 1) ^ -(int)(x & 1);
+}
+
+typedef struct {
+	int key;
+	double weight;
+} graph_compressed_edge_t;
+
+int comp_compressed_edge_asc(const void *p1, const void *p2){
+	const graph_compressed_edge_t *a = p1, *b = p2;
+	return (a->key > b->key) - (a->key < b->key);
+}
+
+/******************************** Allocation **********************************/
+
+void delete_graph_compressed(graph_compressed_t *cg){
+	assert(cg);
+	free(cg->offset);
+	free(cg->data);
+	free(cg->first);
+	free(cg->weight);
+	free(cg);
+}
+
+graph_compressed_t *new_graph_compressed(const graph_t *g){
+	assert(g);
+	int i, j, n = graph_num_vertices(g);
+
+	graph_compressed_t *cg = calloc(1, sizeof(*cg));
+	if (!cg){ return NULL; }
+	cg->is_weighted = graph_is_weighted(g);
+	cg->is_directed = graph_is_directed(g);
+	cg->n = n;
+	cg->m = graph_num_edges(g);
+
+	size_t num_adjacents = 0;
+	for (i=0; i < n; i++){
+		int k = graph_num_adjacents(g, i);
+		num_adjacents += k;
+		if (k > cg->max_degree){ cg->max_degree = k; }
+	}
+
+	// Most gaps take one byte, so the buffer is grown if needed
+	size_t capacity = num_adjacents + n + 16, size = 0;
+	cg->offset = malloc((n+1) * sizeof(*cg->offset));
+	cg->data = malloc(capacity);
+	int *adj = malloc((cg->max_degree + 1) * sizeof(*adj));
+	double *weight = malloc((cg->max_degree + 1) * sizeof(*weight));
+	graph_compressed_edge_t *edge = malloc((cg->max_degree + 1) * sizeof(*edge));
+	if (cg->is_weighted){
+		cg->first = malloc((n+1) * sizeof(*cg->first));
+		cg->weight = malloc((num_adjacents + 1) * sizeof(*cg->weight));
+	}
+	if (!cg->offset || !cg->data || !adj || !weight || !edge ||
+	    (cg->is_weighted && (!cg->first || !cg->weight))){
+		goto failure;
+	}
+
+	size_t num_weights = 0;
+	for (i=0; i < n; i++){
+		int k = graph_weighted_adjacents(g, i, adj, weight);
+		if (cg->is_weighted){
+			for (j=0; j < k; j++){
+				edge[j].key = adj[j];
+				edge[j].weight = weight[j];
+			}
+			qsort(edge, k, sizeof(*edge), comp_compressed_edge_asc);
+			for (j=0; j < k; j++){
+				adj[j] = edge[j].key;
+				cg->weight[num_weights + j] = edge[j].weight;
+			}
+			cg->first[i] = num_weights;
+			num_weights += k;
+		} else {
+			qsort(adj, k, sizeof(*adj), comp_int_asc);
+		}
+
+		// Each value takes at most 5 bytes
+		if (size + 5*(k+1) > capacity){
+			size_t new_capacity = 2*capacity + 5*(k+1);
+			unsigned char *data = realloc(cg->data, new_capacity);
+			if (!data){ goto failure; }
+			cg->data = data;
+			capacity = new_capacity;
+		}
+
+		cg->offset[i] = size;
+		unsigned char *p = cg->data + size;
+		p = graph_varint_encode(p, k);
+		for (j=0; j < k; j++){
+			unsigned int gap = j == 0 ? graph_zigzag_encode(adj[0] - i)
+			                          : adj[j] - adj[j-1] - 1;
+			p = graph_varint_encode(p, gap);
+		}
+		size = p - cg->data;
+	}
+	cg->offset[n] = size;
+	if (cg->is_weighted){ cg->first[n] = num_weights; }
+
+	unsigned char *data = realloc(cg->data, size + 1);
+	if (data){ cg->data = data; }
+
+	free(adj);
+	free(weight);
+	free(edge);
+	return cg;
+
+failure:
+	free(adj);
+	free(weight);
+	free(edge);
+	delete_graph_compressed(cg);
+	return NULL;
+}
+
+graph_t *graph_decompress(const graph_compressed_t *cg){
+	assert(cg);
+	int i, j, n = cg->n;
+
+	graph_t *g = new_graph(n, cg->is_weighted, cg->is_directed);
+	int *adj = malloc((cg->max_degree + 1) * sizeof(*adj));
+	double *weight = malloc((cg->max_degree + 1) * sizeof(*weight));
+	if (!g || !adj || !weight){ goto failure; }
+
+	for (i=0; i < n; i++){
+		int k = graph_compressed_weighted_adjacents(cg, i, adj, weight);
+		for (j=0; j < k; j++){
+			if (!cg->is_directed && adj[j] < i){ continue; }
+			if (graph_add_weighted_edge(g, i, adj[j], weight[j])){ goto failure; }
+		}
+	}
+
+	free(adj);
+	free(weight);
+	return g;
+
+failure:
+	if (g){ delete_graph(g); }
+	free(adj);
+	free(weight);
+	return NULL;
+}
+
+/********************************** Query *************************************/
+
+int graph_compressed_num_vertices(const graph_compressed_t *cg){
+	assert(cg);
+	return cg->n;
+}
+
+int64_t graph_compressed_num_edges(const graph_compressed_t *cg){
+	assert(cg);
+	return cg->m;
+}
+
+bool graph_compressed_is_directed(const graph_compressed_t *cg){
+	assert(cg);
+	return cg->is_directed;
+}
+
+bool graph_compressed_is_weighted(const graph_compressed_t *cg){
+	assert(cg);
+	return cg->is_weighted;
+}
+
+size_t graph_compressed_size(const graph_compressed_t *cg){
+	assert(cg);
+	size_t size = sizeof(*cg) + (cg->n + 1) * sizeof(*cg->offset) + cg->offset[cg->n];
+	if (cg->is_weighted){
+		size += (cg->n + 1) * sizeof(*cg->first) + cg->first[cg->n] * sizeof(double);
+	}
+	return size;
+}
+
+/******************************** Adjacencies *********************************/
+
+int graph_compressed_num_adjacents(const graph_compressed_t *cg, int i){
+	assert(cg);
+	assert(i >= 0 && i < cg->n);
+	unsigned int k;
+	graph_varint_decode(cg->data + cg->offset[i], &k);
+	return k;
+}
+
+int graph_compressed_adjacents(const graph_compressed_t *cg, int i, int *adj){
+	assert(cg);
+	assert(i >= 0 && i < cg->n);
+	assert(adj);
+
+	unsigned int j, k, gap;
+	const unsigned char *p = graph_varint_decode(cg->data + cg->offset[i], &k);
+	if (k == 0){ return 0; }
+
+	p = graph_varint_decode(p, &gap);
+	int key = i + graph_zigzag_decode(gap);
+	adj[0] = key;
+	for (j=1; j < k; j++){
+		// Fast path for single-byte gaps
+		gap = *p;
+		if (gap < 0x80){ p++; }
+		else           { p = graph_varint_decode(p, &gap); }
+		key += gap + 1;
+		adj[j] = key;
+	}
+	return k;
+}
+
+int graph_compressed_weighted_adjacents
+		(const graph_compressed_t *cg, int i, int *adj, double *weight){
+	assert(weight);
+	int j, k = graph_compressed_adjacents(cg, i, adj);
+	if (cg->is_weighted){
+		memcpy(weight, cg->weight + cg->first[i], k * sizeof(*weight));
+	} else {
+		for (j=0; j < k; j++){ weight[j] = 1.0; }
+	}
+	return k;
+}
+
+void graph_compressed_head
+		(const graph_compressed_t *cg, int i, graph_compressed_iterator_t *it){
+	assert(cg);
+	assert(i >= 0 && i < cg->n);
+	assert(it);
+
+	unsigned int k;
+	it->next = graph_varint_decode(cg->data + cg->offset[i], &k);
+	it->remaining = k;
+	it->vertex = i;
+	it->key = -1;
+}
+
+bool graph_compressed_next(graph_compressed_iterator_t *it){
+	assert(it);
+	if (it->remaining == 0){ return false; }
+	unsigned int gap;
+	it->next = graph_varint_decode(it->next, &gap);
+	it->remaining--;
+
+	// The first neighbor is relative to the vertex, the others to the previous
+	if (it->key < 0){ it->key = it->vertex + graph_zigzag_decode(gap); }
+	else            { it->key += gap + 1; }
+	return true;
+}
+
+bool graph_compressed_is_adjacent(const graph_compressed_t *cg, int i, int j){
+	graph_compressed_iterator_t it;
+	graph_compressed_head(cg, i, &it);
+	while (graph_compressed_next(&it)){
+		if (it.key >= j){ return it.key == j; }
+	}
+	return false;
+}
+
+/********************************** Metrics ***********************************/
+
+void graph_compressed_degree(const graph_compressed_t *cg, int *degree){
+	assert(cg);
+	assert(degree);
+	int i;
+	for (i=0; i < cg->n; i++){
+		degree[i] = graph_compressed_num_adjacents(cg, i);
+	}
+	if (cg->is_directed){
+		graph_compressed_iterator_t it;
+		for (i=0; i < cg->n; i++){
+			graph_compressed_head(cg, i, &it);
+			while (graph_compressed_next(&it)){
+				degree[it.key]++;
+			}
+		}
+	}
+}
+
+void graph_compressed_geodesic_vertex
+		(const graph_compressed_t *cg, int s, int *distance){
+	assert(cg);
+	assert(s >= 0 && s < cg->n);
+	assert(distance);
+
+	int i, n = cg->n;
+	int *queue = malloc(n * sizeof(*queue));
+	int *adj = malloc((cg->max_degree + 1) * sizeof(*adj));
+	if (!queue || !adj){ free(queue); free(adj); return; }
+
+	for (i=0; i < n; i++){ distance[i] = -1; }
+	distance[s] = 0;
+
+	int head = 0, tail = 0;
+	queue[tail++] = s;
+	while (tail > head){
+		int v = queue[head++];
+		int k = graph_compressed_adjacents(cg, v, adj);
+		for (i=0; i < k; i++){
+			int w = adj[i];
+			if (distance[w] < 0){
+				distance[w] = distance[v] + 1;
+				queue[tail++] = w;
+			}
+		}
+	}
+
+	free(queue);
+	free(adj);
+}
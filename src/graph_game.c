@@ -2,12 +2,19 @@
 #include <string.h>
 #include <assert.h>
 #include <math.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <pthread.h>
 
 #include "stat.h"
 #include "graph.h"
 #include "graph_game.h"
 #include "graph_layout.h"
 
+#ifndef CACHE_ALIGNMENT
+	#define CACHE_ALIGNMENT 64
+#endif
+
 graph_game_step_t *new_graph_game_steps(int num_steps, int n){
 	assert(num_steps > 0);
 	assert(n > 0);
@@ -31,16 +38,149 @@ void delete_graph_game_steps(graph_game_step_t *step, int num_steps){
 	free(step);
 }
 
+/** Each step has two data-parallel phases over contiguous vertex ranges,
+ * separated by barriers: payoffs of step t are computed from the states of
+ * step t-1, and then each vertex imitates a neighbor using the payoffs of
+ * step t. Vertices are grouped in blocks of GRAPH_GAME_BLOCK_SIZE with their
+ * own random stream, so results don't depend on the number of processors.
+ */
+typedef struct {
+	int n, num_blocks, num_ranges;
+	int64_t *offset;             // Contiguous adjacency, from graph_csr
+	int *adj;
+	unsigned int *seed;          // One seed per block
+	float (*payoff)[2];
+	float spread;
+	graph_game_step_t *step;
+	int num_steps;
+	
+	const bool *is_running;      // Ranges whose thread was launched
+	int num_running;             // Threads waiting on barrier
+	bool is_cancelled;
+	pthread_mutex_t start;
+	pthread_barrier_t barrier;
+} graph_game_context_t;
+
+void graph_game_payoff_range(graph_game_context_t *ctx, int t, int range){
+	int begin = (int)((long)range * ctx->n / ctx->num_ranges);
+	int end   = (int)((long)(range+1) * ctx->n / ctx->num_ranges);
+	
+	const graph_game_state_t *state = ctx->step[t-1].state;
+	float *payoff = ctx->step[t].payoff;
+	
+	int i;
+	int64_t e;
+	for (i=begin; i < end; i++){
+		int ki = ctx->offset[i+1] - ctx->offset[i];
+		int num_coop = 0;
+		for (e=ctx->offset[i]; e < ctx->offset[i+1]; e++){
+			num_coop += state[ ctx->adj[e] ] == GRAPH_GAME_COOP;
+		}
+		payoff[i] = num_coop        * ctx->payoff[ state[i] ][GRAPH_GAME_COOP] +
+		            (ki - num_coop) * ctx->payoff[ state[i] ][GRAPH_GAME_DEFECT];
+	}
+}
+
+void graph_game_imitate_range(graph_game_context_t *ctx, int t, int range){
+	int bb, block_begin = (int)((long)range * ctx->num_blocks / ctx->num_ranges);
+	int block_end = (int)((long)(range+1) * ctx->num_blocks / ctx->num_ranges);
+	
+	const graph_game_state_t *prev = ctx->step[t-1].state;
+	graph_game_state_t *state = ctx->step[t].state;
+	const float *payoff = ctx->step[t].payoff;
+	
+	int i;
+	for (bb=block_begin; bb < block_end; bb++){
+		unsigned int *seedp = &ctx->seed[bb];
+		int begin = bb * GRAPH_GAME_BLOCK_SIZE;
+		int end = begin + GRAPH_GAME_BLOCK_SIZE < ctx->n ? 
+		          begin + GRAPH_GAME_BLOCK_SIZE : ctx->n;
+		
+		for (i=begin; i < end; i++){
+			// At first, everyone keeps its strategy
+			state[i] = prev[i];
+			
+			int ki = ctx->offset[i+1] - ctx->offset[i];
+			if (ki == 0){ continue; }
+			
+			// Choose neighbor's strategy if it gives higher payoff
+			int v = ctx->adj[ ctx->offset[i] + uniform(ki, seedp) ];
+			double pi = payoff[i];
+			double pv = payoff[v];
+			if (pv > pi){
+				int kv = ctx->offset[v+1] - ctx->offset[v];
+				int kmax = ki > kv ? ki : kv;
+				double prob = (pv - pi)/(kmax * ctx->spread);
+				double r = (double) my_rand_r(seedp) / RAND_MAX;
+				if (r < prob){
+					state[i] = prev[v];
+				}
+			}
+		}
+	}
+}
+
+// Runs all steps on the ranges owned by a thread, that are its own range or,
+//for the main thread, also those whose thread couldn't be launched.
+void graph_game_run(graph_game_context_t *ctx, int index){
+	int r, t;
+	for (t=1; t < ctx->num_steps; t++){
+		for (r=0; r < ctx->num_ranges; r++){
+			if (r == index || (index == 0 && !ctx->is_running[r])){
+				graph_game_payoff_range(ctx, t, r);
+			}
+		}
+		if (ctx->num_running > 1){ pthread_barrier_wait(&ctx->barrier); }
+		
+		for (r=0; r < ctx->num_ranges; r++){
+			if (r == index || (index == 0 && !ctx->is_running[r])){
+				graph_game_imitate_range(ctx, t, r);
+			}
+		}
+		if (ctx->num_running > 1){ pthread_barrier_wait(&ctx->barrier); }
+	}
+}
+
+typedef struct {
+	graph_game_context_t *ctx;
+	int index;
+	char padding[CACHE_ALIGNMENT - sizeof(graph_game_context_t *) - sizeof(int)];
+} graph_game_task_params_t;
+
+void *graph_game_task(void *args){
+	graph_game_task_params_t *params = args;
+	graph_game_context_t *ctx = params->ctx;
+	
+	// Waits until the main thread knows how many threads are running
+	pthread_mutex_lock(&ctx->start);
+	pthread_mutex_unlock(&ctx->start);
+	
+	if (!ctx->is_cancelled){
+		graph_game_run(ctx, params->index);
+	}
+	return NULL;
+}
+
 void graph_game_r
 		(const graph_t *g, graph_game_state_t *init_state, 
 		 float payoff[2][2], float spread, 
 		 graph_game_step_t *step, int num_steps, unsigned int *seedp){
+	graph_game_parallel_r(g, init_state, payoff, spread, step, num_steps, seedp,
+	                      GRAPH_GAME_NUM_PROCESSORS);
+}
+
+void graph_game_parallel_r
+		(const graph_t *g, graph_game_state_t *init_state, 
+		 float payoff[2][2], float spread, 
+		 graph_game_step_t *step, int num_steps, unsigned int *seedp,
+		 int num_processors){
 	assert(g);
 	assert(init_state);
 	assert(step);
 	assert(num_steps > 0);
+	assert(num_processors > 0);
 	
-	int i, j, n = graph_num_vertices(g);
+	int i, n = graph_num_vertices(g);
 	
 	int t=0;
 	for (i=0; i < n; i++){
@@ -48,51 +188,183 @@ void graph_game_r
 		step[t].payoff[i] = 0.0f;
 	}
 	
-	int *adj = malloc (n * sizeof(*adj));
-	int *random_neighbor = malloc(n * sizeof(*adj));
+	graph_game_context_t ctx;
+	ctx.n = n;
+	ctx.num_blocks = (n + GRAPH_GAME_BLOCK_SIZE - 1) / GRAPH_GAME_BLOCK_SIZE;
+	ctx.num_ranges = num_processors < ctx.num_blocks ? 
+	                 num_processors : ctx.num_blocks;
+	ctx.payoff = payoff;
+	ctx.spread = spread;
+	ctx.step = step;
+	ctx.num_steps = num_steps;
+	ctx.is_cancelled = false;
+	ctx.offset = NULL;
+	ctx.adj = NULL;
+	
+	ctx.seed = malloc(ctx.num_blocks * sizeof(*ctx.seed));
+	bool *is_running = malloc(ctx.num_ranges * sizeof(*is_running));
+	pthread_t *thread = malloc(ctx.num_ranges * sizeof(*thread));
+	graph_game_task_params_t *params = malloc(ctx.num_ranges * sizeof(*params));
+	error_t error = graph_csr(g, &ctx.offset, &ctx.adj);
+	
+	if (error || !(ctx.seed && is_running && thread && params)){
+		fprintf(stderr, "No memory to run game\n");
+		goto cleanup;
+	}
+	ctx.is_running = is_running;
+	
+	for (i=0; i < ctx.num_blocks; i++){
+		ctx.seed[i] = my_rand_r(seedp);
+	}
+	
+	// Threads are launched for ranges 1..num_ranges-1 and wait until the 
+	//barrier is initialized with the number of successful launches.
+	pthread_mutex_init(&ctx.start, NULL);
+	pthread_mutex_lock(&ctx.start);
 	
-	for (t = 1; t < num_steps; t++){
-		// At first, everyone keeps its strategy
-		for (i=0; i < n; i++){
-			step[t].state[i] = step[t-1].state[i];
+	ctx.num_running = 1;
+	is_running[0] = false;
+	for (i=1; i < ctx.num_ranges; i++){
+		params[i].ctx = &ctx;
+		params[i].index = i;
+		is_running[i] = 
+			pthread_create(&thread[i], NULL, graph_game_task, &params[i]) == 0;
+		if (is_running[i]){ ctx.num_running++; }
+	}
+	
+	if (pthread_barrier_init(&ctx.barrier, NULL, ctx.num_running) != 0){
+		ctx.is_cancelled = true;
+	}
+	pthread_mutex_unlock(&ctx.start);
+	
+	if (ctx.is_cancelled){
+		// Launched threads exit without doing anything
+		for (i=1; i < ctx.num_ranges; i++){
+			if (is_running[i]){ pthread_join(thread[i], NULL); }
+			is_running[i] = false;
 		}
-		
-		// Compute payoffs for each individual
-		for (i=0; i < n; i++){
-			step[t].payoff[i] = 0.0f;
-			int ki = graph_adjacents(g, i, adj);
-			for (j=0; j < ki; j++){
-				int v = adj[j];
-				step[t].payoff[i] += payoff[ step[t-1].state[i] ][ step[t-1].state[v] ];
-			}
+		ctx.num_running = 1;
+		fprintf(stderr, "Failure executing parallel game. "
+		                "Launching single-threaded\n");
+	}
+	
+	graph_game_run(&ctx, 0);
+	
+	for (i=1; i < ctx.num_ranges; i++){
+		if (is_running[i]){ pthread_join(thread[i], NULL); }
+	}
+	
+	if (!ctx.is_cancelled){ pthread_barrier_destroy(&ctx.barrier); }
+	pthread_mutex_destroy(&ctx.start);
+	
+cleanup:
+	free(ctx.offset);
+	free(ctx.adj);
+	free(ctx.seed);
+	free(is_running);
+	free(thread);
+	free(params);
+}
+
+/******************************* Asynchronous *********************************/
+
+float graph_game_payoff
+		(float payoff[2][2], graph_game_state_t s, int k, int num_coop){
+	return num_coop * payoff[s][GRAPH_GAME_COOP] + 
+	       (k - num_coop) * payoff[s][GRAPH_GAME_DEFECT];
+}
+
+// Returns true if the mean of the last window is close to the mean of the 
+//previous one. history is a circular buffer with 2*GRAPH_GAME_WINDOW values.
+bool graph_game_is_stationary(const double *history, int t){
+	if (t < 2*GRAPH_GAME_WINDOW){ return false; }
+	
+	int i, w = GRAPH_GAME_WINDOW;
+	double last = 0.0, previous = 0.0;
+	for (i=0; i < w; i++){
+		last     += history[(t - i)     % (2*w)];
+		previous += history[(t - w - i) % (2*w)];
+	}
+	return fabs(last - previous)/w < GRAPH_GAME_TOLERANCE;
+}
+
+int graph_game_async_r
+		(const graph_t *g, graph_game_state_t *state,
+		 float payoff[2][2], float spread,
+		 int max_steps, FILE *fp, unsigned int *seedp){
+	assert(g);
+	assert(state);
+	assert(max_steps >= 0);
+	
+	int i, t, n = graph_num_vertices(g);
+	int64_t e;
+	
+	int64_t *offset = NULL;
+	int *adj = NULL;
+	int *num_coop = malloc(n * sizeof(*num_coop));
+	double *history = malloc(2*GRAPH_GAME_WINDOW * sizeof(*history));
+	if (graph_csr(g, &offset, &adj) || !num_coop || !history){
+		free(offset); free(adj); free(num_coop); free(history);
+		return -1;
+	}
+	
+	// Number of cooperating neighbors, from which payoffs are computed
+	int total_coop = 0;
+	for (i=0; i < n; i++){
+		num_coop[i] = 0;
+		for (e=offset[i]; e < offset[i+1]; e++){
+			num_coop[i] += state[ adj[e] ] == GRAPH_GAME_COOP;
+		}
+		total_coop += state[i] == GRAPH_GAME_COOP;
+	}
+	
+	history[0] = (double) total_coop / n;
+	if (fp){ fprintf(fp, "0 %lf\n", history[0]); }
+	
+	for (t=1; t <= max_steps; t++){
+		int update;
+		for (update=0; update < n; update++){
+			i = uniform(n, seedp);
+			int ki = offset[i+1] - offset[i];
+			if (ki == 0){ continue; }
+			
+			int v = adj[ offset[i] + uniform(ki, seedp) ];
+			if (state[v] == state[i]){ continue; }
 			
-			// Choose random neighbor
-			if (ki > 0){ random_neighbor[i] = adj[ uniform(ki, seedp) ]; }
+			int kv = offset[v+1] - offset[v];
+			double pi = graph_game_payoff(payoff, state[i], ki, num_coop[i]);
+			double pv = graph_game_payoff(payoff, state[v], kv, num_coop[v]);
+			if (pv <= pi){ continue; }
+			
+			int kmax = ki > kv ? ki : kv;
+			double prob = (pv - pi)/(kmax * spread);
+			double r = (double) my_rand_r(seedp) / RAND_MAX;
+			if (r >= prob){ continue; }
+			
+			// Only neighbors' payoffs change when i switches strategy
+			state[i] = state[v];
+			int delta = state[i] == GRAPH_GAME_COOP ? +1 : -1;
+			for (e=offset[i]; e < offset[i+1]; e++){
+				num_coop[ adj[e] ] += delta;
+			}
+			total_coop += delta;
 		}
 		
-		// Choose neighbor's strategy if it gives higher payoff
-		for (i=0; i < n; i++){
-			int ki = graph_num_adjacents(g, i);
-			if (ki > 0){
-				int v = random_neighbor[i];
-				
-				double pi = step[t].payoff[i];
-				double pv = step[t].payoff[v];
-				if (pv > pi){
-					int kv = graph_num_adjacents(g, v);
-					int kmax = ki > kv ? ki : kv;
-					double prob = (pv - pi)/(kmax * spread);
-					double r = (double) rand() / RAND_MAX;
-					if (r < prob){
-						step[t].state[i] = step[t-1].state[v];
-					}
-				}
-			}
+		double coop_fraction = (double) total_coop / n;
+		history[t % (2*GRAPH_GAME_WINDOW)] = coop_fraction;
+		if (fp){ fprintf(fp, "%d %lf\n", t, coop_fraction); }
+		
+		if (total_coop == 0 || total_coop == n || 
+		    graph_game_is_stationary(history, t)){
+			break;
 		}
 	}
 	
+	free(offset);
 	free(adj);
-	free(random_neighbor);
+	free(num_coop);
+	free(history);
+	return t > max_steps ? max_steps : t;
 }
 
 void graph_game_prisioner_r
@@ -108,35 +380,88 @@ void graph_game_prisioner_r
 	graph_game_state_t *init_state = malloc(n * sizeof(*init_state));
 	
 	for (i=0; i < n; i++){
-		double r = (double) rand()/RAND_MAX;
+		double r = (double) my_rand_r(seedp)/RAND_MAX;
 		if (r < coop_fraction){ init_state[i] = GRAPH_GAME_COOP; }
 		else                  { init_state[i] = GRAPH_GAME_DEFECT; }
 	}
 	
 	float payoff[2][2] = {{1.0f, 0.0f}, {b, 0.0f}};
 	graph_game_r(g, init_state, payoff, b, step, num_steps, seedp);
+	free(init_state);
 }
 
-void graph_animate_game
-		(const char *folder, const graph_t *g, const coord_t *p, 
-		 graph_game_step_t *step, int num_steps){
-	assert(folder);
-	assert(g);
-	assert(p);
-	assert(step);
-	assert(num_steps > 0);
-	
-	int i, j, t, n = graph_num_vertices(g), m = graph_num_edges(g);
+typedef struct {
+	const char *folder;
+	const graph_t *g;
+	const coord_t *p;
+	const graph_game_step_t *step;
+	int width, height;
+} graph_game_frame_data_t;
+
+error_t graph_game_print_frame(int t, graph_svg_buffer_t *buffer, void *_data){
+	const graph_game_frame_data_t *data = _data;
+	const graph_t *g = data->g;
+	const coord_t *p = data->p;
+	const graph_game_step_t step = data->step[t];
+	int i, n = graph_num_vertices(g);
+	int64_t m = graph_num_edges(g);
 	
 	color_t red_75    = {255, 0,   0,   192};
 	color_t blue_75   = {0,   0,   255, 192};
 	color_t black_25  = {0,   0,   0,   64};
 	color_t black_100 = {0,   0,   0,   255};
 	
+	char filename[256];
+	sprintf(filename, "%s/frame%05d.svg", data->folder, t);
+	
 	path_style_t *edge_style = malloc(m * sizeof(*edge_style));
 	circle_style_t *point_style = malloc(n * sizeof(*point_style));
+	if (!edge_style || !point_style){
+		fprintf(stderr, "No memory to print %s\n", filename);
+		free(edge_style); free(point_style);
+		return ERROR_NO_MEMORY;
+	}
 	
-	int *adj = malloc(n * sizeof(*adj));
+	int64_t e = 0;
+	for (i=0; i < n; i++){
+		point_style[i].radius = (int) (1.0f + step.payoff[i]);
+		point_style[i].width = 1;			
+		color_copy(point_style[i].stroke, black_100);
+		color_copy(
+			point_style[i].fill, 
+			step.state[i] == GRAPH_GAME_COOP ? red_75 : blue_75);
+		
+		set_entry_t *adj;
+		for (adj = graph_adjacent_head(g, i); adj != NULL; adj = adj->next){
+			int v = adj->key;
+			if (i < v){
+				edge_style[e].from.x = p[i].x; edge_style[e].from.y = p[i].y;
+				edge_style[e].to.x   = p[v].x; edge_style[e].to.y   = p[v].y;
+				edge_style[e].type = GRAPH_STRAIGHT;
+				edge_style[e].width = 1;
+				color_copy(edge_style[e].color, black_25);
+				e++;
+			}
+		}
+	}
+	
+	error_t error = graph_print_svg_buffered
+		(buffer, filename, data->width, data->height, g, p, point_style, edge_style);
+	free(point_style);
+	free(edge_style);
+	return error;
+}
+
+error_t graph_animate_game
+		(const char *folder, const graph_t *g, const coord_t *p, 
+		 graph_game_step_t *step, int num_steps){
+	assert(folder);
+	assert(g);
+	assert(p);
+	assert(step);
+	assert(num_steps > 0);
+	
+	int i, t, n = graph_num_vertices(g);
 	
 	box_t bbox = {{0.0f,0.0f},{0.0f,0.0f}};
 	for (i=0; i < n; i++){
@@ -151,37 +476,7 @@ void graph_animate_game
 	int width  = (int) ceilf(bbox.ne.x - bbox.sw.x);
 	int height = (int) ceilf(bbox.ne.y - bbox.sw.y);
 	
-	for (t=0; t < num_steps; t++){
-	  char filename[256];
-		sprintf(filename, "%s/frame%05d.svg", folder, t);
-		
-		int e = 0;
-		for (i=0; i < n; i++){
-			point_style[i].radius = (int) (1.0f + step[t].payoff[i]);
-			point_style[i].width = 1;			
-			color_copy(point_style[i].stroke, black_100);
-			color_copy(
-				point_style[i].fill, 
-				step[t].state[i] == GRAPH_GAME_COOP ? red_75 : blue_75);
-			
-			int ki = graph_adjacents(g, i, adj);
-			for (j=0; j < ki; j++){
-				int v = adj[j];
-				if (i < v){
-					edge_style[e].from.x = p[i].x; edge_style[e].from.y = p[i].y;
-					edge_style[e].to.x   = p[v].x; edge_style[e].to.y   = p[v].y;
-					edge_style[e].type = GRAPH_STRAIGHT;
-					edge_style[e].width = 1;
-					color_copy(edge_style[e].color, black_25);
-					e++;
-				}
-			}
-		}
-		
-		graph_print_svg(filename, width+1, height+1, g, p, point_style, edge_style);
-	}
-	
-	free(adj);
-	free(point_style);
-	free(edge_style);
+	graph_game_frame_data_t data = {folder, g, p, step, width+1, height+1};
+	return graph_print_frames(num_steps, GRAPH_LAYOUT_NUM_PROCESSORS, 
+	                          graph_game_print_frame, &data);
 }
@@ -0,0 +1,312 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "error.h"
+#include "graph.h"
+#include "graph_metric.h"
+#include "graph_incremental.h"
+
+/*************************** Allocation and deallocation **********************/
+
+graph_incremental_t *new_graph_incremental(graph_t *g){
+	assert(g);
+	assert(!graph_is_directed(g));
+
+	graph_incremental_t *inc = calloc(1, sizeof(*inc));
+	if (!inc){ return NULL; }
+
+	int i, n = graph_num_vertices(g);
+	inc->g = g;
+	inc->n = n;
+	inc->degree = malloc(n * sizeof(*inc->degree));
+	inc->triangles = calloc(n, sizeof(*inc->triangles));
+	inc->component = malloc(n * sizeof(*inc->component));
+	inc->component_size = calloc(n, sizeof(*inc->component_size));
+	inc->core = malloc(n * sizeof(*inc->core));
+	inc->free_label = malloc(n * sizeof(*inc->free_label));
+	inc->queue = malloc(n * sizeof(*inc->queue));
+	inc->queue_other = malloc(n * sizeof(*inc->queue_other));
+	inc->mark = calloc(n, sizeof(*inc->mark));
+	inc->support = malloc(n * sizeof(*inc->support));
+	if (n > 0 &&
+	    (!inc->degree || !inc->triangles || !inc->component ||
+	     !inc->component_size || !inc->core || !inc->free_label ||
+	     !inc->queue || !inc->queue_other || !inc->mark || !inc->support)){
+		delete_graph_incremental(inc);
+		return NULL;
+	}
+
+	graph_degree(g, inc->degree);
+	graph_kcore(g, inc->core);
+
+	// Each triangle i < j < w is found from its smallest edge (i, j)
+	for (i=0; i < n; i++){
+		set_entry_t *p, *q;
+		for (p = graph_adjacent_head(g, i); p; p = p->next){
+			int j = p->key;
+			if (j < i){ continue; }
+			int s = inc->degree[i] < inc->degree[j] ? i : j;
+			int o = s == i ? j : i;
+			for (q = graph_adjacent_head(g, s); q; q = q->next){
+				int w = q->key;
+				if (w > j && graph_is_adjacent(g, o, w)){
+					inc->triangles[i]++;
+					inc->triangles[j]++;
+					inc->triangles[w]++;
+					inc->num_triangles++;
+				}
+			}
+		}
+	}
+
+	inc->num_components = graph_undirected_components(g, inc->component);
+	for (i=0; i < n; i++){
+		inc->component_size[inc->component[i]]++;
+	}
+	for (i=0; i < n - inc->num_components; i++){
+		inc->free_label[i] = n-1 - i;
+	}
+
+	return inc;
+}
+
+void delete_graph_incremental(graph_incremental_t *inc){
+	assert(inc);
+	free(inc->degree);
+	free(inc->triangles);
+	free(inc->component);
+	free(inc->component_size);
+	free(inc->core);
+	free(inc->free_label);
+	free(inc->queue);
+	free(inc->queue_other);
+	free(inc->mark);
+	free(inc->support);
+	free(inc);
+}
+
+/********************************* Triangles **********************************/
+
+// Adds delta to the triangles formed by edge (i, j) with common neighbors.
+void graph_incremental_triangles(graph_incremental_t *inc, int i, int j, int delta){
+	int s = inc->degree[i] < inc->degree[j] ? i : j;
+	int o = s == i ? j : i;
+	set_entry_t *p;
+	for (p = graph_adjacent_head(inc->g, s); p; p = p->next){
+		int w = p->key;
+		if (w != o && graph_is_adjacent(inc->g, o, w)){
+			inc->triangles[i] += delta;
+			inc->triangles[j] += delta;
+			inc->triangles[w] += delta;
+			inc->num_triangles += delta;
+		}
+	}
+}
+
+/******************************** Components **********************************/
+
+// Relabels the component of i, that was joined to the component of j.
+void graph_incremental_join(graph_incremental_t *inc, int i, int j){
+	int old = inc->component[i], label = inc->component[j];
+	int head = 0, tail = 0;
+	inc->queue[tail++] = i;
+	inc->component[i] = label;
+	while (head < tail){
+		int v = inc->queue[head++];
+		set_entry_t *p;
+		for (p = graph_adjacent_head(inc->g, v); p; p = p->next){
+			if (inc->component[p->key] != label){
+				inc->component[p->key] = label;
+				inc->queue[tail++] = p->key;
+			}
+		}
+	}
+	inc->component_size[label] += inc->component_size[old];
+	inc->component_size[old] = 0;
+	inc->free_label[inc->n - inc->num_components] = old;
+	inc->num_components--;
+}
+
+/* Expands one vertex from the search queue with mark own. Returns 1 if it
+ * reached a vertex with mark other, -1 if the search is exhausted and 0
+ * otherwise. */
+int graph_incremental_expand
+		(graph_incremental_t *inc, int *queue, int *head, int *tail,
+		 int own, int other){
+	if (*head == *tail){ return -1; }
+	int v = queue[(*head)++];
+	set_entry_t *p;
+	for (p = graph_adjacent_head(inc->g, v); p; p = p->next){
+		int w = p->key;
+		if (inc->mark[w] == other){ return 1; }
+		if (inc->mark[w] != own){
+			inc->mark[w] = own;
+			queue[(*tail)++] = w;
+		}
+	}
+	return *head == *tail ? -1 : 0;
+}
+
+// Checks if removing (i, j) split their component, relabeling the smaller side.
+void graph_incremental_split(graph_incremental_t *inc, int i, int j){
+	int mark_i = inc->epoch += 2, mark_j = mark_i + 1;
+	int head_i = 0, tail_i = 0, head_j = 0, tail_j = 0;
+	inc->mark[i] = mark_i;
+	inc->mark[j] = mark_j;
+	inc->queue[tail_i++] = i;
+	inc->queue_other[tail_j++] = j;
+
+	int *side = NULL, size = 0, result;
+	while (true){
+		result = graph_incremental_expand
+			(inc, inc->queue, &head_i, &tail_i, mark_i, mark_j);
+		if (result > 0){ return; }
+		if (result < 0){ side = inc->queue; size = tail_i; break; }
+
+		result = graph_incremental_expand
+			(inc, inc->queue_other, &head_j, &tail_j, mark_j, mark_i);
+		if (result > 0){ return; }
+		if (result < 0){ side = inc->queue_other; size = tail_j; break; }
+	}
+
+	int k, old = inc->component[side[0]];
+	int label = inc->free_label[inc->n - inc->num_components - 1];
+	inc->num_components++;
+	for (k=0; k < size; k++){
+		inc->component[side[k]] = label;
+	}
+	inc->component_size[label] = size;
+	inc->component_size[old] -= size;
+}
+
+/********************************* k-core *************************************/
+
+/* Visits the subcore of i and j, that are vertices with core number k reachable
+ * from them through such vertices, counting the neighbors of each one with
+ * core number at least k. Returns the number of visited vertices, stored in
+ * queue and marked with the current epoch. */
+int graph_incremental_subcore(graph_incremental_t *inc, int i, int j, int k){
+	int epoch = inc->epoch, head = 0, tail = 0;
+	if (inc->core[i] == k){ inc->mark[i] = epoch; inc->queue[tail++] = i; }
+	if (inc->core[j] == k){ inc->mark[j] = epoch; inc->queue[tail++] = j; }
+
+	while (head < tail){
+		int v = inc->queue[head++];
+		inc->support[v] = 0;
+		set_entry_t *p;
+		for (p = graph_adjacent_head(inc->g, v); p; p = p->next){
+			int w = p->key;
+			if (inc->core[w] >= k){ inc->support[v]++; }
+			if (inc->core[w] == k && inc->mark[w] != epoch){
+				inc->mark[w] = epoch;
+				inc->queue[tail++] = w;
+			}
+		}
+	}
+	return tail;
+}
+
+/* Peels vertices of the subcore whose support is at most max_support, which
+ * decreases the support of their neighbors in the subcore. Peeled vertices are
+ * marked with epoch+1. */
+void graph_incremental_peel(graph_incremental_t *inc, int size, int max_support){
+	int epoch = inc->epoch, k, tail = 0;
+	for (k=0; k < size; k++){
+		int v = inc->queue[k];
+		if (inc->support[v] <= max_support){
+			inc->mark[v] = epoch+1;
+			inc->queue_other[tail++] = v;
+		}
+	}
+	while (tail > 0){
+		int v = inc->queue_other[--tail];
+		set_entry_t *p;
+		for (p = graph_adjacent_head(inc->g, v); p; p = p->next){
+			int w = p->key;
+			if (inc->mark[w] == epoch && --inc->support[w] <= max_support){
+				inc->mark[w] = epoch+1;
+				inc->queue_other[tail++] = w;
+			}
+		}
+	}
+}
+
+// After inserting (i, j), vertices of the subcore that keep more than k
+//supporting neighbors are promoted to the (k+1)-core.
+void graph_incremental_core_insert(graph_incremental_t *inc, int i, int j){
+	int k = inc->core[i] < inc->core[j] ? inc->core[i] : inc->core[j];
+	inc->epoch += 2;
+	int v, size = graph_incremental_subcore(inc, i, j, k);
+	graph_incremental_peel(inc, size, k);
+	for (v=0; v < size; v++){
+		if (inc->mark[inc->queue[v]] == inc->epoch){ inc->core[inc->queue[v]]++; }
+	}
+}
+
+// After removing (i, j), vertices of the subcore that keep less than k
+//supporting neighbors are demoted to the (k-1)-core.
+void graph_incremental_core_remove(graph_incremental_t *inc, int i, int j){
+	int k = inc->core[i] < inc->core[j] ? inc->core[i] : inc->core[j];
+	inc->epoch += 2;
+	int v, size = graph_incremental_subcore(inc, i, j, k);
+	graph_incremental_peel(inc, size, k-1);
+	for (v=0; v < size; v++){
+		if (inc->mark[inc->queue[v]] == inc->epoch+1){ inc->core[inc->queue[v]]--; }
+	}
+}
+
+/********************************* Updates ************************************/
+
+error_t graph_incremental_add_edge(graph_incremental_t *inc, int i, int j){
+	assert(inc);
+	if (i == j || graph_is_adjacent(inc->g, i, j)){ return ERROR_SUCCESS; }
+
+	error_t error = graph_add_edge(inc->g, i, j);
+	if (error){ return error; }
+
+	inc->degree[i]++;
+	inc->degree[j]++;
+	graph_incremental_triangles(inc, i, j, +1);
+
+	int ci = inc->component[i], cj = inc->component[j];
+	if (ci != cj){
+		if (inc->component_size[ci] < inc->component_size[cj]){
+			graph_incremental_join(inc, i, j);
+		} else {
+			graph_incremental_join(inc, j, i);
+		}
+	}
+
+	graph_incremental_core_insert(inc, i, j);
+	return ERROR_SUCCESS;
+}
+
+bool graph_incremental_remove_edge(graph_incremental_t *inc, int i, int j){
+	assert(inc);
+	if (!graph_remove_edge(inc->g, i, j)){ return false; }
+
+	inc->degree[i]--;
+	inc->degree[j]--;
+	graph_incremental_triangles(inc, i, j, -1);
+	graph_incremental_split(inc, i, j);
+	graph_incremental_core_remove(inc, i, j);
+	return true;
+}
+
+/********************************** Query *************************************/
+
+double graph_incremental_clustering(const graph_incremental_t *inc, int i){
+	assert(inc);
+	assert(i >= 0 && i < inc->n);
+	int k = inc->degree[i];
+	if (k <= 1){ return 0.0; }
+	return (2.0 * inc->triangles[i]) / ((double)k * (k - 1));
+}
+
+bool graph_incremental_is_connected(const graph_incremental_t *inc, int i, int j){
+	assert(inc);
+	assert(i >= 0 && i < inc->n);
+	assert(j >= 0 && j < inc->n);
+	return inc->component[i] == inc->component[j];
+}
@@ -3,7 +3,10 @@
 #include <stdlib.h>
 #include <math.h>
 #include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
 
+#include "error.h"
 #include "sorting.h"
 #include "stat.h"
 #include "graph.h"
@@ -188,7 +191,7 @@ void graph_layout_circle_edges
 	edge_style[1].width = width;
 	color_copy(edge_style[1].color, color);
 	
-	int e = 0; // edge count
+	int64_t e = 0; // edge count
 	int i, j, n = graph_num_vertices(g);
 	int *adj = malloc (n*sizeof(*adj));
 	for (i=0; i < n; i++){
@@ -301,6 +304,476 @@ double graph_layout_core_shell
 	return boxsize;
 }
 
+/*************************** Force-directed layout ****************************/
+
+/** Fruchterman-Reingold layout, where adjacent vertices attract with force
+ * d^2/k and all pairs repel with force k^2/d, for an ideal distance k. A weak
+ * gravity towards the centroid keeps disconnected components together.
+ *
+ * Repulsion is approximated with a Barnes-Hut quadtree, where a cell of side s
+ * at distance d is treated as a single body if s/d < GRAPH_LAYOUT_THETA.
+ */
+
+// Quadtree cell with SW corner (x, y) and side size. Leaves have all children
+//equal to -1 and hold bodies index[first] ... index[last-1].
+typedef struct {
+	float x, y, size;
+	float cx, cy, mass;
+	int child[4];
+	int first, last;
+} graph_quad_t;
+
+typedef struct {
+	graph_quad_t *node;
+	int num_node, size_node;
+	int *index, *buffer;
+	const coord_t *p;
+} graph_quadtree_t;
+
+int graph_quadtree_new_node
+		(graph_quadtree_t *tree, float x, float y, float size, int first, int last){
+	if (tree->num_node == tree->size_node){
+		int size_node = 2*tree->size_node;
+		graph_quad_t *node = realloc(tree->node, size_node * sizeof(*node));
+		if (!node){ return -1; }
+		tree->node = node;
+		tree->size_node = size_node;
+	}
+	
+	graph_quad_t *q = &tree->node[tree->num_node];
+	q->x = x; q->y = y; q->size = size;
+	q->first = first; q->last = last;
+	q->child[0] = q->child[1] = q->child[2] = q->child[3] = -1;
+	return tree->num_node++;
+}
+
+// Builds the subtree of bodies index[first] ... index[last-1], returning the
+//node id or -1 if there is no memory.
+int graph_quadtree_build
+		(graph_quadtree_t *tree, float x, float y, float size, 
+		 int first, int last, int depth){
+	int id = graph_quadtree_new_node(tree, x, y, size, first, last);
+	if (id < 0){ return -1; }
+	
+	int i, q;
+	const coord_t *p = tree->p;
+	float cx = 0.0f, cy = 0.0f;
+	for (i=first; i < last; i++){
+		cx += p[ tree->index[i] ].x;
+		cy += p[ tree->index[i] ].y;
+	}
+	tree->node[id].mass = last - first;
+	tree->node[id].cx = cx / (last - first);
+	tree->node[id].cy = cy / (last - first);
+	
+	if (last - first <= GRAPH_LAYOUT_LEAF_SIZE || depth == GRAPH_LAYOUT_MAX_DEPTH){
+		return id;
+	}
+	
+	// Distributes bodies by quadrant: SW, SE, NW, NE
+	float half = size/2, mx = x + half, my = y + half;
+	int count[5] = {0, 0, 0, 0, 0};
+	for (i=first; i < last; i++){
+		const coord_t pi = p[ tree->index[i] ];
+		count[1 + (pi.x >= mx) + 2*(pi.y >= my)]++;
+	}
+	for (q=0; q < 4; q++){
+		count[q+1] += count[q];
+	}
+	for (i=first; i < last; i++){
+		const coord_t pi = p[ tree->index[i] ];
+		tree->buffer[first + count[(pi.x >= mx) + 2*(pi.y >= my)]++] = tree->index[i];
+	}
+	memcpy(tree->index + first, tree->buffer + first, 
+	       (last - first) * sizeof(*tree->index));
+	
+	// count[q] is now the end of quadrant q
+	int begin = first;
+	for (q=0; q < 4; q++){
+		int end = first + count[q];
+		if (end > begin){
+			float qx = (q % 2) ? mx : x;
+			float qy = (q / 2) ? my : y;
+			int child = graph_quadtree_build(tree, qx, qy, half, begin, end, depth+1);
+			if (child < 0){ return -1; }
+			tree->node[id].child[q] = child;
+		}
+		begin = end;
+	}
+	return id;
+}
+
+error_t graph_quadtree_init(graph_quadtree_t *tree, const coord_t *p, int n){
+	int i;
+	tree->p = p;
+	tree->num_node = 0;
+	
+	float xmin = p[0].x, xmax = p[0].x, ymin = p[0].y, ymax = p[0].y;
+	for (i=0; i < n; i++){
+		tree->index[i] = i;
+		if (p[i].x < xmin){ xmin = p[i].x; }
+		if (p[i].x > xmax){ xmax = p[i].x; }
+		if (p[i].y < ymin){ ymin = p[i].y; }
+		if (p[i].y > ymax){ ymax = p[i].y; }
+	}
+	float size = xmax - xmin > ymax - ymin ? xmax - xmin : ymax - ymin;
+	size = size * (1 + 1e-3f) + 1e-3f;
+	
+	if (graph_quadtree_build(tree, xmin, ymin, size, 0, n, 0) < 0){
+		return ERROR_NO_MEMORY;
+	}
+	return ERROR_SUCCESS;
+}
+
+// Adds repulsion k^2 * mass/d from a body at (x, y) to displacement of pi
+void graph_layout_repulse
+		(coord_t pi, float x, float y, float mass, float k2, coord_t *disp){
+	float dx = pi.x - x, dy = pi.y - y;
+	float d2 = dx*dx + dy*dy;
+	if (d2 < 1e-6f){ return; }
+	float f = k2 * mass / d2; // (k^2 m/d) * (dx/d)
+	disp->x += f * dx;
+	disp->y += f * dy;
+}
+
+void graph_layout_repulsion
+		(const graph_quadtree_t *tree, int i, float k2, int *stack, coord_t *disp){
+	const coord_t *p = tree->p;
+	const coord_t pi = p[i];
+	int j, top = 0;
+	stack[top++] = 0;
+	
+	while (top > 0){
+		const graph_quad_t *q = &tree->node[ stack[--top] ];
+		bool is_leaf = q->child[0] < 0 && q->child[1] < 0 && 
+		               q->child[2] < 0 && q->child[3] < 0;
+		
+		if (is_leaf)
+		{
+			for (j=q->first; j < q->last; j++){
+				int v = tree->index[j];
+				if (v != i){ graph_layout_repulse(pi, p[v].x, p[v].y, 1.0f, k2, disp); }
+			}
+		}
+		else
+		{
+			float dx = pi.x - q->cx, dy = pi.y - q->cy;
+			float d = sqrtf(dx*dx + dy*dy);
+			bool is_inside = pi.x >= q->x && pi.x < q->x + q->size &&
+			                 pi.y >= q->y && pi.y < q->y + q->size;
+			if (!is_inside && q->size < GRAPH_LAYOUT_THETA * d)
+			{
+				graph_layout_repulse(pi, q->cx, q->cy, q->mass, k2, disp);
+			}
+			else
+			{
+				int c;
+				for (c=0; c < 4; c++){
+					if (q->child[c] >= 0){ stack[top++] = q->child[c]; }
+				}
+			}
+		}
+	}
+}
+
+typedef struct {
+	const graph_quadtree_t *tree;
+	const int64_t *offset;
+	const int *adj;
+	coord_t center;
+	float k;
+	coord_t *disp;
+	int first, last;
+} graph_force_task_params_t;
+
+// Computes displacement of vertices first ... last-1. Returns NULL if there
+//is no memory, and the params otherwise.
+void *graph_force_task(void *args){
+	graph_force_task_params_t *params = args;
+	const coord_t *p = params->tree->p;
+	float k = params->k, k2 = k*k;
+	
+	int *stack = malloc((3*GRAPH_LAYOUT_MAX_DEPTH + 4) * sizeof(*stack));
+	if (!stack){ return NULL; }
+	
+	int i;
+	int64_t e;
+	for (i=params->first; i < params->last; i++){
+		coord_t disp = {0.0f, 0.0f};
+		graph_layout_repulsion(params->tree, i, k2, stack, &disp);
+		
+		// Attraction d^2/k from each neighbor
+		for (e=params->offset[i]; e < params->offset[i+1]; e++){
+			int v = params->adj[e];
+			float dx = p[v].x - p[i].x, dy = p[v].y - p[i].y;
+			float d = sqrtf(dx*dx + dy*dy);
+			disp.x += dx * d / k;
+			disp.y += dy * d / k;
+		}
+		
+		// Gravity
+		disp.x += GRAPH_LAYOUT_GRAVITY * (params->center.x - p[i].x);
+		disp.y += GRAPH_LAYOUT_GRAVITY * (params->center.y - p[i].y);
+		
+		params->disp[i] = disp;
+	}
+	
+	free(stack);
+	return params;
+}
+
+// Runs iterations of the force layout with linear cooling from temperature t0
+error_t graph_layout_force_level
+		(const graph_t *g, float k, float t0, int num_iterations,
+		 int num_processors, coord_t *p){
+	int i, it, n = graph_num_vertices(g);
+	if (n < 2){ return ERROR_SUCCESS; }
+	
+	// Few vertices per thread don't pay the thread creation
+	if (num_processors > n/GRAPH_LAYOUT_MIN_TASK){ 
+		num_processors = n/GRAPH_LAYOUT_MIN_TASK;
+	}
+	if (num_processors < 1){ num_processors = 1; }
+	
+	graph_quadtree_t tree;
+	tree.size_node = 2*n;
+	tree.node = malloc(tree.size_node * sizeof(*tree.node));
+	tree.index = malloc(n * sizeof(*tree.index));
+	tree.buffer = malloc(n * sizeof(*tree.buffer));
+	
+	int64_t *offset = NULL;
+	int *adj = NULL;
+	coord_t *disp = malloc(n * sizeof(*disp));
+	pthread_t *thread = malloc(num_processors * sizeof(*thread));
+	graph_force_task_params_t *params = malloc(num_processors * sizeof(*params));
+	
+	error_t error = graph_csr(g, &offset, &adj);
+	if (!error && !(tree.node && tree.index && tree.buffer && disp && thread && params)){
+		error = ERROR_NO_MEMORY;
+	}
+	
+	for (it=0; it < num_iterations && !error; it++){
+		float t = t0 * (1.0f - (float) it / num_iterations);
+		
+		error = graph_quadtree_init(&tree, p, n);
+		if (error){ break; }
+		
+		coord_t center = {tree.node[0].cx, tree.node[0].cy};
+		for (i=0; i < num_processors; i++){
+			params[i].tree = &tree;
+			params[i].offset = offset;
+			params[i].adj = adj;
+			params[i].center = center;
+			params[i].k = k;
+			params[i].disp = disp;
+			params[i].first = (int)((long)i * n / num_processors);
+			params[i].last  = (int)((long)(i+1) * n / num_processors);
+		}
+		
+		// Thread 0 is the caller; ranges of threads that fail are run by it
+		bool *is_running = malloc(num_processors * sizeof(*is_running));
+		if (!is_running){ error = ERROR_NO_MEMORY; break; }
+		is_running[0] = false;
+		for (i=1; i < num_processors; i++){
+			is_running[i] = 
+				pthread_create(&thread[i], NULL, graph_force_task, &params[i]) == 0;
+		}
+		for (i=0; i < num_processors; i++){
+			if (!is_running[i] && !graph_force_task(&params[i])){ 
+				error = ERROR_NO_MEMORY;
+			}
+		}
+		for (i=1; i < num_processors; i++){
+			void *result;
+			if (is_running[i]){
+				pthread_join(thread[i], &result);
+				if (!result){ error = ERROR_NO_MEMORY; }
+			}
+		}
+		free(is_running);
+		
+		// Displacement limited by temperature
+		for (i=0; i < n; i++){
+			float d = sqrtf(disp[i].x*disp[i].x + disp[i].y*disp[i].y);
+			if (d > t){
+				p[i].x += disp[i].x * t/d;
+				p[i].y += disp[i].y * t/d;
+			} else {
+				p[i].x += disp[i].x;
+				p[i].y += disp[i].y;
+			}
+		}
+	}
+	
+	free(tree.node);
+	free(tree.index);
+	free(tree.buffer);
+	free(offset);
+	free(adj);
+	free(disp);
+	free(thread);
+	free(params);
+	return error;
+}
+
+// Matches each vertex to an unmatched neighbor, visiting them in random order.
+//Returns the coarse graph, where parent[i] is the coarse vertex of i.
+graph_t *graph_layout_coarsen(const graph_t *g, int *parent, unsigned int *seedp){
+	int i, j, n = graph_num_vertices(g);
+	int *order = malloc(n * sizeof(*order));
+	if (!order){ return NULL; }
+	
+	for (i=0; i < n; i++){
+		order[i] = i;
+		parent[i] = -1;
+	}
+	for (i=n-1; i > 0; i--){
+		j = uniform(i+1, seedp);
+		int aux = order[i]; order[i] = order[j]; order[j] = aux;
+	}
+	
+	// Matching with the unmatched neighbor of lowest degree, to avoid 
+	//collapsing hubs
+	int nc = 0;
+	for (j=0; j < n; j++){
+		int u = order[j];
+		if (parent[u] >= 0){ continue; }
+		
+		int best = -1, best_degree = 0;
+		set_entry_t *adj;
+		for (adj = graph_adjacent_head(g, u); adj != NULL; adj = adj->next){
+			int v = adj->key;
+			int kv = graph_num_adjacents(g, v);
+			if (parent[v] < 0 && (best < 0 || kv < best_degree)){
+				best = v;
+				best_degree = kv;
+			}
+		}
+		parent[u] = nc;
+		if (best >= 0){ parent[best] = nc; }
+		nc++;
+	}
+	free(order);
+	
+	graph_t *coarse = new_graph(nc, false, false);
+	if (!coarse){ return NULL; }
+	for (i=0; i < n; i++){
+		set_entry_t *adj;
+		for (adj = graph_adjacent_head(g, i); adj != NULL; adj = adj->next){
+			int pi = parent[i], pv = parent[adj->key];
+			if (pi != pv && graph_add_edge(coarse, pi, pv)){
+				delete_graph(coarse);
+				return NULL;
+			}
+		}
+	}
+	return coarse;
+}
+
+// Lays out g, recursively laying out its coarsened graph first if 
+//is_multilevel. Coarse layouts are refined with fewer iterations and a lower
+//initial temperature.
+error_t graph_layout_force_multilevel
+		(const graph_t *g, float k, int num_iterations, bool is_multilevel,
+		 int num_processors, coord_t *p, unsigned int *seedp){
+	int i, n = graph_num_vertices(g);
+	float t0 = k * sqrtf(n) / 10;
+	
+	if (!is_multilevel || n <= GRAPH_LAYOUT_COARSEST){
+		box_t box = {{0.0f, 0.0f}, {k * sqrtf(n) + 1.0f, k * sqrtf(n) + 1.0f}};
+		for (i=0; i < n; i++){
+			p[i].x = box.ne.x * (float) my_rand_r(seedp) / RAND_MAX;
+			p[i].y = box.ne.y * (float) my_rand_r(seedp) / RAND_MAX;
+		}
+		return graph_layout_force_level(g, k, t0, num_iterations, 
+		                                num_processors, p);
+	}
+	
+	int *parent = malloc(n * sizeof(*parent));
+	if (!parent){ return ERROR_NO_MEMORY; }
+	graph_t *coarse = graph_layout_coarsen(g, parent, seedp);
+	if (!coarse){ free(parent); return ERROR_NO_MEMORY; }
+	
+	// Stops coarsening when matching doesn't reduce the graph, as in stars
+	int nc = graph_num_vertices(coarse);
+	bool is_reduced = nc < GRAPH_LAYOUT_COARSENING * n;
+	
+	coord_t *pc = malloc(nc * sizeof(*pc));
+	error_t error = pc ? ERROR_SUCCESS : ERROR_NO_MEMORY;
+	if (!error){
+		error = graph_layout_force_multilevel(coarse, k, num_iterations, 
+		                                      is_reduced, num_processors, pc, seedp);
+	}
+	
+	// Vertices start next to their parent, and need less cooling
+	if (!error){
+		for (i=0; i < n; i++){
+			p[i].x = pc[ parent[i] ].x + k * ((float) my_rand_r(seedp) / RAND_MAX - 0.5f);
+			p[i].y = pc[ parent[i] ].y + k * ((float) my_rand_r(seedp) / RAND_MAX - 0.5f);
+		}
+		error = graph_layout_force_level(g, k, t0/4, num_iterations/4, 
+		                                 num_processors, p);
+	}
+	
+	free(pc);
+	free(parent);
+	delete_graph(coarse);
+	return error;
+}
+
+double graph_layout_force_r
+		(const graph_t *g, int radius, int num_iterations, bool is_multilevel,
+		 int num_processors, coord_t *p, unsigned int *seedp){
+	assert(g);
+	assert(radius > 0);
+	assert(num_iterations >= 0);
+	assert(num_processors > 0);
+	assert(p);
+	
+	int i, n = graph_num_vertices(g);
+	if (n == 0){ return 0.0; }
+	
+	// Directed edges attract both ends
+	const graph_t *u = g;
+	if (graph_is_directed(g)){
+		graph_t *copy = new_graph(n, false, false);
+		if (!copy){ return -1.0; }
+		for (i=0; i < n; i++){
+			set_entry_t *adj;
+			for (adj = graph_adjacent_head(g, i); adj != NULL; adj = adj->next){
+				if (graph_add_edge(copy, i, adj->key)){
+					delete_graph(copy);
+					return -1.0;
+				}
+			}
+		}
+		u = copy;
+	}
+	
+	float k = GRAPH_LAYOUT_DISTANCE * radius;
+	error_t error = graph_layout_force_multilevel(u, k, num_iterations, 
+	                                              is_multilevel, num_processors, 
+	                                              p, seedp);
+	if (u != g){ delete_graph((graph_t *)u); }
+	if (error){ return -1.0; }
+	
+	// Translates points to the positive quadrant, as in the other layouts
+	float xmin = p[0].x, ymin = p[0].y, xmax = p[0].x, ymax = p[0].y;
+	for (i=0; i < n; i++){
+		if (p[i].x < xmin){ xmin = p[i].x; }
+		if (p[i].x > xmax){ xmax = p[i].x; }
+		if (p[i].y < ymin){ ymin = p[i].y; }
+		if (p[i].y > ymax){ ymax = p[i].y; }
+	}
+	for (i=0; i < n; i++){
+		p[i].x += radius - xmin;
+		p[i].y += radius - ymin;
+	}
+	
+	double width = xmax - xmin, height = ymax - ymin;
+	return (width > height ? width : height) + 2*radius;
+}
+
 /******************************* Printing *************************************/
 
 // Finds a circle that contains p1 and p2 as close as possible to pc.
@@ -322,63 +795,199 @@ void graph_find_circle
 	if (theta){ *theta = atan2(c.y - m.y, c.x - m.x) * (180/M_PI); }
 }
 
-void graph_print_svg_path(FILE *fp, const path_style_t style){
-	float x1 = style.from.x,    y1 = style.from.y;
-	float x2 = style.to.x,      y2 = style.to.y;
-	float xc = style.control.x, yc = style.control.y;
-				
+/***************************** SVG buffer *************************************/
+
+void graph_svg_buffer_init(graph_svg_buffer_t *buffer){
+	assert(buffer);
+	buffer->data = NULL;
+	buffer->size = 0;
+	buffer->capacity = 0;
+	buffer->is_failure = false;
+}
+
+void graph_svg_buffer_free(graph_svg_buffer_t *buffer){
+	assert(buffer);
+	free(buffer->data);
+	graph_svg_buffer_init(buffer);
+}
+
+// Ensures that size more chars may be written to the buffer. Returns false
+//if there is no memory.
+bool graph_svg_reserve(graph_svg_buffer_t *buffer, size_t size){
+	if (buffer->is_failure){ return false; }
+	if (buffer->size + size <= buffer->capacity){ return true; }
+	
+	size_t capacity = buffer->capacity > 0 ? buffer->capacity : 4096;
+	while (capacity < buffer->size + size){
+		capacity *= 2;
+	}
+	char *data = realloc(buffer->data, capacity);
+	if (!data){ buffer->is_failure = true; return false; }
+	
+	buffer->data = data;
+	buffer->capacity = capacity;
+	return true;
+}
+
+// The following functions assume that there is enough space reserved.
+void graph_svg_string(graph_svg_buffer_t *buffer, const char *str){
+	while (*str){
+		buffer->data[buffer->size++] = *str++;
+	}
+}
+
+void graph_svg_int(graph_svg_buffer_t *buffer, int value){
+	char digits[16];
+	int i = 0;
+	unsigned int u = value < 0 ? -(unsigned int)value : (unsigned int)value;
+	do {
+		digits[i++] = '0' + u % 10;
+		u /= 10;
+	} while (u > 0);
+	
+	if (value < 0){ buffer->data[buffer->size++] = '-'; }
+	while (i > 0){
+		buffer->data[buffer->size++] = digits[--i];
+	}
+}
+
+// Prints color alpha as an opacity between 0 and 1 with 3 decimals
+void graph_svg_opacity(graph_svg_buffer_t *buffer, short alpha){
+	int thousandths = (int)((float)alpha/COLOR_MAX * 1000 + 0.5f);
+	graph_svg_int(buffer, thousandths / 1000);
+	buffer->data[buffer->size++] = '.';
+	buffer->data[buffer->size++] = '0' + (thousandths / 100) % 10;
+	buffer->data[buffer->size++] = '0' + (thousandths / 10) % 10;
+	buffer->data[buffer->size++] = '0' + thousandths % 10;
+}
+
+void graph_svg_rgb(graph_svg_buffer_t *buffer, const color_t color){
+	graph_svg_string(buffer, "rgb(");
+	graph_svg_int(buffer, color[COLOR_R]);
+	graph_svg_string(buffer, ",");
+	graph_svg_int(buffer, color[COLOR_G]);
+	graph_svg_string(buffer, ",");
+	graph_svg_int(buffer, color[COLOR_B]);
+	graph_svg_string(buffer, ")");
+}
+
+// Writes the buffer to filename with a single call, and clears it
+error_t graph_svg_flush(graph_svg_buffer_t *buffer, const char *filename){
+	error_t error = ERROR_SUCCESS;
+	if (buffer->is_failure){
+		fprintf(stderr, "No memory to print %s\n", filename);
+		buffer->is_failure = false;
+		error = ERROR_NO_MEMORY;
+	} else {
+		FILE *fp = fopen(filename, "wt");
+		if (!fp || fwrite(buffer->data, 1, buffer->size, fp) != buffer->size){
+			fprintf(stderr, "Couldn't write %s\n", filename);
+			error = ERROR_UNDEFINED;
+		}
+		if (fp && fclose(fp) != 0){ error = ERROR_UNDEFINED; }
+	}
+	buffer->size = 0;
+	return error;
+}
+
+// Longest element printed, with all numbers using 11 chars
+#define GRAPH_SVG_MAX_ELEMENT 512
+
+void graph_svg_header(graph_svg_buffer_t *buffer, int width, int height){
+	if (!graph_svg_reserve(buffer, GRAPH_SVG_MAX_ELEMENT)){ return; }
+	graph_svg_string(buffer, "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\" ");
+	if (width > 0){
+		graph_svg_string(buffer, "width=\"");
+		graph_svg_int(buffer, width);
+		graph_svg_string(buffer, "px\" ");
+	}
+	if (height > 0){
+		graph_svg_string(buffer, "height=\"");
+		graph_svg_int(buffer, height);
+		graph_svg_string(buffer, "px\" ");
+	}
+	graph_svg_string(buffer, ">\n");
+}
+
+void graph_svg_footer(graph_svg_buffer_t *buffer){
+	if (!graph_svg_reserve(buffer, GRAPH_SVG_MAX_ELEMENT)){ return; }
+	graph_svg_string(buffer, "</svg>");
+}
+
+// Prints a point pair separated by comma
+void graph_svg_point(graph_svg_buffer_t *buffer, int x, int y){
+	graph_svg_int(buffer, x);
+	graph_svg_string(buffer, ",");
+	graph_svg_int(buffer, y);
+}
+
+void graph_svg_path
+		(graph_svg_buffer_t *buffer, const coord_t from, const coord_t to,
+		 const path_style_t style){
+	if (!graph_svg_reserve(buffer, GRAPH_SVG_MAX_ELEMENT)){ return; }
+	
 	// Print "d" attribute according to type
-	fprintf(fp, "  <path d=\"");
+	graph_svg_string(buffer, "  <path d=\"M");
+	graph_svg_point(buffer, (int)from.x, (int)from.y);
 	switch(style.type){
 		case GRAPH_STRAIGHT:
-			fprintf(fp, "M%d,%d L%d,%d", (int)x1, (int)y1, (int)x2, (int)y2);
+			graph_svg_string(buffer, " L");
 			break;
 		case GRAPH_PARABOLA:
-			fprintf(fp, "M%d,%d Q%d,%d %d,%d",
-							(int)x1, (int)y1, (int)xc, (int)yc, (int)x2, (int)y2);
+			graph_svg_string(buffer, " Q");
+			graph_svg_point(buffer, (int)style.control.x, (int)style.control.y);
+			graph_svg_string(buffer, " ");
 			break;
 		case GRAPH_CIRCULAR:
 			{
 				coord_t c;
 				float radius, theta;
-				graph_find_circle(style.from, style.to, style.control, 
-				                  c, &radius, &theta);
-				fprintf(fp, "M%d,%d A%d,%d %d 0,1 %d,%d", 
-								(int)x1, (int)y1, (int)radius, (int)radius, (int)theta,
-								(int)x2, (int)y2);
+				graph_find_circle(from, to, style.control, c, &radius, &theta);
+				graph_svg_string(buffer, " A");
+				graph_svg_point(buffer, (int)radius, (int)radius);
+				graph_svg_string(buffer, " ");
+				graph_svg_int(buffer, (int)theta);
+				graph_svg_string(buffer, " 0,1 ");
 			}
 			break;
 	}
-	fprintf(fp, "\" ");
-	
-	fprintf(fp, "fill=\"none\" ");
-	fprintf(fp, "stroke-width=\"%d\" ", style.width);
-	fprintf(fp, "stroke=\"rgb(%d,%d,%d)\" ", 
-					style.color[COLOR_R], 
-					style.color[COLOR_G], 
-					style.color[COLOR_B]);				
-	fprintf(fp, "stroke-opacity=\"%.3f\" ", 
-					(float)style.color[COLOR_A]/COLOR_MAX);
-	fprintf(fp, "/>\n");
-}
-
-void graph_print_svg_circle
-		(FILE *fp, const coord_t p, const circle_style_t style){
-	fprintf(fp, "  <circle ");
-	fprintf(fp, "cx=\"%d\" cy=\"%d\" ", (int)p.x, (int)p.y);
-	fprintf(fp, "r=\"%d\" ", style.radius);
-	fprintf(fp, "fill=\"rgb(%d,%d,%d)\" ", 
-					style.fill[COLOR_R], style.fill[COLOR_G], style.fill[COLOR_B]);
-	fprintf(fp, "fill-opacity=\"%.3f\" ", 
-					(float)style.fill[COLOR_A] / COLOR_MAX);
-	fprintf(fp, "stroke=\"rgb(%d,%d,%d)\" ", 
-					style.stroke[COLOR_R], style.stroke[COLOR_G], style.stroke[COLOR_B]);
-	fprintf(fp, "stroke-opacity=\"%.3f\" ", 
-					(float)style.stroke[COLOR_A] / COLOR_MAX);
-	fprintf(fp, "stroke-width=\"%d\" ", style.width);
-	fprintf(fp, "/>\n");
+	graph_svg_point(buffer, (int)to.x, (int)to.y);
+	graph_svg_string(buffer, "\" ");
+	
+	graph_svg_string(buffer, "fill=\"none\" stroke-width=\"");
+	graph_svg_int(buffer, style.width);
+	graph_svg_string(buffer, "\" stroke=\"");
+	graph_svg_rgb(buffer, style.color);
+	graph_svg_string(buffer, "\" stroke-opacity=\"");
+	graph_svg_opacity(buffer, style.color[COLOR_A]);
+	graph_svg_string(buffer, "\" />\n");
+}
+
+void graph_svg_circle
+		(graph_svg_buffer_t *buffer, const coord_t p, const circle_style_t style){
+	if (!graph_svg_reserve(buffer, GRAPH_SVG_MAX_ELEMENT)){ return; }
+	
+	graph_svg_string(buffer, "  <circle cx=\"");
+	graph_svg_int(buffer, (int)p.x);
+	graph_svg_string(buffer, "\" cy=\"");
+	graph_svg_int(buffer, (int)p.y);
+	graph_svg_string(buffer, "\" r=\"");
+	graph_svg_int(buffer, style.radius);
+	graph_svg_string(buffer, "\" fill=\"");
+	graph_svg_rgb(buffer, style.fill);
+	graph_svg_string(buffer, "\" fill-opacity=\"");
+	graph_svg_opacity(buffer, style.fill[COLOR_A]);
+	graph_svg_string(buffer, "\" stroke=\"");
+	graph_svg_rgb(buffer, style.stroke);
+	graph_svg_string(buffer, "\" stroke-opacity=\"");
+	graph_svg_opacity(buffer, style.stroke[COLOR_A]);
+	graph_svg_string(buffer, "\" stroke-width=\"");
+	graph_svg_int(buffer, style.width);
+	graph_svg_string(buffer, "\" />\n");
 }
 
+/******************************* SVG printing *********************************/
+
 void graph_print_svg
 		(const char *filename,
 		 int width, int height, 
@@ -386,45 +995,55 @@ void graph_print_svg
 		 const coord_t *p, 
 		 const circle_style_t *point_style,
 		 const path_style_t *edge_style){
+	graph_svg_buffer_t buffer;
+	graph_svg_buffer_init(&buffer);
+	graph_print_svg_buffered(&buffer, filename, width, height, g, p, 
+	                         point_style, edge_style);
+	graph_svg_buffer_free(&buffer);
+}
+
+error_t graph_print_svg_buffered
+		(graph_svg_buffer_t *buffer,
+		 const char *filename,
+		 int width, int height, 
+		 const graph_t *g, 
+		 const coord_t *p, 
+		 const circle_style_t *point_style,
+		 const path_style_t *edge_style){
+	assert(buffer);
 	assert(filename);
 	assert(g);
 	assert(p);
 	assert(point_style);
 	assert(edge_style);
 	
-	FILE *fp = fopen(filename, "wt");
-	if (!fp){ return; }
-	
-	fprintf(fp, "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\" ");
-	if (width > 0){ fprintf(fp, "width=\"%dpx\" ", width); }
-	if (height > 0){ fprintf(fp, "height=\"%dpx\" ", height); }
-	fprintf(fp, ">\n");
+	graph_svg_header(buffer, width, height);
 	
-	// Print edges
-	int i, j, n = graph_num_vertices(g), m = graph_num_edges(g);
-	int *adj = malloc(n * sizeof(*adj));
+	// Print edges, with coordinates given in the style
+	int i, n = graph_num_vertices(g);
+	int64_t m = graph_num_edges(g);
 	
-	int e=0; //Edge counter
+	int64_t e=0; //Edge counter
 	for (i=0; i < n; i++){
-		int ki = graph_adjacents(g, i, adj);
-		for (j=0; j < ki; j++){
-			int v = adj[j];
+		set_entry_t *adj;
+		for (adj = graph_adjacent_head(g, i); adj != NULL; adj = adj->next){
+			int v = adj->key;
 			if (graph_is_directed(g) || i < v){
-				graph_print_svg_path(fp, edge_style[e]);
+				graph_svg_path(buffer, edge_style[e].from, edge_style[e].to, 
+				               edge_style[e]);
 				e++;
 			}
 		}
 	}
 	assert(e == m);
-	free(adj);
 	
 	//Print vertices
 	for (i=0; i < n; i++){
-		graph_print_svg_circle(fp, p[i], point_style[i]);
+		graph_svg_circle(buffer, p[i], point_style[i]);
 	}
 	
-	fprintf(fp, "</svg>");
-	fclose(fp);
+	graph_svg_footer(buffer);
+	return graph_svg_flush(buffer, filename);
 }
 
 void graph_print_svg_one_style
@@ -438,46 +1057,39 @@ void graph_print_svg_one_style
 	assert(g);
 	assert(p);
 	
-	FILE *fp = fopen(filename, "wt");
-	if (!fp){ return; }
-	
-	fprintf(fp, "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\" ");
-	if (width > 0){ fprintf(fp, "width=\"%dpx\" ", width); }
-	if (height > 0){ fprintf(fp, "height=\"%dpx\" ", height); }
-	fprintf(fp, ">\n");
+	graph_svg_buffer_t buffer;
+	graph_svg_buffer_init(&buffer);
+	graph_svg_header(&buffer, width, height);
 	
 	// Print edges
-	int i, j, n = graph_num_vertices(g), m = graph_num_edges(g);
-	int *adj = malloc(n * sizeof(*adj));
+	int i, n = graph_num_vertices(g);
+	int64_t m = graph_num_edges(g);
+	
+	// Straight edges, as in the previous printer
+	path_style_t style = edge_style;
+	style.type = GRAPH_STRAIGHT;
 	
-	int e=0; //Edge counter
+	int64_t e=0; //Edge counter
 	for (i=0; i < n; i++){
-		int ki = graph_adjacents(g, i, adj);
-		for (j=0; j < ki; j++){
-			int v = adj[j];
+		set_entry_t *adj;
+		for (adj = graph_adjacent_head(g, i); adj != NULL; adj = adj->next){
+			int v = adj->key;
 			if (graph_is_directed(g) || i < v){
-				path_style_t style = {
-					{p[i].x, p[i].y}, {p[v].x, p[v].y}, {0.0f, 0.0f},
-					GRAPH_STRAIGHT,
-					edge_style.width,
-					{edge_style.color[0], edge_style.color[1], edge_style.color[2],
-					edge_style.color[3]}
-				};
-				graph_print_svg_path(fp, style);
+				graph_svg_path(&buffer, p[i], p[v], style);
 				e++;
 			}
 		}
 	}
 	assert(e == m);
-	free(adj);
 	
 	//Print vertices
 	for (i=0; i < n; i++){
-		graph_print_svg_circle(fp, p[i], point_style);
+		graph_svg_circle(&buffer, p[i], point_style);
 	}
 	
-	fprintf(fp, "</svg>");
-	fclose(fp);
+	graph_svg_footer(&buffer);
+	graph_svg_flush(&buffer, filename);
+	graph_svg_buffer_free(&buffer);
 }
 
 void graph_print_svg_some_styles
@@ -487,6 +1099,23 @@ void graph_print_svg_some_styles
 		 const coord_t *p, 
 		 const int *ps, const circle_style_t *point_style, int num_point_style,
 		 const int *es, const path_style_t *edge_style, int num_edge_style){
+	graph_svg_buffer_t buffer;
+	graph_svg_buffer_init(&buffer);
+	graph_print_svg_some_styles_buffered(&buffer, filename, width, height, g, p,
+	                                     ps, point_style, num_point_style,
+	                                     es, edge_style, num_edge_style);
+	graph_svg_buffer_free(&buffer);
+}
+
+error_t graph_print_svg_some_styles_buffered
+		(graph_svg_buffer_t *buffer,
+		 const char *filename,
+		 int width, int height,
+		 const graph_t *g, 
+		 const coord_t *p, 
+		 const int *ps, const circle_style_t *point_style, int num_point_style,
+		 const int *es, const path_style_t *edge_style, int num_edge_style){
+	assert(buffer);
 	assert(filename);
 	assert(g);
 	assert(p);
@@ -495,48 +1124,109 @@ void graph_print_svg_some_styles
 	assert(es); assert(edge_style); 
 	assert(num_edge_style > 0);
 	
-	FILE *fp = fopen(filename, "wt");
-	if (!fp){ return; }
-	
-	fprintf(fp, "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\" ");
-	if (width > 0){ fprintf(fp, "width=\"%dpx\" ", width); }
-	if (height > 0){ fprintf(fp, "height=\"%dpx\" ", height); }
-	fprintf(fp, ">\n");
+	graph_svg_header(buffer, width, height);
 	
 	// Print edges
-	int i, j, n = graph_num_vertices(g), m = graph_num_edges(g);
-	int *adj = malloc(n * sizeof(*adj));
+	int i, n = graph_num_vertices(g);
+	int64_t m = graph_num_edges(g);
 	
-	int e=0; //Edge counter
+	int64_t e=0; //Edge counter
 	for (i=0; i < n; i++){
-		int ki = graph_adjacents(g, i, adj);
-		for (j=0; j < ki; j++){
-			int v = adj[j];
+		set_entry_t *adj;
+		for (adj = graph_adjacent_head(g, i); adj != NULL; adj = adj->next){
+			int v = adj->key;
 			if (graph_is_directed(g) || i < v){
-				int s = es[e];
-				path_style_t style = {
-					{p[i].x, p[i].y}, {p[v].x, p[v].y}, 
-					{edge_style[s].control.x, edge_style[s].control.y},
-					edge_style[s].type,
-					edge_style[s].width,
-					{edge_style[s].color[0], 
-					 edge_style[s].color[1], 
-					 edge_style[s].color[2],
-					 edge_style[s].color[3]}
-				};
-				graph_print_svg_path(fp, style);
+				graph_svg_path(buffer, p[i], p[v], edge_style[ es[e] ]);
 				e++;
 			}
 		}
 	}
 	assert(e == m);
-	free(adj);
 	
 	//Print vertices
 	for (i=0; i < n; i++){
-		graph_print_svg_circle(fp, p[i], point_style[ ps[i] ]);
+		graph_svg_circle(buffer, p[i], point_style[ ps[i] ]);
+	}
+	
+	graph_svg_footer(buffer);
+	return graph_svg_flush(buffer, filename);
+}
+
+/***************************** Frame printing *********************************/
+
+typedef struct {
+	graph_frame_f print_frame;
+	void *data;
+	int index, num_frames, num_processors;
+	error_t error;         // Last error of a frame of this thread
+} graph_frame_task_params_t;
+
+void *graph_frame_task(void *args){
+	graph_frame_task_params_t *params = args;
+	
+	graph_svg_buffer_t buffer;
+	graph_svg_buffer_init(&buffer);
+	
+	int frame;
+	for (frame=params->index; frame < params->num_frames; 
+	     frame += params->num_processors){
+		error_t error = params->print_frame(frame, &buffer, params->data);
+		if (error){ params->error = error; }
+	}
+	
+	graph_svg_buffer_free(&buffer);
+	return NULL;
+}
+
+error_t graph_print_frames
+		(int num_frames, int num_processors, 
+		 graph_frame_f print_frame, void *data){
+	assert(num_frames >= 0);
+	assert(num_processors > 0);
+	assert(print_frame);
+	
+	if (num_processors > num_frames){ num_processors = num_frames; }
+	if (num_processors < 1){ return ERROR_SUCCESS; }
+	
+	pthread_t *thread = malloc(num_processors * sizeof(*thread));
+	bool *is_running = malloc(num_processors * sizeof(*is_running));
+	graph_frame_task_params_t *params = malloc(num_processors * sizeof(*params));
+	if (!(thread && is_running && params)){ num_processors = 1; }
+	
+	int i;
+	graph_frame_task_params_t single;
+	for (i=0; i < num_processors; i++){
+		graph_frame_task_params_t *param = params ? &params[i] : &single;
+		param->print_frame = print_frame;
+		param->data = data;
+		param->index = i;
+		param->num_frames = num_frames;
+		param->num_processors = num_processors;
+		param->error = ERROR_SUCCESS;
+	}
+	
+	// Thread 0 is the caller; frames of threads that fail are printed by it
+	for (i=1; i < num_processors; i++){
+		is_running[i] = 
+			pthread_create(&thread[i], NULL, graph_frame_task, &params[i]) == 0;
+	}
+	for (i=0; i < num_processors; i++){
+		if (i == 0 || !is_running[i]){
+			graph_frame_task(params ? &params[i] : &single);
+		}
+	}
+	for (i=1; i < num_processors; i++){
+		if (is_running[i]){ pthread_join(thread[i], NULL); }
+	}
+	
+	error_t error = ERROR_SUCCESS;
+	for (i=0; i < num_processors; i++){
+		graph_frame_task_params_t *param = params ? &params[i] : &single;
+		if (param->error){ error = param->error; }
 	}
 	
-	fprintf(fp, "</svg>");
-	fclose(fp);
+	free(thread);
+	free(is_running);
+	free(params);
+	return error;
 }
@@ -0,0 +1,539 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+#include "sorting.h"
+#include "stat.h"
+#include "ode.h"
+#include "graph.h"
+#include "graph_metric.h"
+#include "graph_propagation.h"
+#include "graph_mean_field.h"
+
+/** All approximations are integrated as a single system, with units being
+ * degree classes (HMF) or vertices (QMF and PAIR). State layout:
+ *
+ *   SIS: rho[units], and for PAIR also phi[edges]
+ *   SIR: s[units], i[units], and for PAIR also phi[edges], omega[edges]
+ *
+ * where for the directed edge e = (i, j), phi[e] = [S_i I_j] and
+ * omega[e] = [S_i S_j].
+ */
+typedef struct {
+	bool is_sir;
+	graph_mean_field_t type;
+	double alpha, beta;
+
+	int n;                 // Number of units
+	double population;     // Number of vertices
+
+	// HMF: fraction of vertices and degree of each class
+	double *weight, *degree;
+	double avg_degree;
+
+	// QMF and PAIR: sparse adjacency, with rev[e] the index of the edge in
+	//the opposite direction, and rate[j] = alpha/k_j
+	int64_t *offset;
+	int *adj, *rev;
+	double *rate;
+	int m;
+
+	// Temporaries: infection pressure on each vertex and derivative used to
+	//test for stationarity
+	double *pressure, *dx;
+	int size;
+} graph_mf_system_t;
+
+/******************************** Derivatives *********************************/
+
+void graph_mf_hmf_deriv(double *y, const double *x, int m, const void *params){
+	const graph_mf_system_t *sys = params;
+	int k, n = sys->n;
+
+	const double *infected = sys->is_sir ? x + n : x;
+	double theta = 0.0;
+	for (k=0; k < n; k++){
+		theta += sys->weight[k] * infected[k];
+	}
+	theta *= sys->alpha / sys->avg_degree;
+
+	if (sys->is_sir)
+	{
+		const double *s = x, *i = x + n;
+		for (k=0; k < n; k++){
+			double infection = s[k] * sys->degree[k] * theta;
+			y[k]     = - infection;
+			y[n + k] =   infection - sys->beta * i[k];
+		}
+	}
+	else
+	{
+		const double *rho = x;
+		for (k=0; k < n; k++){
+			y[k] = - sys->beta * rho[k] + (1 - rho[k]) * sys->degree[k] * theta;
+		}
+	}
+}
+
+// Computes pressure[i] = \sum_j g_ij rate[j] x[e_ij], where x is either a
+//vertex or an edge variable.
+void graph_mf_pressure
+		(const graph_mf_system_t *sys, const double *x, bool is_edge){
+	int i, n = sys->n;
+	int64_t e;
+	for (i=0; i < n; i++){
+		double p = 0.0;
+		for (e=sys->offset[i]; e < sys->offset[i+1]; e++){
+			int j = sys->adj[e];
+			p += sys->rate[j] * (is_edge ? x[e] : x[j]);
+		}
+		sys->pressure[i] = p;
+	}
+}
+
+void graph_mf_qmf_deriv(double *y, const double *x, int m, const void *params){
+	const graph_mf_system_t *sys = params;
+	int i, n = sys->n;
+
+	graph_mf_pressure(sys, sys->is_sir ? x + n : x, false);
+	const double *p = sys->pressure;
+
+	if (sys->is_sir)
+	{
+		const double *s = x, *inf = x + n;
+		for (i=0; i < n; i++){
+			y[i]     = - s[i] * p[i];
+			y[n + i] =   s[i] * p[i] - sys->beta * inf[i];
+		}
+	}
+	else
+	{
+		const double *rho = x;
+		for (i=0; i < n; i++){
+			y[i] = - sys->beta * rho[i] + (1 - rho[i]) * p[i];
+		}
+	}
+}
+
+// Conditional probability ratio x/s, neglecting vanishing susceptibles
+double graph_mf_ratio(double x, double s){
+	return s > 1e-12 ? x/s : 0.0;
+}
+
+void graph_mf_pair_deriv(double *y, const double *x, int m, const void *params){
+	const graph_mf_system_t *sys = params;
+	int i, n = sys->n;
+	int64_t e;
+	double beta = sys->beta;
+	const double *rate = sys->rate;
+	const double *p = sys->pressure;
+
+	if (sys->is_sir)
+	{
+		const double *s = x, *inf = x + n;
+		const double *phi = x + 2*n, *omega = x + 2*n + sys->m;
+		double *ds = y, *di = y + n;
+		double *dphi = y + 2*n, *domega = y + 2*n + sys->m;
+
+		graph_mf_pressure(sys, phi, true);
+		for (i=0; i < n; i++){
+			ds[i] = - p[i];
+			di[i] =   p[i] - beta * inf[i];
+
+			for (e=sys->offset[i]; e < sys->offset[i+1]; e++){
+				int j = sys->adj[e], r = sys->rev[e];
+				// [S_i S_j I_l] and [I_l S_i X_j] for l other than i and j
+				double from_j = graph_mf_ratio(p[j] - rate[i]*phi[r], s[j]);
+				double from_i = graph_mf_ratio(p[i] - rate[j]*phi[e], s[i]);
+
+				dphi[e]   = omega[e]*from_j - phi[e]*from_i
+				          - rate[j]*phi[e] - beta*phi[e];
+				domega[e] = - omega[e]*from_j - omega[e]*from_i;
+			}
+		}
+	}
+	else
+	{
+		const double *rho = x, *phi = x + n;
+		double *drho = y, *dphi = y + n;
+
+		graph_mf_pressure(sys, phi, true);
+		for (i=0; i < n; i++){
+			drho[i] = - beta * rho[i] + p[i];
+
+			for (e=sys->offset[i]; e < sys->offset[i+1]; e++){
+				int j = sys->adj[e], r = sys->rev[e];
+				double omega = 1 - rho[i] - phi[e];
+				double from_j = graph_mf_ratio(p[j] - rate[i]*phi[r], 1 - rho[j]);
+				double from_i = graph_mf_ratio(p[i] - rate[j]*phi[e], 1 - rho[i]);
+
+				// Gains from [I_i I_j] cure and [S_i S_j] infection, losses from
+				//cure of j and infection of i
+				dphi[e] = beta*(rho[j] - phi[e]) + omega*from_j
+				        - beta*phi[e] - rate[j]*phi[e] - phi[e]*from_i;
+			}
+		}
+	}
+}
+
+ode_deriv_f graph_mf_deriv(const graph_mf_system_t *sys){
+	switch(sys->type){
+		case GRAPH_MEAN_FIELD_HMF:  return graph_mf_hmf_deriv;
+		case GRAPH_MEAN_FIELD_QMF:  return graph_mf_qmf_deriv;
+		case GRAPH_MEAN_FIELD_PAIR: return graph_mf_pair_deriv;
+		default: assert(false); return NULL;
+	}
+}
+
+/******************************** Aggregation *********************************/
+
+// Fraction of vertices in each state
+void graph_mf_fraction
+		(const graph_mf_system_t *sys, const double *x, double *fraction){
+	int i, n = sys->n;
+	double s = 0.0, inf = 0.0;
+
+	if (sys->type == GRAPH_MEAN_FIELD_HMF)
+	{
+		for (i=0; i < n; i++){
+			if (sys->is_sir){ s += sys->weight[i] * x[i]; }
+			inf += sys->weight[i] * x[sys->is_sir ? n + i : i];
+		}
+	}
+	else
+	{
+		for (i=0; i < n; i++){
+			if (sys->is_sir){ s += x[i]; }
+			inf += x[sys->is_sir ? n + i : i];
+		}
+		s /= n;
+		inf /= n;
+	}
+
+	if (sys->is_sir)
+	{
+		fraction[GRAPH_SIR_S] = s;
+		fraction[GRAPH_SIR_I] = inf;
+		fraction[GRAPH_SIR_R] = 1 - s - inf;
+	}
+	else
+	{
+		fraction[GRAPH_SIS_S] = 1 - inf;
+		fraction[GRAPH_SIS_I] = inf;
+	}
+}
+
+bool graph_mf_stop(double t, const double *x, int m, int j, const void *params){
+	const graph_mf_system_t *sys = params;
+	double fraction[GRAPH_SIR_NUM_STATE];
+	graph_mf_fraction(sys, x, fraction);
+
+	int infectious = sys->is_sir ? GRAPH_SIR_I : GRAPH_SIS_I;
+	if (fraction[infectious] * sys->population < 0.5){ return true; }
+	if (sys->is_sir){ return false; }
+
+	// SIS may reach an endemic stationary state
+	graph_mf_deriv(sys)(sys->dx, x, 1, sys);
+	int i;
+	for (i=0; i < sys->size; i++){
+		if (fabs(sys->dx[i]) > GRAPH_MEAN_FIELD_TOLERANCE){ return false; }
+	}
+	return true;
+}
+
+typedef struct {
+	const graph_mf_system_t *sys;
+	graph_mean_field_sample_f sample;
+	void *data;
+} graph_mf_sample_data_t;
+
+void graph_mf_sample(double t, const double *x, int n, int m, void *_data){
+	graph_mf_sample_data_t *data = _data;
+	double fraction[GRAPH_SIR_NUM_STATE];
+	graph_mf_fraction(data->sys, x, fraction);
+	data->sample(t, fraction,
+	             data->sys->is_sir ? GRAPH_SIR_NUM_STATE : GRAPH_SIS_NUM_STATE,
+	             data->data);
+}
+
+/******************************* Construction *********************************/
+
+void graph_mf_delete(graph_mf_system_t *sys){
+	free(sys->weight);
+	free(sys->degree);
+	free(sys->offset);
+	free(sys->adj);
+	free(sys->rev);
+	free(sys->rate);
+	free(sys->pressure);
+	free(sys->dx);
+}
+
+// Sets degree classes, returning false if there is no memory or no edges
+bool graph_mf_init_hmf
+		(graph_mf_system_t *sys, const pair_t *freq, int num_degree){
+	int k;
+	sys->n = num_degree;
+	sys->weight = malloc(num_degree * sizeof(*sys->weight));
+	sys->degree = malloc(num_degree * sizeof(*sys->degree));
+	if (!sys->weight || !sys->degree){ return false; }
+
+	double total = 0.0;
+	for (k=0; k < num_degree; k++){
+		total += freq[k].value;
+	}
+
+	sys->avg_degree = 0.0;
+	for (k=0; k < num_degree; k++){
+		sys->degree[k] = freq[k].key;
+		sys->weight[k] = freq[k].value / total;
+		sys->avg_degree += sys->degree[k] * sys->weight[k];
+	}
+	sys->population = total;
+	return sys->avg_degree > 0.0;
+}
+
+bool graph_mf_init_quenched(graph_mf_system_t *sys, const graph_t *g){
+	int i, n = graph_num_vertices(g);
+	int64_t e;
+	sys->n = n;
+	sys->population = n;
+
+	if (graph_csr(g, &sys->offset, &sys->adj)){ return false; }
+	sys->m = sys->offset[n];
+
+	sys->rate = malloc(n * sizeof(*sys->rate));
+	if (!sys->rate){ return false; }
+	for (i=0; i < n; i++){
+		int ki = sys->offset[i+1] - sys->offset[i];
+		sys->rate[i] = ki > 0 ? sys->alpha / ki : 0.0;
+
+		// Sorted rows allow finding reverse edges by binary search
+		qsort(sys->adj + sys->offset[i], ki, sizeof(*sys->adj), comp_int_asc);
+	}
+
+	if (sys->type == GRAPH_MEAN_FIELD_PAIR){
+		sys->rev = malloc(sys->m * sizeof(*sys->rev));
+		if (!sys->rev && sys->m > 0){ return false; }
+		for (i=0; i < n; i++){
+			for (e=sys->offset[i]; e < sys->offset[i+1]; e++){
+				int j = sys->adj[e];
+				int kj = sys->offset[j+1] - sys->offset[j];
+				int *r = bsearch(&i, sys->adj + sys->offset[j], kj,
+				                 sizeof(*sys->adj), comp_int_asc);
+				assert(r);
+				sys->rev[e] = r - sys->adj;
+			}
+		}
+	}
+
+	sys->pressure = malloc(n * sizeof(*sys->pressure));
+	return sys->pressure != NULL;
+}
+
+int graph_mf_size(const graph_mf_system_t *sys){
+	int units = sys->is_sir ? 2*sys->n : sys->n;
+	int edges = sys->is_sir ? 2*sys->m : sys->m;
+	return units + (sys->type == GRAPH_MEAN_FIELD_PAIR ? edges : 0);
+}
+
+// Initial state of each vertex from its probability of being infectious
+void graph_mf_init_state
+		(const graph_mf_system_t *sys, const double *infected, double *x){
+	int i, n = sys->n;
+	int64_t e;
+
+	if (sys->is_sir)
+	{
+		for (i=0; i < n; i++){
+			x[i] = 1 - infected[i];
+			x[n + i] = infected[i];
+		}
+	}
+	else
+	{
+		memcpy(x, infected, n * sizeof(*x));
+	}
+
+	if (sys->type == GRAPH_MEAN_FIELD_PAIR){
+		double *phi = x + (sys->is_sir ? 2*n : n);
+		double *omega = phi + sys->m;
+		for (i=0; i < n; i++){
+			for (e=sys->offset[i]; e < sys->offset[i+1]; e++){
+				int j = sys->adj[e];
+				phi[e] = (1 - infected[i]) * infected[j];
+				if (sys->is_sir){ omega[e] = (1 - infected[i]) * (1 - infected[j]); }
+			}
+		}
+	}
+}
+
+/******************************* Integration **********************************/
+
+double graph_mf_run
+		(graph_mf_system_t *sys, double *x, double dt, double t_max,
+		 graph_mean_field_sample_f sample, void *data, double *fraction){
+	sys->dx = malloc(sys->size * sizeof(*sys->dx));
+	if (!sys->dx){ return -1.0; }
+
+	graph_mf_sample_data_t sample_data = {sys, sample, data};
+	double t_stop;
+	int num_steps = ode_dopri5(graph_mf_deriv(sys), graph_mf_stop, sys,
+	                           x, sys->size, 1, dt, t_max, &t_stop, NULL,
+	                           sample ? graph_mf_sample : NULL, &sample_data);
+	if (num_steps < 0){ return -1.0; }
+
+	if (fraction){ graph_mf_fraction(sys, x, fraction); }
+	return t_stop;
+}
+
+double graph_mf_graph
+		(const graph_t *g, graph_mean_field_t type, bool is_sir,
+		 double alpha, double beta, const short *init_state, double dt,
+		 double t_max, graph_mean_field_sample_f sample, void *data,
+		 double *fraction){
+	assert(g);
+	assert(!graph_is_directed(g));
+	assert(type >= 0 && type < GRAPH_MEAN_FIELD_NUM_TYPE);
+	assert(init_state);
+
+	int i, n = graph_num_vertices(g);
+	short infectious = is_sir ? GRAPH_SIR_I : GRAPH_SIS_I;
+
+	graph_mf_system_t sys;
+	memset(&sys, 0, sizeof(sys));
+	sys.is_sir = is_sir;
+	sys.type = type;
+	sys.alpha = alpha;
+	sys.beta = beta;
+
+	double t = -1.0;
+	double *infected = NULL, *x = NULL;
+
+	if (type == GRAPH_MEAN_FIELD_HMF)
+	{
+		int *degree = malloc(n * sizeof(*degree));
+		if (!degree){ return -1.0; }
+		graph_degree(g, degree);
+
+		int num_degree = 0;
+		pair_t *freq = stat_frequencies(degree, n, &num_degree);
+		bool is_ok = freq && graph_mf_init_hmf(&sys, freq, num_degree);
+
+		// Fraction of infectious vertices in each degree class
+		if (is_ok){ infected = malloc(num_degree * sizeof(*infected)); }
+		if (infected){
+			memset(infected, 0, num_degree * sizeof(*infected));
+			for (i=0; i < n; i++){
+				if (init_state[i] == infectious){
+					pair_t key = {degree[i], 0};
+					pair_t *p = bsearch(&key, freq, num_degree, sizeof(*freq),
+					                    comp_key_asc);
+					infected[p - freq] += 1.0 / p->value;
+				}
+			}
+		}
+
+		free(freq);
+		free(degree);
+		if (!is_ok){ goto cleanup; }
+	}
+	else
+	{
+		if (!graph_mf_init_quenched(&sys, g)){ goto cleanup; }
+		infected = malloc(n * sizeof(*infected));
+		if (infected){
+			for (i=0; i < n; i++){
+				infected[i] = init_state[i] == infectious ? 1.0 : 0.0;
+			}
+		}
+	}
+
+	sys.size = graph_mf_size(&sys);
+	x = malloc(sys.size * sizeof(*x));
+	if (!infected || !x){ goto cleanup; }
+
+	graph_mf_init_state(&sys, infected, x);
+	t = graph_mf_run(&sys, x, dt, t_max, sample, data, fraction);
+
+cleanup:
+	free(x);
+	free(infected);
+	graph_mf_delete(&sys);
+	return t;
+}
+
+double graph_mean_field_sis
+		(const graph_t *g, graph_mean_field_t type, graph_sis_params_t params,
+		 const short *init_state, double dt, double t_max,
+		 graph_mean_field_sample_f sample, void *data, double *fraction){
+	return graph_mf_graph(g, type, false, params.alpha, params.beta,
+	                      init_state, dt, t_max, sample, data, fraction);
+}
+
+double graph_mean_field_sir
+		(const graph_t *g, graph_mean_field_t type, graph_sir_params_t params,
+		 const short *init_state, double dt, double t_max,
+		 graph_mean_field_sample_f sample, void *data, double *fraction){
+	return graph_mf_graph(g, type, true, params.alpha, params.beta,
+	                      init_state, dt, t_max, sample, data, fraction);
+}
+
+double graph_mf_distribution
+		(const pair_t *freq, int num_degree, bool is_sir,
+		 double alpha, double beta, double rho0, double dt, double t_max,
+		 graph_mean_field_sample_f sample, void *data, double *fraction){
+	assert(freq);
+	assert(num_degree > 0);
+	assert(rho0 >= 0.0 && rho0 <= 1.0);
+
+	graph_mf_system_t sys;
+	memset(&sys, 0, sizeof(sys));
+	sys.is_sir = is_sir;
+	sys.type = GRAPH_MEAN_FIELD_HMF;
+	sys.alpha = alpha;
+	sys.beta = beta;
+
+	double t = -1.0;
+	double *infected = NULL, *x = NULL;
+	if (!graph_mf_init_hmf(&sys, freq, num_degree)){ goto cleanup; }
+
+	sys.size = graph_mf_size(&sys);
+	infected = malloc(num_degree * sizeof(*infected));
+	x = malloc(sys.size * sizeof(*x));
+	if (!infected || !x){ goto cleanup; }
+
+	int k;
+	for (k=0; k < num_degree; k++){
+		infected[k] = rho0;
+	}
+
+	graph_mf_init_state(&sys, infected, x);
+	t = graph_mf_run(&sys, x, dt, t_max, sample, data, fraction);
+
+cleanup:
+	free(x);
+	free(infected);
+	graph_mf_delete(&sys);
+	return t;
+}
+
+double graph_hmf_sis_distribution
+		(const pair_t *freq, int num_degree, graph_sis_params_t params,
+		 double rho0, double dt, double t_max,
+		 graph_mean_field_sample_f sample, void *data, double *fraction){
+	return graph_mf_distribution(freq, num_degree, false,
+	                             params.alpha, params.beta, rho0, dt, t_max,
+	                             sample, data, fraction);
+}
+
+double graph_hmf_sir_distribution
+		(const pair_t *freq, int num_degree, graph_sir_params_t params,
+		 double rho0, double dt, double t_max,
+		 graph_mean_field_sample_f sample, void *data, double *fraction){
+	return graph_mf_distribution(freq, num_degree, true,
+	                             params.alpha, params.beta, rho0, dt, t_max,
+	                             sample, data, fraction);
+}
@@ -36,18 +36,20 @@ int graph_undirected_components(const graph_t *g, int *label){
 	memset(is_visited, 0, n * sizeof(*is_visited));
 	
 	queue[tail++] = 0;
+	is_visited[0] = true;
 	
 	int count, smallest=0;
 	for (count=0; smallest < n;count++){
 		while (tail > head){
 			int u = queue[head++];
-			is_visited[u] = true;
 			label[u] = count;
 			
+			// Vertices are marked when enqueued, so that each is enqueued once
 			set_entry_t *adj = graph_adjacent_head(g, u);
 			for (;adj != NULL; adj = adj->next){
 				int v = adj->key;
 				if (!is_visited[v]){
+					is_visited[v] = true;
 					queue[tail++] = v;
 				}
 			}
@@ -57,7 +59,10 @@ int graph_undirected_components(const graph_t *g, int *label){
 			smallest++;
 		}
 		head = tail = 0;
-		queue[tail++] = smallest;
+		if (smallest < n){
+			queue[tail++] = smallest;
+			is_visited[smallest] = true;
+		}
 	}
 	
 	free(is_visited);
@@ -130,17 +135,19 @@ graph_t * graph_giant_component(const graph_t *g){
 	}
 	free(freq);
 	
-	list_t *vertices = new_list(max_size);
+	int *vertices = malloc(max_size * sizeof(*vertices));
 	if (!vertices){ free(label); return NULL; }
+	int k = 0;
 	for (i=0; i < n; i++){
 		if (label[i] == max_comp){
-			list_push(vertices, i);
+			vertices[k++] = i;
 		}
 	}
 	free(label);
 	
-	graph_t *giant = graph_subset(g, vertices);
-	delete_list(vertices);
+	graph_t *giant = graph_induced_subgraph(g, vertices, max_size, NULL,
+		GRAPH_NUM_PROCESSORS);
+	free(vertices);
 	
 	return giant;
 }
@@ -155,7 +162,11 @@ void graph_degree(const graph_t *g, int *degree){
 	for (i=0; i < n; i++){
 		degree[i] = graph_num_adjacents(g, i);
 	}
-	if (graph_is_directed(g)){
+	if (graph_is_directed(g) && graph_has_in_adjacency(g)){
+		for (i=0; i < n; i++){
+			degree[i] += graph_num_in_adjacents(g, i);
+		}
+	} else if (graph_is_directed(g)){
 		for (i=0; i < n; i++){
 			set_entry_t *adj = graph_adjacent_head(g, i);
 			for (; adj != NULL; adj = adj->next){
@@ -172,6 +183,14 @@ void graph_directed_degree(const graph_t *g, int *in_degree, int *out_degree){
 	assert(graph_is_directed(g));
 	
 	int i, n = graph_num_vertices(g);
+	if (graph_has_in_adjacency(g)){
+		for (i=0; i < n; i++){
+			in_degree[i] = graph_num_in_adjacents(g, i);
+			out_degree[i] = graph_num_adjacents(g, i);
+		}
+		return;
+	}
+	
 	memset(in_degree, 0, n * sizeof(*in_degree));
 	memset(out_degree, 0, n * sizeof(*out_degree));
 	
@@ -210,21 +229,21 @@ void graph_clustering(const graph_t *g, double *clustering){
 					}
 				}
 			}
-			clustering[i] /= ki * (ki - 1);
+			clustering[i] /= (double)ki * (ki - 1);
 		}
 	}
 }
 
 void graph_num_triplets
-		(const graph_t *g, int *_num_triplet, int *_num_triangle){
+		(const graph_t *g, int64_t *_num_triplet, int64_t *_num_triangle){
 	assert(g);
 	assert(!graph_is_directed(g));
 	assert(_num_triplet || _num_triangle);
 	
 	int i, n = graph_num_vertices(g);
 	
-	int num_triplet = 0;
-	int num_closed = 0;
+	int64_t num_triplet = 0;
+	int64_t num_closed = 0;
 	
 	for (i=0; i < n; i++){
 		set_entry_t *adj = graph_adjacent_head(g, i);
@@ -246,7 +265,7 @@ void graph_num_triplets
 }
 
 double graph_transitivy(const graph_t *g){
-	int num_triplet, num_triangle;
+	int64_t num_triplet, num_triangle;
 	graph_num_triplets(g, &num_triplet, &num_triangle);
 	
 	return (3.0*num_triangle)/num_triplet;
@@ -255,7 +274,7 @@ double graph_transitivy(const graph_t *g){
 /************************ Geodesic distance metrics ***************************/
 
 void graph_geodesic_paths
-		(const graph_t *g, int s, int *distance, int *sequence, int *path_count,
+		(const graph_t *g, int s, int *distance, int *sequence, double *path_count,
 		 list_t **predecessor){
 	assert(g);
 	int i, n = graph_num_vertices(g);
@@ -272,9 +291,12 @@ void graph_geodesic_paths
 		// sequence stores the vertices in the order they were visited
 		memset(sequence, 0, n * sizeof(*sequence));
 		
-		// path_count counts the number of paths that cross each vertex
-		memset(path_count, 0, n * sizeof(*path_count));
-		path_count[s] = 1;
+		// path_count counts the number of paths that cross each vertex, which
+		//grows exponentially with distance in grids and dense graphs
+		for (i=0; i < n; i++){
+			path_count[i] = 0.0;
+		}
+		path_count[s] = 1.0;
 		
 		for (i=0; i < n; i++){
 			list_clean(predecessor[i]);
@@ -372,6 +394,37 @@ void graph_geodesic_vertex(const graph_t *g, int i, int *distance){
 	graph_geodesic_paths(g, i, distance, NULL, NULL, NULL);
 }
 
+void graph_in_geodesic_vertex(const graph_t *g, int s, int *distance){
+	assert(g);
+	assert(graph_has_in_adjacency(g));
+	assert(distance);
+	int i, n = graph_num_vertices(g);
+	assert(s >= 0 && s < n);
+	
+	int *queue = malloc(n * sizeof(*queue));
+	if (!queue){ return; }
+	
+	for (i=0; i < n; i++){ distance[i] = -1; }
+	distance[s] = 0;
+	
+	// Breadth-first search following edges backwards
+	int head = 0, tail = 0;
+	queue[tail++] = s;
+	while (tail > head){
+		int v = queue[head++];
+		set_entry_t *adj = graph_in_adjacent_head(g, v);
+		for (; adj != NULL; adj = adj->next){
+			int w = adj->key;
+			if (distance[w] < 0){
+				distance[w] = distance[v] + 1;
+				queue[tail++] = w;
+			}
+		}
+	}
+	
+	free(queue);
+}
+
 void graph_geodesic_all(const graph_t *g, int **distance){
 	assert(g);
 	assert(distance);
@@ -383,19 +436,19 @@ void graph_geodesic_all(const graph_t *g, int **distance){
 	}
 }
 
-int *graph_geodesic_distribution(const graph_t *g, int *_diameter){
+int64_t *graph_geodesic_distribution(const graph_t *g, int *_diameter){
 	assert(g);
 	
 	int i, j, n = graph_num_vertices(g);
 	
-	int *distribution = malloc(n * sizeof(*distribution));
+	int64_t *distribution = malloc(n * sizeof(*distribution));
 	if (!distribution){ return NULL; }
 	memset(distribution, 0, n * sizeof(*distribution));
 	
 	int *distance = malloc(n * sizeof(*distance));
 	
 	int diameter = 0;
-	int unreachable_paths = 0;
+	int64_t unreachable_paths = 0;
 	
 	for (i=0; i < n; i++){
 		graph_geodesic_vertex(g, i, distance);
@@ -415,6 +468,517 @@ int *graph_geodesic_distribution(const graph_t *g, int *_diameter){
 	return distribution;
 }
 
+/******************** Weighted geodesic distance metrics **********************/
+
+/** Pairing heap
+ * Min-heap of vertices ordered by key[v], stored in arrays indexed by vertex.
+ * Each tree node keeps its first child and next sibling, and prev is the 
+ * parent of a first child or the previous sibling of the others, so that a 
+ * node can be cut from its tree in O(1) when its key decreases. 
+ * 
+ * Insertion and decrease-key link a single tree to the root in O(1), and
+ * removing the minimum merges the root's children in two passes, in amortized
+ * O(log n).
+ */
+typedef struct {
+	const double *key;
+	int *child, *sibling, *prev;
+	int root;
+} graph_pairing_heap_t;
+
+// Links trees with roots a and b, returning the root with the smallest key.
+int graph_heap_link(graph_pairing_heap_t *h, int a, int b){
+	if (a < 0){ return b; }
+	if (b < 0){ return a; }
+	if (h->key[b] < h->key[a]){ int tmp = a; a = b; b = tmp; }
+	
+	// b becomes a's first child
+	h->sibling[b] = h->child[a];
+	if (h->child[a] >= 0){ h->prev[h->child[a]] = b; }
+	h->prev[b] = a;
+	h->child[a] = b;
+	return a;
+}
+
+void graph_heap_insert(graph_pairing_heap_t *h, int v){
+	h->child[v] = h->sibling[v] = h->prev[v] = -1;
+	h->root = graph_heap_link(h, h->root, v);
+}
+
+// Reorders v after its key was decreased.
+void graph_heap_decrease(graph_pairing_heap_t *h, int v){
+	if (v == h->root){ return; }
+	int p = h->prev[v];
+	if (h->child[p] == v){ h->child[p] = h->sibling[v]; }
+	else                 { h->sibling[p] = h->sibling[v]; }
+	if (h->sibling[v] >= 0){ h->prev[h->sibling[v]] = p; }
+	
+	h->sibling[v] = h->prev[v] = -1;
+	h->root = graph_heap_link(h, h->root, v);
+}
+
+int graph_heap_pop(graph_pairing_heap_t *h){
+	int min = h->root;
+	
+	// First pass: link children in pairs from left to right, stacking the
+	//results through their sibling field.
+	int stack = -1, next = h->child[min];
+	while (next >= 0){
+		int a = next, b = h->sibling[a];
+		next = b >= 0 ? h->sibling[b] : -1;
+		a = graph_heap_link(h, a, b);
+		h->prev[a] = -1;
+		h->sibling[a] = stack;
+		stack = a;
+	}
+	
+	// Second pass: link stacked trees from right to left.
+	int root = -1;
+	while (stack >= 0){
+		next = h->sibling[stack];
+		h->sibling[stack] = -1;
+		root = graph_heap_link(h, root, stack);
+		stack = next;
+	}
+	
+	h->root = root;
+	return min;
+}
+
+/* Computes weighted distances from s with Dijkstra's algorithm. If sequence,
+ * path_count and predecessor are not NULL, also stores the vertices in the 
+ * order they were settled, the number of weighted geodesic paths from s to 
+ * each vertex, and their predecessors in those paths.
+ * Returns the number of vertices reachable from s, or -1 if there's no memory.
+ */
+int graph_dijkstra_paths
+		(const graph_t *g, int s, double *distance, int *sequence,
+		 double *path_count, list_t **predecessor){
+	assert(g);
+	int i, n = graph_num_vertices(g);
+	assert(s >= 0 && s < n);
+	assert(distance);
+	
+	bool is_betweenness = sequence && path_count && predecessor;
+	
+	graph_pairing_heap_t heap = {distance, NULL, NULL, NULL, -1};
+	heap.child = malloc(n * sizeof(*heap.child));
+	heap.sibling = malloc(n * sizeof(*heap.sibling));
+	heap.prev = malloc(n * sizeof(*heap.prev));
+	bool *is_settled = calloc(n, sizeof(*is_settled));
+	if (!heap.child || !heap.sibling || !heap.prev || !is_settled){
+		free(heap.child); free(heap.sibling); free(heap.prev); free(is_settled);
+		return -1;
+	}
+	
+	for (i=0; i < n; i++){ distance[i] = INFINITY; }
+	distance[s] = 0.0;
+	if (is_betweenness){
+		for (i=0; i < n; i++){
+			path_count[i] = 0.0;
+			list_clean(predecessor[i]);
+		}
+		path_count[s] = 1.0;
+	}
+	graph_heap_insert(&heap, s);
+	
+	int num_settled = 0;
+	while (heap.root >= 0){
+		int v = graph_heap_pop(&heap);
+		is_settled[v] = true;
+		if (is_betweenness){ sequence[num_settled] = v; }
+		num_settled++;
+		
+		set_entry_t *adj = graph_adjacent_head(g, v);
+		for (; adj != NULL; adj = adj->next){
+			int w = adj->key;
+			if (is_settled[w]){ continue; }
+			
+			double weight = graph_adjacent_weight(g, v, adj);
+			assert(weight >= 0.0);
+			double d = distance[v] + weight;
+			if (d < distance[w]){
+				bool is_queued = !isinf(distance[w]);
+				distance[w] = d;
+				if (is_queued){ graph_heap_decrease(&heap, w); }
+				else          { graph_heap_insert(&heap, w); }
+				
+				if (is_betweenness){
+					path_count[w] = path_count[v];
+					list_clean(predecessor[w]);
+					list_push(predecessor[w], v);
+				}
+			} else if (is_betweenness && d == distance[w]){
+				path_count[w] += path_count[v];
+				list_push(predecessor[w], v);
+			}
+		}
+	}
+	
+	free(heap.child);
+	free(heap.sibling);
+	free(heap.prev);
+	free(is_settled);
+	return num_settled;
+}
+
+void graph_weighted_geodesic_vertex(const graph_t *g, int i, double *distance){
+	assert(g);
+	assert(distance);
+	
+	graph_dijkstra_paths(g, i, distance, NULL, NULL, NULL);
+}
+
+/** Delta-stepping
+ * All threads run graph_delta_stepping_task in lockstep, separated by barriers.
+ * In each step, a thread only writes the state of vertices it owns and its own
+ * buffers, and reads the buffers filled by the other threads in the previous 
+ * step.
+ * 
+ * Buckets are stored in a circular array of lists: as distances can only
+ * grow by max_weight from the current bucket, num_slots buckets are enough 
+ * to hold all tentative distances. A vertex whose distance decreased may be 
+ * left in its old bucket, so entries are valid only if they match the vertex's
+ * bucket.
+ * 
+ * If a thread fails allocating memory it drops the work, so that all threads
+ * still follow the same steps, and the result is discarded at the end.
+ */
+typedef struct {
+	int vertex;
+	double distance;
+} graph_delta_request_t;
+
+typedef struct {
+	list_t **bucket;        // Circular array of buckets with owned vertices
+	list_t *frontier;       // Vertices removed from the current bucket
+	list_t *settled;        // All vertices removed from the current bucket
+	graph_delta_request_t **request; // Requests to each thread
+	int *num_request, *max_request;
+	int active, next;
+	bool failed;
+} graph_delta_worker_t;
+
+typedef struct {
+	const graph_t *g;
+	double delta;
+	int num_slots, num_processors;
+	
+	double *distance;
+	long *bucket_of;
+	bool *is_queued;        // Vertex is in the list of its bucket
+	bool *is_settled;       // Vertex is in its worker's settled list
+	
+	graph_delta_worker_t *worker;
+	pthread_barrier_t barrier;
+	pthread_mutex_t start;
+} graph_delta_stepping_t;
+
+typedef struct {
+	graph_delta_stepping_t *d;
+	int index;
+} graph_delta_stepping_params_t;
+
+long graph_delta_bucket(const graph_delta_stepping_t *d, double distance){
+	return (long)floor(distance / d->delta);
+}
+
+void graph_delta_push(graph_delta_stepping_t *d, int t, int v){
+	long b = d->bucket_of[v];
+	if (list_push(d->worker[t].bucket[b % d->num_slots], v) != ERROR_SUCCESS){
+		d->worker[t].failed = true;
+	}
+}
+
+// Moves valid entries of the current bucket to the frontier of thread t.
+void graph_delta_gather(graph_delta_stepping_t *d, int t, long current){
+	graph_delta_worker_t *worker = &d->worker[t];
+	list_t *bucket = worker->bucket[current % d->num_slots];
+	
+	list_clean(worker->frontier);
+	int i, size = list_size(bucket);
+	for (i=0; i < size; i++){
+		int v = list_get(bucket, i);
+		if (!d->is_queued[v] || d->bucket_of[v] != current){ continue; }
+		
+		d->is_queued[v] = false;
+		if (list_push(worker->frontier, v) != ERROR_SUCCESS){
+			worker->failed = true;
+		}
+		if (!d->is_settled[v]){
+			d->is_settled[v] = true;
+			if (list_push(worker->settled, v) != ERROR_SUCCESS){
+				worker->failed = true;
+			}
+		}
+	}
+	list_clean(bucket);
+	worker->active = list_size(worker->frontier);
+}
+
+// Makes requests for the light or heavy edges of vertices in list.
+void graph_delta_request
+		(graph_delta_stepping_t *d, int t, const list_t *list, bool is_light){
+	graph_delta_worker_t *worker = &d->worker[t];
+	int i, size = list_size(list);
+	for (i=0; i < size; i++){
+		int v = list_get(list, i);
+		set_entry_t *adj = graph_adjacent_head(d->g, v);
+		for (; adj != NULL; adj = adj->next){
+			double weight = graph_adjacent_weight(d->g, v, adj);
+			if ((weight <= d->delta) != is_light){ continue; }
+			
+			int w = adj->key, owner = w % d->num_processors;
+			if (worker->num_request[owner] == worker->max_request[owner]){
+				int max = 2 * worker->max_request[owner] + 16;
+				graph_delta_request_t *request;
+				request = realloc(worker->request[owner], max * sizeof(*request));
+				if (!request){ worker->failed = true; continue; }
+				worker->request[owner] = request;
+				worker->max_request[owner] = max;
+			}
+			graph_delta_request_t r = {w, d->distance[v] + weight};
+			worker->request[owner][worker->num_request[owner]++] = r;
+		}
+	}
+}
+
+// Relaxes the requests of all threads to vertices owned by thread t.
+void graph_delta_relax(graph_delta_stepping_t *d, int t){
+	int u, i;
+	for (u=0; u < d->num_processors; u++){
+		graph_delta_worker_t *other = &d->worker[u];
+		for (i=0; i < other->num_request[t]; i++){
+			graph_delta_request_t r = other->request[t][i];
+			if (!(r.distance < d->distance[r.vertex])){ continue; }
+			
+			d->distance[r.vertex] = r.distance;
+			long b = graph_delta_bucket(d, r.distance);
+			if (!d->is_queued[r.vertex] || d->bucket_of[r.vertex] != b){
+				d->bucket_of[r.vertex] = b;
+				d->is_queued[r.vertex] = true;
+				graph_delta_push(d, t, r.vertex);
+			}
+		}
+	}
+}
+
+bool graph_delta_any_active(const graph_delta_stepping_t *d){
+	int t;
+	for (t=0; t < d->num_processors; t++){
+		if (d->worker[t].active > 0){ return true; }
+	}
+	return false;
+}
+
+void *graph_delta_stepping_task(void *args){
+	graph_delta_stepping_params_t params;
+	params = *(graph_delta_stepping_params_t *)args;
+	graph_delta_stepping_t *d = params.d;
+	int t = params.index;
+	graph_delta_worker_t *worker = &d->worker[t];
+	
+	// Waits until all threads were launched
+	pthread_mutex_lock(&d->start);
+	pthread_mutex_unlock(&d->start);
+	
+	int u, k;
+	long current = 0;
+	while (true){
+		// Relaxes light edges until the current bucket stays empty
+		while (true){
+			graph_delta_gather(d, t, current);
+			pthread_barrier_wait(&d->barrier);
+			if (!graph_delta_any_active(d)){ break; }
+			
+			graph_delta_request(d, t, worker->frontier, true);
+			pthread_barrier_wait(&d->barrier);
+			graph_delta_relax(d, t);
+			pthread_barrier_wait(&d->barrier);
+			for (u=0; u < d->num_processors; u++){ worker->num_request[u] = 0; }
+		}
+		
+		// Relaxes heavy edges of all vertices removed from the bucket
+		graph_delta_request(d, t, worker->settled, false);
+		pthread_barrier_wait(&d->barrier);
+		graph_delta_relax(d, t);
+		pthread_barrier_wait(&d->barrier);
+		for (u=0; u < d->num_processors; u++){ worker->num_request[u] = 0; }
+		int size = list_size(worker->settled);
+		for (k=0; k < size; k++){
+			d->is_settled[list_get(worker->settled, k)] = false;
+		}
+		list_clean(worker->settled);
+		
+		// Advances to the next non-empty bucket of any thread
+		worker->next = d->num_slots;
+		for (k=1; k < d->num_slots; k++){
+			if (list_size(worker->bucket[(current + k) % d->num_slots]) > 0){
+				worker->next = k;
+				break;
+			}
+		}
+		pthread_barrier_wait(&d->barrier);
+		int next = d->num_slots;
+		for (u=0; u < d->num_processors; u++){
+			if (d->worker[u].next < next){ next = d->worker[u].next; }
+		}
+		if (next == d->num_slots){ break; }
+		current += next;
+	}
+	
+	return NULL;
+}
+
+void delete_graph_delta_workers(graph_delta_worker_t *worker, int num_processors,
+                                int num_slots){
+	if (!worker){ return; }
+	int t, k;
+	for (t=0; t < num_processors; t++){
+		if (worker[t].bucket){
+			for (k=0; k < num_slots; k++){
+				if (worker[t].bucket[k]){ delete_list(worker[t].bucket[k]); }
+			}
+			free(worker[t].bucket);
+		}
+		if (worker[t].frontier){ delete_list(worker[t].frontier); }
+		if (worker[t].settled){ delete_list(worker[t].settled); }
+		if (worker[t].request){
+			for (k=0; k < num_processors; k++){ free(worker[t].request[k]); }
+			free(worker[t].request);
+		}
+		free(worker[t].num_request);
+		free(worker[t].max_request);
+	}
+	free(worker);
+}
+
+graph_delta_worker_t *new_graph_delta_workers(int num_processors, int num_slots){
+	graph_delta_worker_t *worker = calloc(num_processors, sizeof(*worker));
+	if (!worker){ return NULL; }
+	
+	int t, k;
+	for (t=0; t < num_processors; t++){
+		worker[t].bucket = calloc(num_slots, sizeof(*worker[t].bucket));
+		worker[t].frontier = new_list(0);
+		worker[t].settled = new_list(0);
+		worker[t].request = calloc(num_processors, sizeof(*worker[t].request));
+		worker[t].num_request = calloc(num_processors, sizeof(int));
+		worker[t].max_request = calloc(num_processors, sizeof(int));
+		if (!worker[t].bucket || !worker[t].frontier || !worker[t].settled ||
+		    !worker[t].request || !worker[t].num_request || !worker[t].max_request){
+			goto failure;
+		}
+		for (k=0; k < num_slots; k++){
+			worker[t].bucket[k] = new_list(0);
+			if (!worker[t].bucket[k]){ goto failure; }
+		}
+	}
+	return worker;
+	
+failure:
+	delete_graph_delta_workers(worker, num_processors, num_slots);
+	return NULL;
+}
+
+void graph_delta_stepping
+		(const graph_t *g, int s, double delta, double *distance, int num_processors){
+	assert(g);
+	int i, n = graph_num_vertices(g);
+	assert(s >= 0 && s < n);
+	assert(distance);
+	assert(num_processors > 0);
+	
+	// Bucket width and number of buckets in use at any time
+	double max_weight = 0.0;
+	long num_adjacents = 0;
+	for (i=0; i < n; i++){
+		set_entry_t *adj = graph_adjacent_head(g, i);
+		for (; adj != NULL; adj = adj->next, num_adjacents++){
+			double weight = graph_adjacent_weight(g, i, adj);
+			assert(weight >= 0.0);
+			if (weight > max_weight){ max_weight = weight; }
+		}
+	}
+	if (delta <= 0.0){
+		double avg_degree = (double)num_adjacents / n;
+		delta = avg_degree > 1.0 ? max_weight / avg_degree : max_weight;
+		if (delta <= 0.0){ delta = 1.0; }
+	}
+	
+	graph_delta_stepping_t d;
+	d.g = g;
+	d.delta = delta;
+	d.num_slots = (int)(max_weight / delta) + 3;
+	d.num_processors = num_processors;
+	d.distance = distance;
+	d.bucket_of = malloc(n * sizeof(*d.bucket_of));
+	d.is_queued = calloc(n, sizeof(*d.is_queued));
+	d.is_settled = calloc(n, sizeof(*d.is_settled));
+	d.worker = new_graph_delta_workers(num_processors, d.num_slots);
+	
+	pthread_t *thread = malloc(num_processors * sizeof(*thread));
+	graph_delta_stepping_params_t *params;
+	params = malloc(num_processors * sizeof(*params));
+	
+	bool is_failure = false;
+	if (!(d.bucket_of && d.is_queued && d.is_settled && d.worker && 
+	      thread && params)){
+		is_failure = true;
+		goto end;
+	}
+	
+	// Threads wait for the start mutex until the number of launched threads
+	//is known. The main thread is worker 0.
+	pthread_mutex_init(&d.start, NULL);
+	pthread_mutex_lock(&d.start);
+	for (i=0; i < num_processors; i++){
+		params[i].d = &d;
+		params[i].index = i;
+	}
+	for (i=1; i < num_processors; i++){
+		int result = pthread_create
+			(&thread[i], NULL, graph_delta_stepping_task, &params[i]);
+		if (result != 0){
+			break;
+		}
+	}
+	d.num_processors = i;
+	pthread_barrier_init(&d.barrier, NULL, d.num_processors);
+	
+	for (i=0; i < n; i++){ distance[i] = INFINITY; }
+	distance[s] = 0.0;
+	d.bucket_of[s] = 0;
+	d.is_queued[s] = true;
+	graph_delta_push(&d, s % d.num_processors, s);
+	pthread_mutex_unlock(&d.start);
+	
+	graph_delta_stepping_task(&params[0]);
+	for (i=1; i < d.num_processors; i++){
+		pthread_join(thread[i], NULL);
+	}
+	pthread_barrier_destroy(&d.barrier);
+	pthread_mutex_destroy(&d.start);
+	
+	for (i=0; i < d.num_processors; i++){
+		if (d.worker[i].failed){ is_failure = true; }
+	}
+	
+end:
+	delete_graph_delta_workers(d.worker, num_processors, d.num_slots);
+	free(d.bucket_of);
+	free(d.is_queued);
+	free(d.is_settled);
+	free(thread);
+	free(params);
+	
+	if (is_failure){
+		fprintf(stderr, "Failure executing delta-stepping. "
+		                "Launching single-threaded\n");
+		graph_weighted_geodesic_vertex(g, s, distance);
+	}
+}
+
 /************************ Centrality measures *********************************/
 
 /** Betweenness 
@@ -440,7 +1004,7 @@ int *graph_geodesic_distribution(const graph_t *g, int *_diameter){
 
 // Increments betweenness given the result of a run starting from vertex s.
 void graph_inc_betweenness
-		(int s, const int *distance, const int *sequence, const int *path_count,
+		(int s, const int *distance, const int *sequence, const double *path_count,
 		 list_t **predecessor, double *betweenness, int n){
 	
 	double *dependency = malloc(n * sizeof(*dependency));
@@ -454,7 +1018,7 @@ void graph_inc_betweenness
 		for (j=0; j < num_predecessor; j++){
 			int v = list_get(predecessor[w], j);
 			dependency[v] += 
-				(double)path_count[v]/path_count[w] + (1 + dependency[w]);
+				path_count[v]/path_count[w] + (1 + dependency[w]);
 			if (w != s){
 				betweenness[w] += dependency[w];
 			}
@@ -476,7 +1040,7 @@ void graph_betweenness_step
 	
 	int *distance = malloc(n * sizeof(*distance));
 	int *sequence = malloc(n * sizeof(*sequence));
-	int *path_count = malloc(n * sizeof(*path_count));
+	double *path_count = malloc(n * sizeof(*path_count));
 	
 	bool lists_ok = true;
 	list_t **predecessor = malloc(n * sizeof(*predecessor));
@@ -515,13 +1079,18 @@ void graph_betweenness(const graph_t *g, double *betweenness){
 typedef struct {
 	const graph_t *graph;
 	int index, num_processors;
-	char padding[CACHE_ALIGNMENT - sizeof(const graph_t *) - 2*sizeof(int)];
+	bool is_weighted;
+	char padding[CACHE_ALIGNMENT - sizeof(const graph_t *) - 2*sizeof(int)
+	             - sizeof(bool)];
 } graph_betweenness_task_params_t;
 
 void *graph_betweenness_task(void *args);
+void graph_weighted_betweenness_step
+	(const graph_t *g, double *betweenness, int initial, int step);
 
-void graph_parallel_betweenness
-		(const graph_t *g, double *betweenness, int num_processors){
+void graph_launch_betweenness
+		(const graph_t *g, double *betweenness, int num_processors,
+		 bool is_weighted){
 	assert(g);
 	assert(betweenness);
 	assert(num_processors > 1);
@@ -540,6 +1109,7 @@ void graph_parallel_betweenness
 		params[i].graph = g;
 		params[i].index = i;
 		params[i].num_processors = num_processors;
+		params[i].is_weighted = is_weighted;
 		int result 
 			= pthread_create(&thread[i], NULL, graph_betweenness_task, &params[i]);
 		if (result != 0)
@@ -577,10 +1147,16 @@ void graph_parallel_betweenness
 	if (is_failure){
 		fprintf(stderr, "Failure executing parallel betweenness. "
 		                "Launching single-threaded\n");
-		graph_betweenness(g, betweenness);
+		if (is_weighted){ graph_weighted_betweenness(g, betweenness); }
+		else            { graph_betweenness(g, betweenness); }
 	}
 }
 
+void graph_parallel_betweenness
+		(const graph_t *g, double *betweenness, int num_processors){
+	graph_launch_betweenness(g, betweenness, num_processors, false);
+}
+
 void *graph_betweenness_task(void *args){
 	graph_betweenness_task_params_t params;
 	params = *(graph_betweenness_task_params_t*) args;
@@ -593,10 +1169,92 @@ void *graph_betweenness_task(void *args){
 	double *betweenness = malloc(n * sizeof(*betweenness));
 	if (!betweenness){ return NULL; }
 	
-	graph_betweenness_step(g, betweenness, initial, step);
+	if (params.is_weighted){
+		graph_weighted_betweenness_step(g, betweenness, initial, step);
+	} else {
+		graph_betweenness_step(g, betweenness, initial, step);
+	}
 	return betweenness;
 }
 
+// Increments betweenness given the result of a Dijkstra run from vertex s.
+void graph_inc_weighted_betweenness
+		(int s, const int *sequence, int num_settled, const double *path_count,
+		 list_t **predecessor, double *dependency, double *betweenness){
+	int i, j;
+	for (i=0; i < num_settled; i++){ dependency[sequence[i]] = 0.0; }
+	
+	for (i=num_settled-1; i >= 0; i--){
+		int w = sequence[i];
+		int num_predecessor = list_size(predecessor[w]);
+		for (j=0; j < num_predecessor; j++){
+			int v = list_get(predecessor[w], j);
+			dependency[v] += path_count[v]/path_count[w] * (1 + dependency[w]);
+		}
+		if (w != s){
+			betweenness[w] += dependency[w];
+		}
+	}
+}
+
+void graph_weighted_betweenness_step
+		(const graph_t *g, double *betweenness, int initial, int step){
+	assert(g);
+	assert(betweenness);
+	assert(step > 0);
+	assert(initial >= 0 && initial < step);
+	
+	int i, n = graph_num_vertices(g);
+	memset(betweenness, 0, n * sizeof(*betweenness));
+	
+	double *distance = malloc(n * sizeof(*distance));
+	int *sequence = malloc(n * sizeof(*sequence));
+	double *path_count = malloc(n * sizeof(*path_count));
+	double *dependency = malloc(n * sizeof(*dependency));
+	
+	bool lists_ok = true;
+	list_t **predecessor = calloc(n, sizeof(*predecessor));
+	if (!predecessor){ lists_ok = false; }
+	if (lists_ok){
+		for (i=0; i < n; i++){
+			predecessor[i] = new_list(0); if (!predecessor[i]){ lists_ok = false; }
+		}
+	}
+	
+	if (distance && sequence && path_count && dependency && lists_ok) {
+		int s;
+		for (s=initial; s < n; s += step){
+			int num_settled = graph_dijkstra_paths
+				(g, s, distance, sequence, path_count, predecessor);
+			if (num_settled < 0){ break; }
+			graph_inc_weighted_betweenness
+				(s, sequence, num_settled, path_count, predecessor, dependency,
+				 betweenness);
+		}
+	}
+	
+	free(distance);
+	free(sequence);
+	free(path_count);
+	free(dependency);
+	if (predecessor){
+		for (i=0; i < n; i++){ 
+			if (predecessor[i]){ delete_list(predecessor[i]); }
+		}
+		free(predecessor);
+	}
+}
+
+void graph_weighted_betweenness(const graph_t *g, double *betweenness){
+	int initial=0, step=1;
+	graph_weighted_betweenness_step(g, betweenness, initial, step);
+}
+
+void graph_parallel_weighted_betweenness
+		(const graph_t *g, double *betweenness, int num_processors){
+	graph_launch_betweenness(g, betweenness, num_processors, true);
+}
+
 // Vector distance, defined by canonical inner product
 double dist(double *u, double *v, int n){
 	double d = 0.0;
@@ -635,13 +1293,25 @@ void graph_eigenvector(const graph_t *g, double *eigen){
 	double tol = GRAPH_METRIC_TOLERANCE;
 	int max_iter = GRAPH_METRIC_MAX_ITERATIONS;
 	
+	// In directed graphs with in-adjacencies, each vertex pulls the values of
+	//its in-neighbors, writing its entry only once
+	bool is_pull = graph_is_directed(g) && graph_has_in_adjacency(g);
+	
 	int count = 0;
 	while(dist(curr, next, n) > tol && count < max_iter){
 		memset(next, 0, n * sizeof(*next));
 		
 		for (i=0; i < n; i++){
-			set_entry_t *adj = graph_adjacent_head(g, i);
-			for (; adj != NULL; adj = adj->next){
+			set_entry_t *adj;
+			if (is_pull){
+				double s = 0.0;
+				for (adj = graph_in_adjacent_head(g, i); adj; adj = adj->next){
+					s += curr[adj->key];
+				}
+				next[i] = s;
+				continue;
+			}
+			for (adj = graph_adjacent_head(g, i); adj != NULL; adj = adj->next){
 				int v = adj->key;
 				next[v] += curr[i];
 			}
@@ -679,14 +1349,26 @@ void graph_pagerank(const graph_t *g, double alpha, double *rank){
 	double tol = GRAPH_METRIC_TOLERANCE;
 	int max_iter = GRAPH_METRIC_MAX_ITERATIONS;
 	
+	// Same as in graph_eigenvector
+	bool is_pull = graph_is_directed(g) && graph_has_in_adjacency(g);
+	
 	int count = 0;
 	while(n*dist(curr, next, n) > tol || count < max_iter){
 		memset(next, 0, n * sizeof(*next));
 		
 		for (i=0; i < n; i++){
+			set_entry_t *adj;
+			if (is_pull){
+				double s = 0.0;
+				for (adj = graph_in_adjacent_head(g, i); adj; adj = adj->next){
+					int u = adj->key;
+					s += (1-alpha)/n + alpha * curr[u]/graph_num_adjacents(g, u);
+				}
+				next[i] = s;
+				continue;
+			}
 			int ki = graph_num_adjacents(g, i);
-			set_entry_t *adj = graph_adjacent_head(g, i);
-			for (; adj != NULL; adj = adj->next){
+			for (adj = graph_adjacent_head(g, i); adj != NULL; adj = adj->next){
 				int v = adj->key;
 				next[v] += (1-alpha)/n + alpha * curr[i]/ki;
 			}
@@ -934,3 +1616,24 @@ void graph_closeness(const graph_t *g, double *closenness){
 	
 	free(distance);
 }
+
+void graph_weighted_closeness(const graph_t *g, double *closeness){
+	assert(g);
+	assert(closeness);
+	
+	int i, j, n = graph_num_vertices(g);
+	
+	double *distance = malloc(n * sizeof(*distance));
+	if (!distance){ return; }
+	
+	for (i=0; i < n; i++){
+		graph_weighted_geodesic_vertex(g, i, distance);
+		double farness = 0.0;
+		for (j=0; j < n; j++){
+			if (!isinf(distance[j])){ farness += distance[j]; }
+		}
+		closeness[i] = farness > 0.0 ? 1.0/farness : 0.0;
+	}
+	
+	free(distance);
+}
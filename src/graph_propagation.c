@@ -1,11 +1,14 @@
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <inttypes.h>
 #include <math.h>
 #include <string.h>
 
+#include "error.h"
 #include "stat.h"
 #include "graph.h"
+#include "graph_raster.h"
 #include "graph_propagation.h"
 
 int graph_count_state(int state, const short *v, int n){
@@ -28,31 +31,6 @@ void delete_propagation_steps(propagation_step_t *step, int num_step){
 	free(step);
 }
 
-int graph_find_edge(const graph_t *g, int orig, int dest){
-	if (!graph_is_directed(g) && orig > dest){ 
-		int aux = orig; orig = dest; dest = aux;
-	}
-	
-	int i, j, n = graph_num_vertices(g);
-	int *adj = malloc(n * sizeof(*adj));
-	
-	int e=0;
-	for (i=0; i < n; i++){
-		int ki = graph_adjacents(g, i, adj);
-		for (j=0; j < ki; j++){
-			int v = adj[j];
-			if (graph_is_directed(g) || i < v){
-				if (i == orig && v == dest) break;
-				e++;
-			}
-		}
-		if (i == orig && adj[j] == dest) break;
-	}
-	
-	free(adj);
-	return e;
-}
-
 propagation_step_t *graph_propagation
 		(const graph_t *g, const short *init_state, int *num_step,
 		 propagation_model_t model, const void *params){
@@ -128,30 +106,70 @@ propagation_step_t *graph_propagation_r
 	return step;
 }
 
-void graph_animate_propagation
+error_t graph_animate_propagation
 		(const char *folder, const graph_t *g, const coord_t *p,
 		 int num_state, const propagation_step_t *step, int num_step){
-	graph_animate_propagation_steps(folder, g, p, num_state, step, num_step, 0);
+	return graph_animate_propagation_steps
+		(folder, g, p, num_state, step, num_step, 0);
 }
 
-void graph_animate_propagation_steps
-		(const char *folder, const graph_t *g, const coord_t *p,
-		 int num_state,
-		 const propagation_step_t *step, int num_step, int steps){
-	assert(folder);
-	assert(g);
-	assert(p);
-	assert(num_state > 0);
-	assert(step);
-	assert(num_step > 0);
+typedef struct {
+	const char *folder;
+	const graph_t *g;
+	const coord_t *p;
+	int num_state;
+	const propagation_step_t *step;
+	const int *frame_step;
+	const circle_style_t *point_style;
+	const path_style_t *edge_style;
+} graph_propagation_frame_data_t;
+
+error_t graph_propagation_print_frame
+		(int frame, graph_svg_buffer_t *buffer, void *_data){
+	const graph_propagation_frame_data_t *data = _data;
+	const graph_t *g = data->g;
+	int i, s = data->frame_step[frame];
+	int n = graph_num_vertices(g);
+	int64_t m = graph_num_edges(g);
 	
-	if(steps < num_step) steps = 0;
-	if(steps > num_step) steps = num_step;
-	if(steps == 0) steps = num_step;
+	char filename[256];
+	sprintf(filename, "%s/frame%05d.svg", data->folder, s);
 	
-	circle_style_t *point_style = malloc(num_state * sizeof(*point_style));
-	path_style_t *edge_style = malloc((num_state+1) * sizeof(*edge_style));
+	int *ps = malloc(n * sizeof(*ps));
+	int *es = malloc(m * sizeof(*es));
+	if (!ps || !es){
+		fprintf(stderr, "No memory to print %s\n", filename);
+		free(ps); free(es);
+		return ERROR_NO_MEMORY;
+	}
 	
+	const propagation_step_t step = data->step[s];
+	for (i=0; i < step.n; i++){
+		ps[i] = step.state[i];
+	}
+	
+	memset(es, 0, m * sizeof(*es));
+	for (i=0; i < step.num_message; i++){
+		int orig = step.message[i].orig;
+		int dest = step.message[i].dest;
+		
+		int64_t e = graph_edge_id(g, orig, dest);
+		if (e >= 0){ es[e] = 1 + step.state[dest]; }
+	}
+	
+	error_t error = graph_print_svg_some_styles_buffered
+		(buffer, filename, 0, 0, g, data->p, 
+		 ps, data->point_style, data->num_state,
+		 es, data->edge_style, data->num_state+1);
+	free(ps);
+	free(es);
+	return error;
+}
+
+// Fills styles used in animations: one point style per state, edge style 0 
+//for all edges and edge style 1+s for messages sent to vertices in state s.
+void graph_propagation_styles
+		(int num_state, circle_style_t *point_style, path_style_t *edge_style){
 	color_t black_50 = {0, 0, 0, 128};
 	color_t black_100 = {0, 0, 0, 255};
 	int radius = 5;
@@ -176,60 +194,170 @@ void graph_animate_propagation_steps
 		edge_style[i+1].width = 2*width;
 		color_copy(edge_style[i+1].color, rgb);
 	}
+}
+
+// Returns the indices of *steps evenly spaced steps, including the last one.
+int *graph_propagation_frame_steps(int num_step, int *steps){
+	// Prints all steps if there are fewer than asked, or none were asked
+	if(*steps <= 0 || *steps > num_step) *steps = num_step;
 	
-	int n = graph_num_vertices(g), m = graph_num_edges(g);
+	int *px = malloc(*steps * sizeof(*px));
+	if (!px){ return NULL; }
 	
-	int *ps = malloc(n * sizeof(*ps));
-	int *es = malloc(m * sizeof(*es));
+	// Step x of the frames is x/(steps-1) of the way to the last step
+	int x;
+	for (x=0; x < *steps; x++){
+		px[x] = *steps > 1 ? (int)((int64_t)x * (num_step-1) / (*steps-1)) 
+		                   : num_step-1;
+	}
+	return px;
+}
+
+error_t graph_animate_propagation_steps
+		(const char *folder, const graph_t *g, const coord_t *p,
+		 int num_state,
+		 const propagation_step_t *step, int num_step, int steps){
+	assert(folder);
+	assert(g);
+	assert(p);
+	assert(num_state > 0);
+	assert(step);
+	assert(num_step > 0);
 	
-	int *adj = malloc(n * sizeof(*adj));
+	circle_style_t *point_style = malloc(num_state * sizeof(*point_style));
+	path_style_t *edge_style = malloc((num_state+1) * sizeof(*edge_style));
+	int *px = graph_propagation_frame_steps(num_step, &steps);
+	
+	// Frames are printed concurrently, reading the edge index, that must be
+	//built before
+	if (!point_style || !edge_style || !px || graph_build_edge_index(g)){
+		fprintf(stderr, "No memory to animate propagation\n");
+		free(point_style); free(edge_style); free(px);
+		return ERROR_NO_MEMORY;
+	}
+	graph_propagation_styles(num_state, point_style, edge_style);
+	graph_propagation_frame_data_t data = {
+		folder, g, p, num_state, step, px, point_style, edge_style
+	};
+	error_t error = graph_print_frames(steps, GRAPH_LAYOUT_NUM_PROCESSORS, 
+	                                   graph_propagation_print_frame, &data);
+	
+	free(px);
+	free(point_style);
+	free(edge_style);
+	return error;
+}
+
+typedef struct {
+	const char *folder;
+	graph_raster_format_t format;
+	const coord_t *p;
+	const propagation_step_t *step;
+	const int *frame_step;
+	const circle_style_t *point_style;
+	const path_style_t *edge_style;
+	const graph_raster_t *background; // Edge layer shared by all frames
+} graph_propagation_raster_data_t;
+
+error_t graph_propagation_raster_frame
+		(int frame, graph_svg_buffer_t *buffer, void *_data){
+	const graph_propagation_raster_data_t *data = _data;
+	const graph_raster_t *background = data->background;
+	const coord_t *p = data->p;
+	int i, s = data->frame_step[frame];
+	
+	char filename[256];
+	sprintf(filename, "%s/frame%05d.%s", data->folder, s, 
+	        data->format == GRAPH_RASTER_PNG ? "png" : "ppm");
+	
+	graph_raster_t *r = new_graph_raster
+		(background->width, background->height, background->scale);
+	if (!r){
+		fprintf(stderr, "No memory to print %s\n", filename);
+		return ERROR_NO_MEMORY;
+	}
+	graph_raster_copy(r, background);
+	
+	// Messages are drawn over the edge layer, colored by destination state
+	const propagation_step_t step = data->step[s];
+	for (i=0; i < step.num_message; i++){
+		int orig = step.message[i].orig;
+		int dest = step.message[i].dest;
+		graph_raster_path(r, p[orig], p[dest], 
+		                  data->edge_style[1 + step.state[dest]]);
+	}
+	for (i=0; i < step.n; i++){
+		graph_raster_circle(r, p[i], data->point_style[ step.state[i] ]);
+	}
 	
-	//interval
-	int pulo = num_step/(steps-1);
-	int *px = (int*) malloc(steps*sizeof(int));
+	error_t error = graph_raster_write(r, filename, data->format);
+	if (error){
+		fprintf(stderr, "Couldn't write %s\n", filename);
+	}
+	delete_graph_raster(r);
+	return error;
+}
 
-	int valor = 0;
-	int x;
-	for(x = 0; x < steps; x++){
-			if(steps-1 == x){
-					px[x] = num_step - 1;
-			}
-			else{
-					px[x] = valor;
-					valor += pulo;
-			}
+error_t graph_animate_propagation_raster
+		(const char *folder, const graph_t *g, const coord_t *p,
+		 int num_state,
+		 const propagation_step_t *step, int num_step, int steps,
+		 int size, graph_raster_format_t format){
+	assert(folder);
+	assert(g);
+	assert(p);
+	assert(num_state > 0);
+	assert(step);
+	assert(num_step > 0);
+	
+	circle_style_t *point_style = malloc(num_state * sizeof(*point_style));
+	path_style_t *edge_style = malloc((num_state+1) * sizeof(*edge_style));
+	int *px = graph_propagation_frame_steps(num_step, &steps);
+	int *es = calloc(graph_num_edges(g) + 1, sizeof(*es));
+	if (!point_style || !edge_style || !px || !es){
+		fprintf(stderr, "No memory to animate propagation\n");
+		free(point_style); free(edge_style); free(px); free(es);
+		return ERROR_NO_MEMORY;
 	}
+	graph_propagation_styles(num_state, point_style, edge_style);
 	
-	int s;
-	int it;
-	for (it = 0; it < steps; it++){
-	  s = px[it];
-		char filename[256];
-		sprintf(filename, "%s/frame%05d.svg", folder, s);
-		
-		for (i=0; i < step[s].n; i++){
-			ps[i] = step[s].state[i];
-		}
-		
-		memset(es, 0, m * sizeof(*es));
-		for (i=0; i < step[s].num_message; i++){
-			int orig = step[s].message[i].orig;
-			int dest = step[s].message[i].dest;
-			
-			int e = graph_find_edge(g, orig, dest);
-			es[e] = 1 + step[s].state[dest];
+	// Image covers all circles, from the origin as in SVG
+	int i, n = graph_num_vertices(g);
+	float extent = 1.0f;
+	for (i=0; i < num_state; i++){
+		float r = point_style[i].radius + point_style[i].width;
+		int j;
+		for (j=0; j < n; j++){
+			if (extent < p[j].x + r){ extent = p[j].x + r; }
+			if (extent < p[j].y + r){ extent = p[j].y + r; }
 		}
+	}
+	float scale = size > 0 ? size / extent : 1.0f;
+	int side = size > 0 ? size : (int) ceilf(extent);
+	
+	error_t error = ERROR_SUCCESS;
+	graph_raster_t *background = new_graph_raster(side, side, scale);
+	if (!background){
+		fprintf(stderr, "No memory to animate propagation\n");
+		error = ERROR_NO_MEMORY;
+	} else {
+		color_t white = {255, 255, 255, 255};
+		graph_raster_clear(background, white);
+		graph_raster_draw_some_styles(background, g, p, NULL, NULL, es, edge_style);
 		
-		graph_print_svg_some_styles(filename, 0, 0, g, p, 
-		                            ps, point_style, num_state,
-		                            es, edge_style, num_state+1);
+		graph_propagation_raster_data_t data = {
+			folder, format, p, step, px, point_style, edge_style, background
+		};
+		error = graph_print_frames(steps, GRAPH_LAYOUT_NUM_PROCESSORS, 
+		                           graph_propagation_raster_frame, &data);
+		delete_graph_raster(background);
 	}
 	
-	free(adj);
-	free(ps);
 	free(es);
+	free(px);
 	free(point_style);
 	free(edge_style);
+	return error;
 }
 
 void graph_propagation_freq
@@ -245,6 +373,182 @@ void graph_propagation_freq
 	}
 }
 
+/****************************** Animation files *******************************/
+
+void graph_save_propagation_changes
+		(FILE *fp, const short *prev, const propagation_step_t step){
+	int i, num_change = 0;
+	for (i=0; i < step.n; i++){
+		if (step.state[i] != (prev ? prev[i] : 0)){ num_change++; }
+	}
+	fprintf(fp, "S %d %d\n", num_change, step.num_message);
+	for (i=0; i < step.n; i++){
+		if (step.state[i] != (prev ? prev[i] : 0)){
+			fprintf(fp, "%d %d\n", i, step.state[i]);
+		}
+	}
+	for (i=0; i < step.num_message; i++){
+		fprintf(fp, "%d %d\n", step.message[i].orig, step.message[i].dest);
+	}
+}
+
+error_t graph_save_propagation
+		(const char *filename, const graph_t *g, const coord_t *p,
+		 int num_state, const propagation_step_t *step, int num_step){
+	assert(filename);
+	assert(g);
+	assert(p);
+	assert(num_state > 0);
+	assert(step);
+	assert(num_step > 0);
+	
+	FILE *fp = fopen(filename, "wt");
+	if (!fp){ return ERROR_UNDEFINED; }
+	
+	int i, n = graph_num_vertices(g);
+	fprintf(fp, "A1 %s %d %" PRId64 " %d %d\n", 
+	        graph_is_directed(g) ? "directed" : "undirected",
+	        n, graph_num_edges(g), num_state, num_step);
+	
+	// Static geometry: coordinates and edges in canonical order
+	for (i=0; i < n; i++){
+		fprintf(fp, "%g %g\n", p[i].x, p[i].y);
+	}
+	for (i=0; i < n; i++){
+		set_entry_t *adj;
+		for (adj = graph_adjacent_head(g, i); adj != NULL; adj = adj->next){
+			if (graph_is_directed(g) || i < adj->key){
+				fprintf(fp, "%d %d\n", i, adj->key);
+			}
+		}
+	}
+	
+	// Each step has only the vertices that changed state, and all messages
+	for (i=0; i < num_step; i++){
+		graph_save_propagation_changes(fp, i > 0 ? step[i-1].state : NULL, step[i]);
+	}
+	
+	error_t error = ferror(fp) ? ERROR_UNDEFINED : ERROR_SUCCESS;
+	if (fclose(fp) != 0){ error = ERROR_UNDEFINED; }
+	return error;
+}
+
+propagation_step_t *graph_load_propagation
+		(const char *filename, graph_t **g, coord_t **p,
+		 int *num_state, int *num_step){
+	assert(filename);
+	assert(g);
+	assert(p);
+	assert(num_state);
+	assert(num_step);
+	
+	FILE *fp = fopen(filename, "rt");
+	if (!fp){
+		fprintf(stderr, "Can't open file %s\n", filename); 
+		return NULL;
+	}
+	
+	int version, n;
+	int64_t m;
+	char is_directed_str[16];
+	if (fscanf(fp, "A%d %15s %d %" SCNd64 " %d %d", &version, is_directed_str, 
+	           &n, &m, num_state, num_step) != 6 || version != 1 ||
+	    n <= 0 || m < 0 || *num_state <= 0 || *num_step <= 0){
+		fprintf(stderr, "Bad header in file %s\n", filename); 
+		fclose(fp);
+		return NULL;
+	}
+	bool is_directed = !strcmp(is_directed_str, "directed");
+	
+	*g = new_graph(n, false, is_directed);
+	*p = malloc(n * sizeof(**p));
+	propagation_step_t *step = calloc(*num_step, sizeof(*step));
+	if (!*g || !*p || !step){
+		fprintf(stderr, "No memory for %s\n", filename);
+		goto failure;
+	}
+	
+	int i, s;
+	int64_t e;
+	for (i=0; i < n; i++){
+		if (fscanf(fp, "%f %f", &(*p)[i].x, &(*p)[i].y) != 2){
+			fprintf(stderr, "Bad file %s, stopping in vertex %d\n", filename, i);
+			goto failure;
+		}
+	}
+	for (e=0; e < m; e++){
+		int u, v;
+		if (fscanf(fp, "%d %d", &u, &v) != 2 || 
+		    u < 0 || u >= n || v < 0 || v >= n){
+			fprintf(stderr, "Bad file %s, stopping in edge %" PRId64 "\n",
+			        filename, e);
+			goto failure;
+		}
+		if (graph_add_edge(*g, u, v)){
+			fprintf(stderr, "No memory for %s\n", filename);
+			goto failure;
+		}
+	}
+	
+	for (s=0; s < *num_step; s++){
+		int num_change, num_message;
+		step[s].n = n;
+		step[s].state = malloc(n * sizeof(*step[s].state));
+		if (!step[s].state){
+			step[s].n = 0;
+			fprintf(stderr, "No memory for %s\n", filename);
+			goto failure;
+		}
+		if (fscanf(fp, " S %d %d", &num_change, &num_message) != 2 ||
+		    num_change < 0 || num_message < 0){
+			fprintf(stderr, "Bad file %s, stopping in step %d\n", filename, s);
+			goto failure;
+		}
+		
+		if (s == 0){ memset(step[s].state, 0, n * sizeof(*step[s].state)); }
+		else { memcpy(step[s].state, step[s-1].state, n * sizeof(*step[s].state)); }
+		
+		for (i=0; i < num_change; i++){
+			int v, state;
+			if (fscanf(fp, "%d %d", &v, &state) != 2 || v < 0 || v >= n ||
+			    state < 0 || state >= *num_state){
+				fprintf(stderr, "Bad file %s, stopping in step %d\n", filename, s);
+				goto failure;
+			}
+			step[s].state[v] = state;
+		}
+		
+		if (num_message > 0){
+			step[s].message = malloc(num_message * sizeof(*step[s].message));
+			if (!step[s].message){
+				fprintf(stderr, "No memory for %s\n", filename);
+				goto failure;
+			}
+			step[s].num_message = num_message;
+		}
+		for (i=0; i < num_message; i++){
+			message_t *msg = &step[s].message[i];
+			if (fscanf(fp, "%d %d", &msg->orig, &msg->dest) != 2 ||
+			    msg->orig < 0 || msg->orig >= n || msg->dest < 0 || msg->dest >= n){
+				fprintf(stderr, "Bad file %s, stopping in step %d\n", filename, s);
+				goto failure;
+			}
+		}
+	}
+	
+	fclose(fp);
+	return step;
+
+failure:
+	fclose(fp);
+	if (step){ delete_propagation_steps(step, *num_step); }
+	if (*g){ delete_graph(*g); }
+	free(*p);
+	*g = NULL;
+	*p = NULL;
+	return NULL;
+}
+
 /******************************** SI model ************************************/
 void graph_si_transition
 		(short *next, const propagation_step_t curr, int n, 
@@ -0,0 +1,478 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <string.h>
+
+#include "error.h"
+#include "graph.h"
+#include "graph_layout.h"
+#include "graph_raster.h"
+
+/******************************** Framebuffer *********************************/
+
+graph_raster_t *new_graph_raster(int width, int height, float scale){
+	assert(width > 0);
+	assert(height > 0);
+	assert(scale > 0.0f);
+
+	graph_raster_t *r = malloc(sizeof(*r));
+	if (!r){ return NULL; }
+	r->pixel = malloc((size_t)width * height * 4);
+	if (!r->pixel){ free(r); return NULL; }
+
+	r->width = width;
+	r->height = height;
+	r->scale = scale;
+	memset(r->pixel, 0, (size_t)width * height * 4);
+	return r;
+}
+
+void delete_graph_raster(graph_raster_t *r){
+	if (!r){ return; }
+	free(r->pixel);
+	free(r);
+}
+
+void graph_raster_clear(graph_raster_t *r, const color_t color){
+	assert(r);
+	int i, size = r->width * r->height;
+	unsigned char *px = r->pixel;
+	for (i=0; i < size; i++, px += 4){
+		px[COLOR_R] = color[COLOR_R];
+		px[COLOR_G] = color[COLOR_G];
+		px[COLOR_B] = color[COLOR_B];
+		px[COLOR_A] = color[COLOR_A];
+	}
+}
+
+void graph_raster_copy(graph_raster_t *copy, const graph_raster_t *original){
+	assert(copy);
+	assert(original);
+	assert(copy->width == original->width);
+	assert(copy->height == original->height);
+	memcpy(copy->pixel, original->pixel, (size_t)copy->width * copy->height * 4);
+}
+
+// Blends color over pixel (x,y) with "over" operator, with the color's alpha
+//multiplied by coverage.
+void graph_raster_blend
+		(graph_raster_t *r, int x, int y, const color_t color, float coverage){
+	if (x < 0 || y < 0 || x >= r->width || y >= r->height){ return; }
+
+	float a = coverage * color[COLOR_A] / COLOR_MAX;
+	if (a <= 0.0f){ return; }
+
+	unsigned char *px = r->pixel + 4 * ((size_t)y * r->width + x);
+	float da = (float)px[COLOR_A] / COLOR_MAX * (1.0f - a);
+	float oa = a + da;
+
+	int k;
+	for (k=COLOR_R; k <= COLOR_B; k++){
+		px[k] = (unsigned char) ((color[k] * a + px[k] * da) / oa + 0.5f);
+	}
+	px[COLOR_A] = (unsigned char) (oa * COLOR_MAX + 0.5f);
+}
+
+// Fraction of the pixel [d-0.5, d+0.5] covered by interval [lo, hi]
+float graph_raster_coverage(float lo, float hi, float d){
+	float c = fminf(d + 0.5f, hi) - fmaxf(d - 0.5f, lo);
+	return c < 0.0f ? 0.0f : (c > 1.0f ? 1.0f : c);
+}
+
+/******************************** Primitives **********************************/
+
+// Draws segment between a and b, in pixel coordinates, with half width hw.
+void graph_raster_segment
+		(graph_raster_t *r, coord_t a, coord_t b, float hw, const color_t color){
+	float dx = b.x - a.x, dy = b.y - a.y;
+	float len2 = dx*dx + dy*dy;
+	float ext = hw + 1.0f;
+
+	// Iterate along the major axis, and over a window in the minor axis
+	bool is_horizontal = fabsf(dx) >= fabsf(dy);
+	float major_a = is_horizontal ? a.x : a.y, major_b = is_horizontal ? b.x : b.y;
+	float minor_a = is_horizontal ? a.y : a.x, minor_b = is_horizontal ? b.y : b.x;
+	float slope = major_b != major_a ?
+		(minor_b - minor_a) / (major_b - major_a) : 0.0f;
+	float window = ext * sqrtf(1.0f + slope*slope);
+
+	int i, j;
+	int i0 = (int) floorf(fminf(major_a, major_b) - ext);
+	int i1 = (int) ceilf (fmaxf(major_a, major_b) + ext);
+	for (i=i0; i <= i1; i++){
+		float c = i + 0.5f;
+		float t = major_b != major_a ? (c - major_a) / (major_b - major_a) : 0.0f;
+		t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+		float center = minor_a + t * (minor_b - minor_a);
+
+		int j0 = (int) floorf(center - window);
+		int j1 = (int) ceilf (center + window);
+		for (j=j0; j <= j1; j++){
+			float x = (is_horizontal ? i : j) + 0.5f;
+			float y = (is_horizontal ? j : i) + 0.5f;
+
+			// Distance to the segment
+			float s = len2 > 0.0f ? ((x - a.x)*dx + (y - a.y)*dy) / len2 : 0.0f;
+			s = s < 0.0f ? 0.0f : (s > 1.0f ? 1.0f : s);
+			float d = hypotf(x - (a.x + s*dx), y - (a.y + s*dy));
+
+			float coverage = graph_raster_coverage(-hw, hw, d);
+			if (coverage > 0.0f){
+				int px = is_horizontal ? i : j, py = is_horizontal ? j : i;
+				graph_raster_blend(r, px, py, color, coverage);
+			}
+		}
+	}
+}
+
+void graph_raster_path
+		(graph_raster_t *r, const coord_t from, const coord_t to,
+		 const path_style_t style){
+	assert(r);
+	float s = r->scale;
+	float hw = 0.5f * style.width * s;
+	coord_t a = {from.x * s, from.y * s}, b = {to.x * s, to.y * s};
+
+	if (style.width <= 0 || style.color[COLOR_A] <= 0){ return; }
+
+	int k;
+	coord_t curr, prev = a;
+	switch(style.type){
+		case GRAPH_STRAIGHT:
+			graph_raster_segment(r, a, b, hw, style.color);
+			break;
+		case GRAPH_PARABOLA:
+			{
+				coord_t c = {style.control.x * s, style.control.y * s};
+				for (k=1; k <= GRAPH_RASTER_SEGMENTS; k++){
+					float t = (float)k / GRAPH_RASTER_SEGMENTS, u = 1.0f - t;
+					curr.x = u*u*a.x + 2*u*t*c.x + t*t*b.x;
+					curr.y = u*u*a.y + 2*u*t*c.y + t*t*b.y;
+					graph_raster_segment(r, prev, curr, hw, style.color);
+					prev = curr;
+				}
+			}
+			break;
+		case GRAPH_CIRCULAR:
+			{
+				// Radius as printed in SVG, with the same center as its
+				//small arc with positive sweep.
+				coord_t d = {to.x - from.x, to.y - from.y};
+				coord_t m = {(from.x + to.x)/2, (from.y + to.y)/2};
+				float len = hypotf(d.x, d.y);
+				if (len == 0.0f){ break; }
+
+				float lambda = (style.control.y - m.y) * d.x
+				             - (style.control.x - m.x) * d.y;
+				float radius = hypotf(m.x - lambda*(d.y/len) - from.x,
+				                      m.y + lambda*(d.x/len) - from.y);
+				if (radius < len/2){ radius = len/2; }
+				float h = sqrtf(radius*radius - len*len/4) / len;
+
+				coord_t c = {m.x - h * d.y, m.y + h * d.x};
+				float theta0 = atan2f(from.y - c.y, from.x - c.x);
+				float theta1 = atan2f(to.y - c.y, to.x - c.x);
+				float delta = theta1 - theta0;
+				while (delta < 0.0f){ delta += 2*M_PI; }
+
+				for (k=1; k <= GRAPH_RASTER_SEGMENTS; k++){
+					float theta = theta0 + delta * k / GRAPH_RASTER_SEGMENTS;
+					curr.x = (c.x + radius * cosf(theta)) * s;
+					curr.y = (c.y + radius * sinf(theta)) * s;
+					graph_raster_segment(r, prev, curr, hw, style.color);
+					prev = curr;
+				}
+			}
+			break;
+	}
+}
+
+void graph_raster_circle
+		(graph_raster_t *r, const coord_t p, const circle_style_t style){
+	assert(r);
+	float s = r->scale;
+	float cx = p.x * s, cy = p.y * s;
+	float radius = style.radius * s;
+	float hw = style.width > 0 ? 0.5f * style.width * s : 0.0f;
+	float ext = radius + hw + 1.0f;
+
+	int x, y;
+	int x0 = (int) floorf(cx - ext), x1 = (int) ceilf(cx + ext);
+	int y0 = (int) floorf(cy - ext), y1 = (int) ceilf(cy + ext);
+	if (x0 < 0){ x0 = 0; }
+	if (y0 < 0){ y0 = 0; }
+	if (x1 >= r->width){ x1 = r->width - 1; }
+	if (y1 >= r->height){ y1 = r->height - 1; }
+
+	for (y=y0; y <= y1; y++){
+		for (x=x0; x <= x1; x++){
+			float d = hypotf(x + 0.5f - cx, y + 0.5f - cy);
+
+			// Fill up to the radius, and stroke centered on it, as in SVG
+			float coverage = graph_raster_coverage(-radius, radius, d);
+			if (coverage > 0.0f){
+				graph_raster_blend(r, x, y, style.fill, coverage);
+			}
+			if (hw > 0.0f){
+				coverage = graph_raster_coverage(radius - hw, radius + hw, d);
+				if (coverage > 0.0f){
+					graph_raster_blend(r, x, y, style.stroke, coverage);
+				}
+			}
+		}
+	}
+}
+
+/******************************** Graph drawing *******************************/
+
+void graph_raster_draw
+		(graph_raster_t *r, const graph_t *g, const coord_t *p,
+		 const circle_style_t *point_style, const path_style_t *edge_style){
+	assert(r);
+	assert(g);
+	assert(p);
+
+	int i, n = graph_num_vertices(g);
+
+	if (edge_style){
+		int e=0; //Edge counter
+		for (i=0; i < n; i++){
+			set_entry_t *adj;
+			for (adj = graph_adjacent_head(g, i); adj != NULL; adj = adj->next){
+				if (graph_is_directed(g) || i < adj->key){
+					graph_raster_path(r, edge_style[e].from, edge_style[e].to,
+					                  edge_style[e]);
+					e++;
+				}
+			}
+		}
+	}
+
+	if (point_style){
+		for (i=0; i < n; i++){
+			graph_raster_circle(r, p[i], point_style[i]);
+		}
+	}
+}
+
+void graph_raster_draw_some_styles
+		(graph_raster_t *r, const graph_t *g, const coord_t *p,
+		 const int *ps, const circle_style_t *point_style,
+		 const int *es, const path_style_t *edge_style){
+	assert(r);
+	assert(g);
+	assert(p);
+
+	int i, n = graph_num_vertices(g);
+
+	if (es && edge_style){
+		int e=0; //Edge counter
+		for (i=0; i < n; i++){
+			set_entry_t *adj;
+			for (adj = graph_adjacent_head(g, i); adj != NULL; adj = adj->next){
+				int v = adj->key;
+				if (graph_is_directed(g) || i < v){
+					graph_raster_path(r, p[i], p[v], edge_style[ es[e] ]);
+					e++;
+				}
+			}
+		}
+	}
+
+	if (ps && point_style){
+		for (i=0; i < n; i++){
+			graph_raster_circle(r, p[i], point_style[ ps[i] ]);
+		}
+	}
+}
+
+/*********************************** Output ***********************************/
+
+error_t graph_raster_write_ppm(const graph_raster_t *r, const char *filename){
+	assert(r);
+	assert(filename);
+
+	FILE *fp = fopen(filename, "wb");
+	if (!fp){ return ERROR_UNDEFINED; }
+
+	unsigned char *row = malloc(3 * r->width);
+	if (!row){ fclose(fp); return ERROR_NO_MEMORY; }
+
+	fprintf(fp, "P6\n%d %d\n%d\n", r->width, r->height, COLOR_MAX);
+
+	// Blend over white, since PPM has no alpha channel
+	int x, y, k;
+	for (y=0; y < r->height; y++){
+		const unsigned char *px = r->pixel + 4 * (size_t)y * r->width;
+		for (x=0; x < r->width; x++, px += 4){
+			for (k=COLOR_R; k <= COLOR_B; k++){
+				row[3*x + k] = (unsigned char)
+					((px[k] * px[COLOR_A] + COLOR_MAX * (COLOR_MAX - px[COLOR_A])
+					  + COLOR_MAX/2) / COLOR_MAX);
+			}
+		}
+		fwrite(row, 1, 3 * r->width, fp);
+	}
+
+	free(row);
+	error_t error = ferror(fp) ? ERROR_UNDEFINED : ERROR_SUCCESS;
+	if (fclose(fp) != 0){ error = ERROR_UNDEFINED; }
+	return error;
+}
+
+// Largest length of a stored deflate block
+#define GRAPH_PNG_BLOCK 65535
+// Largest number of bytes before Adler-32 sums must be reduced
+#define GRAPH_PNG_ADLER_MAX 5552
+
+typedef struct {
+	FILE *fp;
+	uint32_t table[256];
+	uint32_t crc;              // CRC-32 of current chunk
+	uint32_t adler_a, adler_b; // Adler-32 of uncompressed data
+	int adler_count;
+	size_t data_left;          // Uncompressed bytes not yet written
+	size_t block_left;         // Bytes not yet written in current block
+} graph_png_t;
+
+void graph_png_init(graph_png_t *png, FILE *fp, size_t data_size){
+	uint32_t i, k;
+	for (i=0; i < 256; i++){
+		uint32_t c = i;
+		for (k=0; k < 8; k++){
+			c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+		}
+		png->table[i] = c;
+	}
+	png->fp = fp;
+	png->crc = 0xffffffffu;
+	png->adler_a = 1;
+	png->adler_b = 0;
+	png->adler_count = 0;
+	png->data_left = data_size;
+	png->block_left = 0;
+}
+
+void graph_png_bytes(graph_png_t *png, const unsigned char *data, size_t len){
+	size_t i;
+	uint32_t crc = png->crc;
+	for (i=0; i < len; i++){
+		crc = png->table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+	}
+	png->crc = crc;
+	fwrite(data, 1, len, png->fp);
+}
+
+void graph_png_uint32(graph_png_t *png, uint32_t v){
+	unsigned char b[4] = {v >> 24, (v >> 16) & 0xff, (v >> 8) & 0xff, v & 0xff};
+	graph_png_bytes(png, b, 4);
+}
+
+void graph_png_chunk_begin(graph_png_t *png, uint32_t length, const char *type){
+	graph_png_uint32(png, length);
+	png->crc = 0xffffffffu;
+	graph_png_bytes(png, (const unsigned char*) type, 4);
+}
+
+void graph_png_chunk_end(graph_png_t *png){
+	graph_png_uint32(png, png->crc ^ 0xffffffffu);
+}
+
+// Writes uncompressed data inside stored deflate blocks
+void graph_png_deflate(graph_png_t *png, const unsigned char *data, size_t len){
+	while (len > 0){
+		if (png->block_left == 0){
+			size_t size = png->data_left < GRAPH_PNG_BLOCK ?
+				png->data_left : GRAPH_PNG_BLOCK;
+			unsigned char header[5] = {
+				size == png->data_left, size & 0xff, size >> 8,
+				~size & 0xff, (~size >> 8) & 0xff
+			};
+			graph_png_bytes(png, header, 5);
+			png->block_left = size;
+		}
+
+		size_t i, k = len < png->block_left ? len : png->block_left;
+		for (i=0; i < k; i++){
+			png->adler_a += data[i];
+			png->adler_b += png->adler_a;
+			if (++png->adler_count == GRAPH_PNG_ADLER_MAX){
+				png->adler_a %= 65521;
+				png->adler_b %= 65521;
+				png->adler_count = 0;
+			}
+		}
+		graph_png_bytes(png, data, k);
+
+		png->block_left -= k;
+		png->data_left -= k;
+		data += k;
+		len -= k;
+	}
+}
+
+error_t graph_raster_write_png(const graph_raster_t *r, const char *filename){
+	assert(r);
+	assert(filename);
+
+	// Each row is preceded by its filter type, 0 (none)
+	size_t row_size = 1 + 4 * (size_t)r->width;
+	size_t data_size = r->height * row_size;
+	size_t num_blocks = (data_size + GRAPH_PNG_BLOCK - 1) / GRAPH_PNG_BLOCK;
+	size_t idat_size = 2 + data_size + 5 * num_blocks + 4;
+	assert(idat_size < 0x80000000u);
+
+	FILE *fp = fopen(filename, "wb");
+	if (!fp){ return ERROR_UNDEFINED; }
+
+	graph_png_t *png = malloc(sizeof(*png));
+	if (!png){ fclose(fp); return ERROR_NO_MEMORY; }
+	graph_png_init(png, fp, data_size);
+
+	static const unsigned char signature[8] =
+		{0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+	fwrite(signature, 1, 8, fp);
+
+	// 8 bits per channel, RGBA, no interlacing
+	static const unsigned char format[5] = {8, 6, 0, 0, 0};
+	graph_png_chunk_begin(png, 13, "IHDR");
+	graph_png_uint32(png, r->width);
+	graph_png_uint32(png, r->height);
+	graph_png_bytes(png, format, 5);
+	graph_png_chunk_end(png);
+
+	// zlib stream with no compression and the default window
+	static const unsigned char zlib_header[2] = {0x78, 0x01};
+	graph_png_chunk_begin(png, idat_size, "IDAT");
+	graph_png_bytes(png, zlib_header, 2);
+
+	int y;
+	const unsigned char filter = 0;
+	for (y=0; y < r->height; y++){
+		graph_png_deflate(png, &filter, 1);
+		graph_png_deflate(png, r->pixel + (row_size - 1) * y, row_size - 1);
+	}
+	graph_png_uint32(png,
+		((png->adler_b % 65521) << 16) | (png->adler_a % 65521));
+	graph_png_chunk_end(png);
+
+	graph_png_chunk_begin(png, 0, "IEND");
+	graph_png_chunk_end(png);
+
+	free(png);
+	error_t error = ferror(fp) ? ERROR_UNDEFINED : ERROR_SUCCESS;
+	if (fclose(fp) != 0){ error = ERROR_UNDEFINED; }
+	return error;
+}
+
+error_t graph_raster_write
+		(const graph_raster_t *r, const char *filename,
+		 graph_raster_format_t format){
+	switch(format){
+		case GRAPH_RASTER_PPM: return graph_raster_write_ppm(r, filename);
+		case GRAPH_RASTER_PNG: return graph_raster_write_png(r, filename);
+	}
+	return ERROR_UNDEFINED;
+}
@@ -0,0 +1,290 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "error.h"
+#include "graph.h"
+#include "graph_metric.h"
+#include "graph_reorder.h"
+
+/********************************* Orderings **********************************/
+
+// Vertex with a sorting key, to sort vertices by key and then by index.
+typedef struct {
+	int key, vertex;
+} graph_reorder_pair_t;
+
+int comp_reorder_pair_asc(const void *p1, const void *p2){
+	const graph_reorder_pair_t *a = p1, *b = p2;
+	if (a->key != b->key){ return a->key < b->key ? -1 : 1; }
+	return a->vertex - b->vertex;
+}
+
+/* Sorts vertices by key with counting sort, keeping vertices with the same key
+ * in increasing order of index. Keys must be between 0 and num_keys-1, and
+ * count must have num_keys+1 positions. */
+void graph_reorder_counting_sort
+		(const int *key, int n, int num_keys, int *order, int *count){
+	int i;
+	memset(count, 0, (num_keys+1) * sizeof(*count));
+	for (i=0; i < n; i++){
+		count[key[i] + 1]++;
+	}
+	for (i=0; i < num_keys; i++){
+		count[i+1] += count[i];
+	}
+	for (i=0; i < n; i++){
+		order[count[key[i]]++] = i;
+	}
+}
+
+int *graph_reorder_degree(const graph_t *g){
+	assert(g);
+	int i, n = graph_num_vertices(g);
+
+	// Degrees of directed graphs count in and out edges, up to 2n-2
+	int *order = malloc(n * sizeof(*order));
+	int *key = malloc(n * sizeof(*key));
+	int *count = malloc((2*n+1) * sizeof(*count));
+	if (!order || !key || !count){
+		free(order); free(key); free(count);
+		return NULL;
+	}
+
+	// Decreasing degree is increasing 2n-1 - degree
+	graph_degree(g, key);
+	for (i=0; i < n; i++){
+		key[i] = 2*n-1 - key[i];
+	}
+	graph_reorder_counting_sort(key, n, 2*n, order, count);
+
+	free(key);
+	free(count);
+	return order;
+}
+
+int *graph_reorder_rcm(const graph_t *g){
+	assert(g);
+	int i, n = graph_num_vertices(g);
+
+	int *order = malloc(n * sizeof(*order));
+	int *degree = malloc(n * sizeof(*degree));
+	int *by_degree = malloc(n * sizeof(*by_degree));
+	int *count = malloc((2*n+1) * sizeof(*count));
+	bool *is_visited = calloc(n, sizeof(*is_visited));
+	graph_reorder_pair_t *adjacent = malloc(n * sizeof(*adjacent));
+	if (!order || !degree || !by_degree || !count || !is_visited || !adjacent){
+		free(order);
+		order = NULL;
+		goto end;
+	}
+
+	graph_degree(g, degree);
+	graph_reorder_counting_sort(degree, n, 2*n, by_degree, count);
+
+	// order is used as the queue of the breadth-first traversal
+	int head = 0, tail = 0, next = 0;
+	while (tail < n){
+		// Starts each component at its vertex with minimum degree
+		while (is_visited[by_degree[next]]){ next++; }
+		is_visited[by_degree[next]] = true;
+		order[tail++] = by_degree[next];
+
+		while (head < tail){
+			int v = order[head++], k = 0;
+			set_entry_t *p;
+			for (p = graph_adjacent_head(g, v); p; p = p->next){
+				if (!is_visited[p->key]){
+					is_visited[p->key] = true;
+					adjacent[k].key = degree[p->key];
+					adjacent[k].vertex = p->key;
+					k++;
+				}
+			}
+			qsort(adjacent, k, sizeof(*adjacent), comp_reorder_pair_asc);
+			for (i=0; i < k; i++){
+				order[tail++] = adjacent[i].vertex;
+			}
+		}
+	}
+
+	for (i=0; i < n/2; i++){
+		int tmp = order[i];
+		order[i] = order[n-1 - i];
+		order[n-1 - i] = tmp;
+	}
+
+end:
+	free(degree);
+	free(by_degree);
+	free(count);
+	free(is_visited);
+	free(adjacent);
+	return order;
+}
+
+/* Propagates labels until they're stable, returning false if there's no memory.
+ * Vertices are visited in a random order at each round, and ties are broken
+ * keeping the current label or at random, with a fixed seed so that the
+ * ordering is reproducible. */
+bool graph_reorder_propagate(const graph_t *g, int *label){
+	int i, n = graph_num_vertices(g);
+	int *frequency = calloc(n, sizeof(*frequency));
+	int *seen = malloc(n * sizeof(*seen));
+	int *visit = malloc(n * sizeof(*visit));
+	if (!frequency || !seen || !visit){
+		free(frequency); free(seen); free(visit);
+		return false;
+	}
+
+	for (i=0; i < n; i++){
+		label[i] = i;
+		visit[i] = i;
+	}
+
+	unsigned int seed = 1;
+	int iteration, num_changed = 1;
+	for (iteration=0;
+	     iteration < GRAPH_REORDER_MAX_ITERATIONS && num_changed > 0;
+	     iteration++){
+		for (i=n-1; i > 0; i--){
+			int j = rand_r(&seed) % (i+1);
+			int tmp = visit[i]; visit[i] = visit[j]; visit[j] = tmp;
+		}
+
+		num_changed = 0;
+		int t;
+		for (t=0; t < n; t++){
+			int v = visit[t];
+			int k = 0, best = label[v], best_frequency = 0, num_ties = 0;
+			set_entry_t *p;
+			for (p = graph_adjacent_head(g, v); p; p = p->next){
+				int l = label[p->key];
+				if (frequency[l]++ == 0){ seen[k++] = l; }
+			}
+			for (i=0; i < k; i++){
+				int l = seen[i];
+				if (frequency[l] > best_frequency){
+					best = l;
+					best_frequency = frequency[l];
+					num_ties = 1;
+				} else if (frequency[l] == best_frequency && best != label[v] &&
+				           (l == label[v] || rand_r(&seed) % ++num_ties == 0)){
+					best = l;
+				}
+			}
+			for (i=0; i < k; i++){
+				frequency[seen[i]] = 0;
+			}
+			if (best != label[v]){
+				label[v] = best;
+				num_changed++;
+			}
+		}
+	}
+
+	free(frequency);
+	free(seen);
+	free(visit);
+	return true;
+}
+
+int *graph_reorder_community(const graph_t *g){
+	assert(g);
+	int i, n = graph_num_vertices(g);
+
+	int *order = malloc(n * sizeof(*order));
+	int *label = malloc(n * sizeof(*label));
+	int *count = malloc((n+1) * sizeof(*count));
+	graph_reorder_pair_t *size = malloc(n * sizeof(*size));
+	if (!order || !label || !count || !size || !graph_reorder_propagate(g, label)){
+		free(order);
+		order = NULL;
+		goto end;
+	}
+
+	// Ranks communities by decreasing size, ties by label
+	for (i=0; i < n; i++){
+		size[i].key = 0;
+		size[i].vertex = i;
+	}
+	for (i=0; i < n; i++){
+		size[label[i]].key--;
+	}
+	qsort(size, n, sizeof(*size), comp_reorder_pair_asc);
+	for (i=0; i < n; i++){
+		count[size[i].vertex] = i;
+	}
+	for (i=0; i < n; i++){
+		label[i] = count[label[i]];
+	}
+	graph_reorder_counting_sort(label, n, n, order, count);
+
+end:
+	free(label);
+	free(count);
+	free(size);
+	return order;
+}
+
+/******************************** Relabeling **********************************/
+
+int *graph_reorder_inverse(const int *order, int n){
+	assert(order);
+	int *label = malloc(n * sizeof(*label));
+	if (!label){ return NULL; }
+
+	int k;
+	for (k=0; k < n; k++){
+		assert(order[k] >= 0 && order[k] < n);
+		label[order[k]] = k;
+	}
+	return label;
+}
+
+graph_t *graph_reorder_apply(const graph_t *g, const int *order){
+	assert(g);
+	assert(order);
+	int i, n = graph_num_vertices(g);
+	bool is_directed = graph_is_directed(g);
+
+	int *label = graph_reorder_inverse(order, n);
+	if (!label){ return NULL; }
+	graph_t *h = new_graph(n, graph_is_weighted(g), is_directed);
+	if (!h){ free(label); return NULL; }
+
+	for (i=0; i < n; i++){
+		set_entry_t *p;
+		for (p = graph_adjacent_head(g, i); p; p = p->next){
+			int j = p->key;
+			if (!is_directed && j < i){ continue; }
+			error_t error = graph_add_weighted_edge
+				(h, label[i], label[j], graph_adjacent_weight(g, i, p));
+			if (error){
+				delete_graph(h);
+				free(label);
+				return NULL;
+			}
+		}
+	}
+
+	free(label);
+	return h;
+}
+
+error_t graph_reorder_restore(const int *order, int n, double *x){
+	assert(order);
+	assert(x);
+	double *copy = malloc(n * sizeof(*copy));
+	if (!copy){ return ERROR_NO_MEMORY; }
+
+	memcpy(copy, x, n * sizeof(*copy));
+	int k;
+	for (k=0; k < n; k++){
+		x[order[k]] = copy[k];
+	}
+
+	free(copy);
+	return ERROR_SUCCESS;
+}
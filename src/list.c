@@ -78,7 +78,7 @@ error_t list_push(list_t *list, int v){
 	list->is_sorted = false;
 	
 	list->arr[list->n++] = v;
-	if (!list_realloc(list)){ return ERROR_NO_MEMORY; }
+	if (list_realloc(list)){ return ERROR_NO_MEMORY; }
 	return ERROR_SUCCESS;
 }
 
@@ -111,7 +111,7 @@ error_t list_put(list_t *list, int pos, int v){
 	list->arr[pos] = v;
 	list->n++;
 	
-	if (!list_realloc(list)){ return ERROR_NO_MEMORY; }
+	if (list_realloc(list)){ return ERROR_NO_MEMORY; }
 	return ERROR_SUCCESS;
 }
 
@@ -144,7 +144,13 @@ void list_clean(list_t *list){
 
 /********************* Sorting and searching **************************/
 void list_sort(list_t *list){
-	list_sorting(list, comp_int_asc);
+	assert(list);
+	
+	// Radix sort avoids a comparator call per comparison
+	if (list->n < LIST_RADIX_SORT_SIZE || radix_sort_int(list->arr, list->n, 1)){
+		list_sorting(list, comp_int_asc);
+	}
+	list->is_sorted = true;
 }
 
 void list_sorting(list_t *list, comparator_fn_t compar){
@@ -206,7 +212,7 @@ error_t list_insert(list_t *list, int v){
 		pos = b;
 	}
 	
-	if (!list_put(list, pos, v)){ return ERROR_NO_MEMORY; }
+	if (list_put(list, pos, v)){ return ERROR_NO_MEMORY; }
 	list->is_sorted = true;
 	return ERROR_SUCCESS;
 }
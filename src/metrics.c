@@ -3,12 +3,16 @@
 #include <math.h>
 #include <string.h>
 #include <pthread.h>
+#include <stdint.h>
+#include <inttypes.h>
 
 #include "sorting.h"
 #include "stat.h"
+#include "table.h"
 #include "graph.h"
 #include "graph_model.h"
 #include "graph_metric.h"
+#include "graph_reorder.h"
 
 #ifndef NUM_PROCESSORS
 	#define NUM_PROCESSORS 8
@@ -25,42 +29,439 @@ bool is_int[NUM_METRIC] = {
 };
 
 #define MAX_NAME_SIZE 19
+#define PAGERANK_DAMPING 0.15
 
 const char *metrics_name[] = {
 	"degree", "clustering", "avg-neighbor-degree", "betweenness", 
 	"eigenvector", "pagerank", "closenness", "k-core"
 }; 
 
-void *experiment(void *args);
+/*********************************** Tasks ************************************/
+
+/* Each dataset is processed by a fixed graph of tasks: loading the graph comes
+ * first, then all metrics may run concurrently and the report is written once
+ * all of them are finished. Tasks of all datasets share the same pool of
+ * NUM_PROCESSORS workers, that always run the ready task with largest cost.
+ */
+enum {
+	LOAD_TASK, DEGREE_TASK, CLUSTERING_TASK, CORRELATION_TASK, 
+	BETWEENNESS_TASK, DISTANCE_TASK, EIGENVECTOR_TASK, PAGERANK_TASK, 
+	CLOSENESS_TASK, K_CORE_TASK, REPORT_TASK,
+	NUM_TASK
+};
+
+const char *tasks_name[] = {
+	"graph", "degree", "clustering", "correlation", 
+	"betweenness", "distance", "eigenvector", "pagerank", 
+	"closenness", "k-core", "report"
+};
+
+// Metric column filled by each task, if any
+int tasks_metric[NUM_TASK] = {
+	-1, DEGREE, CLUSTERING, AVG_DEGREE, 
+	BETWEENNESS, -1, EIGENVECTOR, PAGERANK, 
+	CLOSENNESS, K_CORE, -1
+};
+
+// Tasks and metrics selected in command line, and whether to ignore the cache
+bool is_selected[NUM_TASK];
+bool is_metric_selected[NUM_METRIC];
+bool is_forced = false;
+bool is_binary = false;
+
+// Vertex ordering applied to the giant component before computing metrics
+const char *reorders_name[] = {"degree", "rcm", "community"};
+int *(*reorders[])(const graph_t *g) = {
+	graph_reorder_degree, graph_reorder_rcm, graph_reorder_community
+};
+int reorder = -1;
+
+typedef struct experiment_s experiment_t;
+typedef struct task_s task_t;
+
+struct task_s {
+	void (*run)(experiment_t *e, FILE *summary);
+	experiment_t *e;
+	double cost;           // Estimated running time, set when task is ready
+	int num_pending;       // Number of dependencies not yet finished
+	int num_dependent;
+	task_t *dependent[NUM_TASK];
+	char *output;          // Summary section written by task
+	size_t output_size;
+};
+
+struct experiment_s {
+	const char *folder;
+	uint64_t hash;         // Hash of graph file or generator parameters
+	bool failed;
+	graph_t *g;
+	int *order;            // Original index of each vertex of g, if reordered
+	int n;
+	double **metrics;
+	task_t task[NUM_TASK];
+};
+
+typedef struct {
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	task_t **ready;
+	int num_ready;
+	int num_unfinished;
+} scheduler_t;
+
+scheduler_t scheduler = 
+	{PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, NULL, 0, 0};
+
+void load_task(experiment_t *e, FILE *summary);
+void degree_task(experiment_t *e, FILE *summary);
+void clustering_task(experiment_t *e, FILE *summary);
+void correlation_task(experiment_t *e, FILE *summary);
+void betweenness_task(experiment_t *e, FILE *summary);
+void distance_task(experiment_t *e, FILE *summary);
+void eigenvector_task(experiment_t *e, FILE *summary);
+void pagerank_task(experiment_t *e, FILE *summary);
+void closeness_task(experiment_t *e, FILE *summary);
+void kcore_task(experiment_t *e, FILE *summary);
+void report_task(experiment_t *e, FILE *summary);
+
+void task_depends(task_t *task, task_t *dependency){
+	dependency->dependent[dependency->num_dependent++] = task;
+	task->num_pending++;
+}
+
+void experiment_init(experiment_t *e, const char *folder){
+	void (*run[NUM_TASK])(experiment_t *, FILE *) = {
+		load_task, degree_task, clustering_task, correlation_task,
+		betweenness_task, distance_task, eigenvector_task, pagerank_task,
+		closeness_task, kcore_task, report_task
+	};
+	memset(e, 0, sizeof(*e));
+	e->folder = folder;
+	
+	int i;
+	for (i=0; i < NUM_TASK; i++){
+		e->task[i].run = run[i];
+		e->task[i].e = e;
+	}
+	for (i=DEGREE_TASK; i < REPORT_TASK; i++){
+		task_depends(&e->task[i], &e->task[LOAD_TASK]);
+		task_depends(&e->task[REPORT_TASK], &e->task[i]);
+	}
+}
+
+/* Removes and returns the ready task with largest cost, or NULL if all tasks
+ * are finished. Must be called with the scheduler mutex locked. */
+task_t *scheduler_next(){
+	while (scheduler.num_ready == 0 && scheduler.num_unfinished > 0){
+		pthread_cond_wait(&scheduler.cond, &scheduler.mutex);
+	}
+	if (scheduler.num_ready == 0){
+		return NULL;
+	}
+	
+	int i, max = 0;
+	for (i=1; i < scheduler.num_ready; i++){
+		if (scheduler.ready[i]->cost > scheduler.ready[max]->cost){ max = i; }
+	}
+	task_t *task = scheduler.ready[max];
+	scheduler.ready[max] = scheduler.ready[--scheduler.num_ready];
+	return task;
+}
+
+/*********************************** Cache ************************************/
+
+/* The result of each metric task is saved in <folder>/<task>.cache, with its
+ * summary section and the metric column it fills. A cache file is reused only
+ * if its key, a hash of the graph and of the task parameters, matches; other
+ * files written by the task, like distance.dat, are kept from the run that
+ * created the cache.
+ */
+#define CACHE_MAGIC "MC01"
+#define FNV_OFFSET 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+// 64-bit FNV-1a hash of data, continuing from hash.
+uint64_t fnv1a(const void *data, size_t size, uint64_t hash){
+	const unsigned char *byte = data;
+	size_t i;
+	for (i=0; i < size; i++){
+		hash ^= byte[i];
+		hash *= FNV_PRIME;
+	}
+	return hash;
+}
+
+uint64_t fnv1a_file(const char *filename, uint64_t hash){
+	FILE *fp = fopen(filename, "rb");
+	if (!fp){
+		return hash;
+	}
+	unsigned char buffer[4096];
+	size_t size;
+	while ((size = fread(buffer, 1, sizeof(buffer), fp)) > 0){
+		hash = fnv1a(buffer, size, hash);
+	}
+	fclose(fp);
+	return hash;
+}
+
+uint64_t cache_key(const experiment_t *e, int id){
+	uint64_t key = fnv1a(tasks_name[id], strlen(tasks_name[id]), e->hash);
+	if (id == PAGERANK_TASK){
+		double damping = PAGERANK_DAMPING;
+		key = fnv1a(&damping, sizeof(damping), key);
+	}
+	return key;
+}
+
+bool is_cacheable(int id){
+	return id != LOAD_TASK && id != REPORT_TASK;
+}
+
+/* Reads a cached result of task id, writing its section to summary and its
+ * metric column. Returns false if there is no valid cache. */
+bool cache_load(experiment_t *e, int id, FILE *summary){
+	char str[256]; snprintf(str, 256, "%s/%s.cache", e->folder, tasks_name[id]);
+	FILE *fp = fopen(str, "rb");
+	if (!fp){
+		return false;
+	}
+	
+	char magic[4];
+	uint64_t key, size;
+	int n, metric = tasks_metric[id];
+	bool ok = 
+		fread(magic, 1, 4, fp) == 4 && memcmp(magic, CACHE_MAGIC, 4) == 0 &&
+		fread(&key, sizeof(key), 1, fp) == 1 && key == cache_key(e, id) &&
+		fread(&n, sizeof(n), 1, fp) == 1 && n == e->n &&
+		fread(&size, sizeof(size), 1, fp) == 1;
+	char *section = ok ? malloc(size+1) : NULL;
+	ok = ok && section && fread(section, 1, size, fp) == size;
+	ok = ok && (metric < 0 || fread(e->metrics[metric], sizeof(double), n, fp) == n);
+	if (ok){
+		fwrite(section, 1, size, summary);
+	}
+	free(section);
+	fclose(fp);
+	return ok;
+}
+
+/* Writes the result of a finished task. The file is renamed only when complete,
+ * so a killed run never leaves a partial cache. */
+void cache_save(experiment_t *e, int id){
+	task_t *task = &e->task[id];
+	char str[256]; snprintf(str, 256, "%s/%s.cache", e->folder, tasks_name[id]);
+	char tmp[260]; snprintf(tmp, 260, "%s.tmp", str);
+	FILE *fp = fopen(tmp, "wb");
+	if (!fp){
+		fprintf(stderr, "Can't write cache %s\n", str);
+		return;
+	}
+	
+	uint64_t key = cache_key(e, id), size = task->output_size;
+	int metric = tasks_metric[id];
+	fwrite(CACHE_MAGIC, 1, 4, fp);
+	fwrite(&key, sizeof(key), 1, fp);
+	fwrite(&e->n, sizeof(e->n), 1, fp);
+	fwrite(&size, sizeof(size), 1, fp);
+	fwrite(task->output, 1, size, fp);
+	if (metric >= 0){
+		fwrite(e->metrics[metric], sizeof(double), e->n, fp);
+	}
+	if (fclose(fp) != 0 || rename(tmp, str) != 0){
+		fprintf(stderr, "Can't write cache %s\n", str);
+		remove(tmp);
+	}
+}
+
+/********************************** Workers ***********************************/
+
+/* Marks a task that couldn't run. If loading fails, nothing else runs, and
+ * vertex metrics of a failed task are written as NaN. */
+void task_fail(experiment_t *e, int id){
+	e->task[id].output = NULL;
+	e->task[id].output_size = 0;
+	if (id == LOAD_TASK){
+		e->failed = true;
+		return;
+	}
+	int i, metric = tasks_metric[id];
+	if (metric >= 0){
+		for (i=0; i < e->n; i++){
+			e->metrics[metric][i] = NAN;
+		}
+	}
+}
+
+void *worker(void *args){
+	pthread_mutex_lock(&scheduler.mutex);
+	task_t *task;
+	while ((task = scheduler_next()) != NULL){
+		pthread_mutex_unlock(&scheduler.mutex);
+		
+		experiment_t *e = task->e;
+		int id = task - e->task;
+		bool is_run = is_selected[id] && (!e->failed || id == REPORT_TASK);
+		
+		// The report writes summary.txt directly, other tasks write a section
+		FILE *summary = NULL;
+		if (is_run && id != REPORT_TASK){
+			summary = open_memstream(&task->output, &task->output_size);
+			if (!summary){
+				fprintf(stderr, "No memory for %s in %s\n", tasks_name[id], e->folder);
+				task_fail(e, id);
+				is_run = false;
+			}
+		}
+		bool is_cached = is_run && is_cacheable(id) && !is_forced && 
+		                 cache_load(e, id, summary);
+		if (is_cached){
+			fprintf(stderr, "Loaded %s in %s from cache\n", tasks_name[id], e->folder);
+		} else if (is_run){
+			fprintf(stderr, "Calculating %s in %s...\n", tasks_name[id], e->folder);
+			task->run(e, summary);
+		}
+		if (summary){ fclose(summary); }
+		if (is_run && !is_cached && is_cacheable(id)){
+			cache_save(e, id);
+		}
+		
+		pthread_mutex_lock(&scheduler.mutex);
+		int i;
+		for (i=0; i < task->num_dependent; i++){
+			task_t *dependent = task->dependent[i];
+			if (--dependent->num_pending == 0){
+				scheduler.ready[scheduler.num_ready++] = dependent;
+			}
+		}
+		scheduler.num_unfinished--;
+		pthread_cond_broadcast(&scheduler.cond);
+	}
+	pthread_mutex_unlock(&scheduler.mutex);
+	return NULL;
+}
+
+/* Selects only the metric tasks in a comma-separated list of names. Returns
+ * false if some name is unknown. */
+bool select_tasks(const char *list){
+	int i;
+	for (i=DEGREE_TASK; i < REPORT_TASK; i++){
+		is_selected[i] = false;
+	}
+	
+	char *copy = strdup(list), *save, *name;
+	bool ok = true;
+	for (name = strtok_r(copy, ",", &save); name; name = strtok_r(NULL, ",", &save)){
+		for (i=DEGREE_TASK; i < REPORT_TASK; i++){
+			if (!strcmp(name, tasks_name[i])) break;
+		}
+		if (i == REPORT_TASK){
+			fprintf(stderr, "Unknown metric: %s\n", name);
+			ok = false;
+		} else {
+			is_selected[i] = true;
+		}
+	}
+	free(copy);
+	return ok;
+}
+
+// Selects the vertex ordering with name. Returns false if it's unknown.
+bool select_reorder(const char *name){
+	int num_reorder = sizeof(reorders)/sizeof(reorders[0]);
+	for (reorder=0; reorder < num_reorder; reorder++){
+		if (!strcmp(name, reorders_name[reorder])){ return true; }
+	}
+	fprintf(stderr, "Unknown ordering: %s\n", name);
+	reorder = -1;
+	return false;
+}
+
+void print_usage(){
+	printf("Usage: metrics [-m|--metrics <names>] [-f|--force] [-b|--binary]\n"
+	       "               [-r|--reorder <ordering>] <folders>\n"
+	       "       Each folder should have a file called edges.txt\n"
+	       "\n"
+	       "-m|--metrics: comma-separated list of metrics to calculate, from\n"
+	       "              degree, clustering, correlation, betweenness, distance,\n"
+	       "              eigenvector, pagerank, closenness and k-core (default all)\n"
+	       "-f|--force:   recalculate metrics even if they are in the cache\n"
+	       "-b|--binary:  write vertex metrics to metrics.bin, in the format of\n"
+	       "              table_write, instead of metrics.dat\n"
+	       "-r|--reorder: relabel vertices with ordering degree, rcm or community\n"
+	       "              to improve memory locality; vertex metrics are still\n"
+	       "              written in the original order\n");
+}
 
 int main(int argc, char *argv[]){
-	if (argc == 1){
-		printf("Usage: experiment <folders>\n"
-		       "       Each folder should have a file called edges.txt\n");
+	int i, n = 0;
+	const char **folder = malloc(argc * sizeof(*folder));
+	for (i=0; i < NUM_TASK; i++){
+		is_selected[i] = true;
+	}
+	
+	for (i=1; i < argc; i++){
+		if (!strcmp(argv[i], "-m") || !strcmp(argv[i], "--metrics")){
+			if (++i == argc || !select_tasks(argv[i])){
+				print_usage();
+				exit(EXIT_FAILURE);
+			}
+		} else if (!strcmp(argv[i], "-f") || !strcmp(argv[i], "--force")){
+			is_forced = true;
+		} else if (!strcmp(argv[i], "-b") || !strcmp(argv[i], "--binary")){
+			is_binary = true;
+		} else if (!strcmp(argv[i], "-r") || !strcmp(argv[i], "--reorder")){
+			if (++i == argc || !select_reorder(argv[i])){
+				print_usage();
+				exit(EXIT_FAILURE);
+			}
+		} else {
+			folder[n++] = argv[i];
+		}
+	}
+	if (n == 0){
+		print_usage();
 		exit(EXIT_SUCCESS);
 	}
+	// Some selections, like "-m distance", have no vertex metric, so the report
+	//skips the correlation section
+	for (i=0; i < NUM_TASK; i++){
+		if (tasks_metric[i] >= 0){
+			is_metric_selected[tasks_metric[i]] = is_selected[i];
+		}
+	}
 	
-	int i, n = argc-1;
-	pthread_t *thread = malloc(n * sizeof(*thread));
+	experiment_t *experiment = malloc(n * sizeof(*experiment));
+	scheduler.ready = malloc(n * NUM_TASK * sizeof(*scheduler.ready));
 	
 	for (i=0; i < n; i++){
-		pthread_create(&thread[i], NULL, experiment, argv[i+1]);
+		experiment_init(&experiment[i], folder[i]);
+		scheduler.ready[scheduler.num_ready++] = &experiment[i].task[LOAD_TASK];
 	}
+	scheduler.num_unfinished = n * NUM_TASK;
 	fprintf(stderr, "%d experiments launched\n", n);
 	
-	for (i=0; i < n; i++){
+	// Main thread is also a worker
+	pthread_t thread[NUM_PROCESSORS];
+	for (i=1; i < NUM_PROCESSORS; i++){
+		pthread_create(&thread[i], NULL, worker, NULL);
+	}
+	worker(NULL);
+	for (i=1; i < NUM_PROCESSORS; i++){
 		void *dummy;
 		pthread_join(thread[i], &dummy);
 	}
 	
-	free(thread);
+	free(scheduler.ready);
+	free(experiment);
+	free(folder);
 	printf("success\n");
 	return 0;
 }
 
 void general_info(FILE *summary, graph_t *g){
 	fprintf(summary, "number of vertices = %d\n", graph_num_vertices(g));
-	fprintf(summary, "number of edges = %d\n", graph_num_edges(g));
+	fprintf(summary, "number of edges = %" PRId64 "\n", graph_num_edges(g));
 }
 
 void component_info(FILE *summary, graph_t *g){
@@ -204,10 +605,10 @@ void betweenness_info(FILE *summary, graph_t *g, double **metrics){
 void distance_info(FILE *summary, graph_t *g, const char *folder){
 	int n = graph_num_vertices(g);
 	int diameter;
-	int *distance = graph_geodesic_distribution(g, &diameter);
+	int64_t *distance = graph_geodesic_distribution(g, &diameter);
 	
 	double avg = stat_int_dist_average(distance, diameter);
-	double eff = stat_int_dist_harmonic_sum(distance, diameter)/(n*(n-1));
+	double eff = stat_int_dist_harmonic_sum(distance, diameter)/((double)n*(n-1));
 	fprintf(summary, "distance average = %.3lf\n", avg);
 	fprintf(summary, "efficiency = %.3lf\n", eff);
 	fprintf(summary, "diameter = %d\n", diameter);
@@ -216,47 +617,46 @@ void distance_info(FILE *summary, graph_t *g, const char *folder){
 	FILE *fp = fopen(str, "wt");
 	int i;
 	for (i=0; i < diameter; i++){
-		fprintf(fp, "%d %d\n", i, distance[i]);
+		fprintf(fp, "%d %" PRId64 "\n", i, distance[i]);
 	}
 	fclose(fp);
 	free(distance);
 }
 
-void centrality_info
-		(FILE *summary, graph_t *g, const char *folder, double **metrics){
-	int i, j, n = graph_num_vertices(g);
-	
-	double *eigenvector = metrics[EIGENVECTOR];
-	double *pagerank = metrics[PAGERANK];
-	double *closenness = metrics[CLOSENNESS];
-	int *k = malloc(n * sizeof(*k));
-	double *core = metrics[K_CORE];
-	
-	graph_eigenvector(g, eigenvector);
-	graph_pagerank(g, 0.15, pagerank);
-	graph_closeness(g, closenness);
-	int degeneracy = graph_kcore(g, k);
-	
-	fprintf(summary, "degeneracy = %d\n", degeneracy);
+void metrics_correlation_info
+		(FILE *summary, const char *folder, double **metrics, int n){
+	int i, j;
 	
-	for (i=0; i < n; i++){
-		core[i] = (double)k[i];
+	// Only selected metrics are correlated
+	const double *column[NUM_METRIC];
+	int index[NUM_METRIC], num_var = 0;
+	for (i=0; i < NUM_METRIC; i++){
+		if (is_metric_selected[i]){
+			index[num_var] = i;
+			column[num_var++] = metrics[i];
+		}
 	}
-	free(k);
+	
+	// Selections such as "-m distance" have no vertex metric to correlate
+	if (num_var == 0){ return; }
 	
 	// Metrics correlation
 	fprintf(summary, "\nMetrics correlation\n");
 	fprintf(summary, "%*s ", MAX_NAME_SIZE, " ");
-	for (i=0; i < NUM_METRIC; i++){
-		fprintf(summary, "%*s ", MAX_NAME_SIZE, metrics_name[i]);
+	for (i=0; i < num_var; i++){
+		fprintf(summary, "%*s ", MAX_NAME_SIZE, metrics_name[index[i]]);
 	}
 	fprintf(summary, "\n");
 	
-	for (i=0; i < NUM_METRIC; i++){
-		fprintf(summary, "%*s ", MAX_NAME_SIZE, metrics_name[i]);
-		for (j=0; j < NUM_METRIC; j++){
-			double r = stat_pearson(metrics[i], metrics[j], n);
-			fprintf(summary, "%+*.6lf ", MAX_NAME_SIZE, r);
+	double r[NUM_METRIC * NUM_METRIC];
+	if (stat_correlation_matrix(column, num_var, n, r) != ERROR_SUCCESS){
+		fprintf(stderr, "No memory for metrics correlation in %s\n", folder);
+		return;
+	}
+	for (i=0; i < num_var; i++){
+		fprintf(summary, "%*s ", MAX_NAME_SIZE, metrics_name[index[i]]);
+		for (j=0; j < num_var; j++){
+			fprintf(summary, "%+*.6lf ", MAX_NAME_SIZE, r[i*num_var + j]);
 		}
 		fprintf(summary, "\n");
 	}
@@ -269,6 +669,7 @@ void print_metrics(const char *folder, double **metrics, int n){
 	
 	fprintf(fp, "%*s ", MAX_NAME_SIZE, "#vertex");
 	for (j=0; j < NUM_METRIC; j++){
+		if (!is_metric_selected[j]){ continue; }
 		fprintf(fp, "%*s ", MAX_NAME_SIZE, metrics_name[j]);
 	}
 	fprintf(fp, "\n");
@@ -277,6 +678,7 @@ void print_metrics(const char *folder, double **metrics, int n){
 	for (i=0; i < n; i++){
 		fprintf(fp, "%*d ", MAX_NAME_SIZE, i);
 		for (j=0; j < NUM_METRIC; j++){
+			if (!is_metric_selected[j]){ continue; }
 			double val = metrics[j][i];
 			if (is_int[j]){ fprintf(fp, "%*.0lf ", MAX_NAME_SIZE, val); }
 			else          { fprintf(fp, "%*.6le ", MAX_NAME_SIZE, val); }
@@ -286,43 +688,148 @@ void print_metrics(const char *folder, double **metrics, int n){
 	fclose(fp);
 }
 
+// Writes selected metrics as columns of metrics.bin, with integer metrics as int.
+void print_metrics_binary(const char *folder, double **metrics, int n){
+	int i, j, num_column = 0;
+	table_column_t column[NUM_METRIC];
+	for (j=0; j < NUM_METRIC; j++){
+		if (!is_metric_selected[j]){ continue; }
+		column[num_column].name = (char *)metrics_name[j];
+		if (is_int[j]){
+			int *value = malloc(n * sizeof(*value));
+			for (i=0; i < n; i++){
+				value[i] = (int)metrics[j][i];
+			}
+			column[num_column].type = TABLE_INT;
+			column[num_column].data = value;
+		} else {
+			column[num_column].type = TABLE_DOUBLE;
+			column[num_column].data = metrics[j];
+		}
+		num_column++;
+	}
+	
+	char str[256]; snprintf(str, 256, "%s/metrics.bin", folder);
+	if (table_write(str, column, num_column, n) != ERROR_SUCCESS){
+		fprintf(stderr, "Can't write %s\n", str);
+	}
+	for (j=0; j < num_column; j++){
+		if (column[j].type == TABLE_INT){ free(column[j].data); }
+	}
+}
+
 void print_histograms(const char *folder, double **metrics, int n){
 	int i, j;
+	int *value = malloc(n * sizeof(*value));
 	
 	for (i=0; i < NUM_METRIC; i++){
+		if (!is_metric_selected[i]){ continue; }
 		char str[256]; snprintf(str, 256, "%s/%s.dat", folder, metrics_name[i]);
 		FILE *fp = fopen(str, "wt");
 		
-		int num_bins = 20;
 		if (is_int[i]){
-			double min = metrics[i][0], max = metrics[i][0];
-			for (j=1; j < n; j++){
-				if (metrics[i][j] < min){ min = metrics[i][j]; }
-				if (metrics[i][j] > max){ max = metrics[i][j]; }
+			// Integer metrics are counted exactly
+			for (j=0; j < n; j++){
+				value[j] = (int)metrics[i][j];
 			}
-			num_bins = (int)(max - min);
+			int num_keys;
+			pair_t *freq = stat_frequencies(value, n, &num_keys);
+			for (j=0; j < num_keys; j++){
+				fprintf(fp, "%le %d\n", (double)freq[j].key, freq[j].value);
+			}
+			free(freq);
+		} else {
+			int num_bins = 20;
+			interval_t *hist = stat_histogram(metrics[i], n, num_bins);
+			for (j=0; j < num_bins; j++){
+				double x = (hist[j].min + hist[j].max)/2;
+				fprintf(fp, "%le %d\n", x, hist[j].value);
+			}
+			free(hist);
 		}
-		interval_t *hist = stat_histogram(metrics[i], n, num_bins);
 		
-		for (j=0; j < num_bins-2; j++){
-			double x = is_int[i] ? hist[j].min : (hist[j].min + hist[j].max)/2;
-			fprintf(fp, "%le %d\n", x, hist[j].value);
+		fclose(fp);
+	}
+	free(value);
+}
+
+void distribution_info
+		(FILE *summary, const char *folder, double **metrics, int n){
+	int i, j;
+	double quantile[] = {0.01, 0.1, 0.5, 0.9, 0.99};
+	int num_quantile = sizeof(quantile)/sizeof(quantile[0]);
+	
+	fprintf(summary, "\nMetrics quantiles\n");
+	fprintf(summary, "%*s ", MAX_NAME_SIZE, " ");
+	for (j=0; j < num_quantile; j++){
+		fprintf(summary, "%*.2lf ", MAX_NAME_SIZE, quantile[j]);
+	}
+	fprintf(summary, "\n");
+	
+	for (i=0; i < NUM_METRIC; i++){
+		if (!is_metric_selected[i]){ continue; }
+		stat_kll_t *sketch = new_stat_kll(STAT_KLL_K, i);
+		if (!sketch || stat_kll_push_array(sketch, metrics[i], n) != ERROR_SUCCESS){
+			fprintf(stderr, "No memory for %s quantiles in %s\n", 
+			        metrics_name[i], folder);
+			delete_stat_kll(sketch);
+			continue;
 		}
-		double x = is_int[i] ? hist[j].min : (hist[j].min + hist[j].max)/2;
-		fprintf(fp, "%le %d", x, hist[j].value + hist[j+1].value);
+		fprintf(summary, "%*s ", MAX_NAME_SIZE, metrics_name[i]);
+		for (j=0; j < num_quantile; j++){
+			fprintf(summary, "%*.6le ", MAX_NAME_SIZE, 
+			        stat_kll_quantile(sketch, quantile[j]));
+		}
+		fprintf(summary, "\n");
+		delete_stat_kll(sketch);
 		
-		free(hist);
+		// Log-binned distribution of positive values
+		double xmin = 1.0/0.0;
+		for (j=0; j < n; j++){
+			if (metrics[i][j] > 0.0 && metrics[i][j] < xmin){ xmin = metrics[i][j]; }
+		}
+		if (isinf(xmin)){ continue; }
+		
+		stat_log_bins_t bins;
+		stat_log_bins_init(&bins, xmin, STAT_LOG_BINS_PER_DECADE);
+		for (j=0; j < n; j++){
+			stat_log_bins_push(&bins, metrics[i][j]);
+		}
+		char str[256]; snprintf(str, 256, "%s/%s-log.dat", folder, metrics_name[i]);
+		FILE *fp = fopen(str, "wt");
+		for (j=0; j < bins.num_bins; j++){
+			if (bins.count[j] > 0.0){
+				double x = sqrt(stat_log_bins_edge(&bins, j) * 
+				                stat_log_bins_edge(&bins, j+1));
+				fprintf(fp, "%le %le\n", x, stat_log_bins_density(&bins, j));
+			}
+		}
 		fclose(fp);
+		stat_log_bins_free(&bins);
+	}
+	
+	// Degree exponent, assuming the whole distribution is a power-law
+	if (!is_metric_selected[DEGREE]){ return; }
+	double kmin = 1.0/0.0;
+	for (j=0; j < n; j++){
+		if (metrics[DEGREE][j] > 0.0 && metrics[DEGREE][j] < kmin){ 
+			kmin = metrics[DEGREE][j];
+		}
 	}
+	stat_power_law_t power_law;
+	stat_power_law_init(&power_law, kmin, true);
+	for (j=0; j < n; j++){
+		stat_power_law_push(&power_law, metrics[DEGREE][j]);
+	}
+	double error, alpha = stat_power_law_alpha(&power_law, &error);
+	fprintf(summary, "\ndegree power-law exponent (k >= %.0lf) = %.3lf +- %.3lf\n", 
+	        kmin, alpha, error);
 }
 
-void *experiment(void *args){
-	const char *folder = (char *)args;
+void load_task(experiment_t *e, FILE *summary){
+	const char *folder = e->folder;
 	char str[256];
 	
-	snprintf(str, 256, "%s/summary.txt", folder);
-	FILE *f_summary = fopen(str, "wt");
-	
 	bool is_directed = false;
 	snprintf(str, 256, "%s/edges.txt", folder);
 	graph_t *complete = NULL;
@@ -333,6 +840,12 @@ void *experiment(void *args){
 	unsigned int ns = 1;
 	double beta = 0.4;
 
+	e->hash = fnv1a(folder, strlen(folder), FNV_OFFSET);
+	e->hash = fnv1a(&nv, sizeof(nv), e->hash);
+	e->hash = fnv1a(&k, sizeof(k), e->hash);
+	e->hash = fnv1a(&ns, sizeof(ns), e->hash);
+	e->hash = fnv1a(&beta, sizeof(beta), e->hash);
+
 	if(strcmp("../datasets/K", folder) == 0){
 	}
 	else if(strcmp("../datasets/ER", folder) == 0){
@@ -346,16 +859,39 @@ void *experiment(void *args){
 	}
 	else {
 		complete = load_graph(str, is_directed);
+		e->hash = fnv1a_file(str, fnv1a(&is_directed, sizeof(is_directed), FNV_OFFSET));
+	}
+	
+	if (!complete){
+		fprintf(stderr, "Could not load graph in %s\n", folder);
+		e->failed = true;
+		return;
 	}
 	
-	general_info(f_summary, complete);
-	component_info(f_summary, complete);
+	general_info(summary, complete);
+	component_info(summary, complete);
 	
-	fprintf(stderr, "Extracting giant component in %s...\n", folder);
 	graph_t *g = graph_giant_component(complete);
 	int n = graph_num_vertices(g);
+	double m = graph_num_edges(g);
 	delete_graph(complete);
 	
+	// Metrics are restored to the giant component's indices in the report
+	if (reorder >= 0){
+		int *order = reorders[reorder](g);
+		graph_t *h = order ? graph_reorder_apply(g, order) : NULL;
+		if (h){
+			delete_graph(g);
+			g = h;
+			e->order = order;
+			e->hash = fnv1a(reorders_name[reorder], strlen(reorders_name[reorder]),
+			                e->hash);
+		} else {
+			fprintf(stderr, "Could not reorder graph in %s\n", folder);
+			free(order);
+		}
+	}
+	
 	// Allocate metrics matrix
 	double **metrics = malloc(NUM_METRIC * sizeof(*metrics));
 	metrics[0] = malloc(NUM_METRIC * n * sizeof(*metrics[0]));
@@ -363,32 +899,105 @@ void *experiment(void *args){
 	for (i=1; i < NUM_METRIC; i++){
 		metrics[i] = metrics[0] + i*n;
 	}
+	e->g = g;
+	e->n = n;
+	e->metrics = metrics;
 	
-	fprintf(stderr, "Calculating degree in %s...\n", folder);
-	degree_info(f_summary, g, metrics);
-	
-	fprintf(stderr, "Calculating clustering in %s...\n", folder);
-	clustering_info(f_summary, g, folder, metrics);
-	
-	fprintf(stderr, "Calculating degree correlation in %s...\n", folder);
-	correlation_info(f_summary, g, folder, metrics);
-	
-	fprintf(stderr, "Calculating betweenness in %s...\n", folder);
-	betweenness_info(f_summary, g, metrics);
+	// All-pairs shortest paths dominate, the other metrics are about linear
+	for (i=DEGREE_TASK; i < NUM_TASK; i++){
+		e->task[i].cost = m;
+	}
+	e->task[BETWEENNESS_TASK].cost = n * m;
+	e->task[DISTANCE_TASK].cost = n * m;
+	e->task[CLOSENESS_TASK].cost = n * m;
+}
+
+void degree_task(experiment_t *e, FILE *summary){
+	degree_info(summary, e->g, e->metrics);
+}
+
+void clustering_task(experiment_t *e, FILE *summary){
+	clustering_info(summary, e->g, e->folder, e->metrics);
+}
+
+void correlation_task(experiment_t *e, FILE *summary){
+	correlation_info(summary, e->g, e->folder, e->metrics);
+}
+
+void betweenness_task(experiment_t *e, FILE *summary){
+	betweenness_info(summary, e->g, e->metrics);
+}
+
+void distance_task(experiment_t *e, FILE *summary){
+	distance_info(summary, e->g, e->folder);
+}
+
+void eigenvector_task(experiment_t *e, FILE *summary){
+	graph_eigenvector(e->g, e->metrics[EIGENVECTOR]);
+}
+
+void pagerank_task(experiment_t *e, FILE *summary){
+	graph_pagerank(e->g, PAGERANK_DAMPING, e->metrics[PAGERANK]);
+}
+
+void closeness_task(experiment_t *e, FILE *summary){
+	graph_closeness(e->g, e->metrics[CLOSENNESS]);
+}
+
+void kcore_task(experiment_t *e, FILE *summary){
+	int i, n = e->n;
+	int *k = malloc(n * sizeof(*k));
+	int degeneracy = graph_kcore(e->g, k);
 	
-	fprintf(stderr, "Calculating distance in %s...\n", folder);
-	distance_info(f_summary, g, folder);
+	fprintf(summary, "degeneracy = %d\n", degeneracy);
 	
-	fprintf(stderr, "Calculating centralities in %s\n", folder);
-	centrality_info(f_summary, g, folder, metrics);
+	for (i=0; i < n; i++){
+		e->metrics[K_CORE][i] = (double)k[i];
+	}
+	free(k);
+}
+
+/* Writes the sections of all tasks in order to summary.txt, followed by the
+ * results that need all metrics. */
+void report_task(experiment_t *e, FILE *summary){
+	const char *folder = e->folder;
+	char str[256];
 	
-	print_metrics(folder, metrics, n);
-	print_histograms(folder, metrics, n);
+	snprintf(str, 256, "%s/summary.txt", folder);
+	FILE *f_summary = fopen(str, "wt");
+	int i;
+	for (i=0; i < REPORT_TASK; i++){
+		if (!e->task[i].output){ continue; }
+		fwrite(e->task[i].output, 1, e->task[i].output_size, f_summary);
+		free(e->task[i].output);
+	}
 	
-	free(metrics);
-	free(metrics[0]);
-	delete_graph(g);
+	if (!e->failed){
+		// If some metric can't be restored, vertices are in mixed orders, and
+		//only the distributions of each metric are still valid
+		bool is_restored = true;
+		if (e->order){
+			for (i=0; i < NUM_METRIC && is_restored; i++){
+				is_restored = 
+					graph_reorder_restore(e->order, e->n, e->metrics[i]) == ERROR_SUCCESS;
+			}
+			free(e->order);
+		}
+		if (is_restored){
+			metrics_correlation_info(f_summary, folder, e->metrics, e->n);
+			if (is_binary){ print_metrics_binary(folder, e->metrics, e->n); }
+			else          { print_metrics(folder, e->metrics, e->n); }
+		} else {
+			fprintf(stderr, "No memory to restore vertex order in %s, "
+			                "vertex metrics not written\n", folder);
+		}
+		print_histograms(folder, e->metrics, e->n);
+		distribution_info(f_summary, folder, e->metrics, e->n);
+		
+		free(e->metrics[0]);
+		free(e->metrics);
+		delete_graph(e->g);
+	}
 	fclose(f_summary);
 	fprintf(stderr, "Processing in %s completed\n", folder);
-	return NULL;
 }
@@ -0,0 +1,259 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+#include "ode.h"
+
+/************************** Dormand-Prince tableau ****************************/
+
+static const double
+	a21 = 1.0/5.0,
+	a31 = 3.0/40.0,       a32 = 9.0/40.0,
+	a41 = 44.0/45.0,      a42 = -56.0/15.0,      a43 = 32.0/9.0,
+	a51 = 19372.0/6561.0, a52 = -25360.0/2187.0, a53 = 64448.0/6561.0,
+	a54 = -212.0/729.0,
+	a61 = 9017.0/3168.0,  a62 = -355.0/33.0,     a63 = 46732.0/5247.0,
+	a64 = 49.0/176.0,     a65 = -5103.0/18656.0,
+	a71 = 35.0/384.0,     a73 = 500.0/1113.0,    a74 = 125.0/192.0,
+	a75 = -2187.0/6784.0, a76 = 11.0/84.0;
+
+// Difference between 5th and 4th order solutions
+static const double
+	e1 = 71.0/57600.0,    e3 = -71.0/16695.0,    e4 = 71.0/1920.0,
+	e5 = -17253.0/339200.0, e6 = 22.0/525.0,     e7 = -1.0/40.0;
+
+// Continuous extension of order 4 (Hairer, Norsett & Wanner)
+static const double
+	d1 = -12715105075.0/11282082432.0,  d3 = 87487479700.0/32700410799.0,
+	d4 = -10690763975.0/1880347072.0,   d5 = 701980252875.0/199316789632.0,
+	d6 = -1453857185.0/822651844.0,     d7 = 69997945.0/29380423.0;
+
+/****************************** Dense output **********************************/
+
+// Interpolates position i of the last accepted step at theta in [0, 1].
+double ode_dense(double **r, int i, double theta){
+	double theta1 = 1.0 - theta;
+	return r[0][i] + theta*(r[1][i] + theta1*(r[2][i] +
+	                 theta*(r[3][i] + theta1*r[4][i])));
+}
+
+void ode_dense_all(double **r, int size, double theta, double *x){
+	int i;
+	for (i=0; i < size; i++){
+		x[i] = ode_dense(r, i, theta);
+	}
+}
+
+void ode_dense_member
+		(double **r, int n, int m, int j, double theta, double *x){
+	int k;
+	for (k=0; k < n; k++){
+		x[k*m + j] = ode_dense(r, k*m + j, theta);
+	}
+}
+
+// Finds the smallest theta in (0, 1] such that member j is stopped, assuming
+//it is not stopped at theta == 0 and is stopped at theta == 1.
+double ode_locate_event
+		(ode_stop_f stop, const void *params, double **r, int n, int m, int j,
+		 double t, double h, double *buffer){
+	double lo = 0.0, hi = 1.0;
+	int it;
+	for (it=0; it < ODE_EVENT_ITERATIONS; it++){
+		double mid = (lo + hi)/2;
+		ode_dense_member(r, n, m, j, mid, buffer);
+		if (stop(t + mid*h, buffer, m, j, params)){ hi = mid; }
+		else                                       { lo = mid; }
+	}
+	return hi;
+}
+
+/**************************** Step size control *******************************/
+
+double ode_initial_step
+		(const double *x, const double *dx, int size, double t_max){
+	double d0 = 0.0, d1 = 0.0;
+	int i;
+	for (i=0; i < size; i++){
+		double sc = ODE_ABSOLUTE_TOLERANCE + ODE_RELATIVE_TOLERANCE * fabs(x[i]);
+		d0 += (x[i]/sc) * (x[i]/sc);
+		d1 += (dx[i]/sc) * (dx[i]/sc);
+	}
+	d0 = sqrt(d0/size);
+	d1 = sqrt(d1/size);
+
+	double h = (d0 < 1e-5 || d1 < 1e-5) ? 1e-6 : 0.01 * d0/d1;
+	return h < t_max ? h : t_max;
+}
+
+/******************************* Integration **********************************/
+
+int ode_dopri5
+		(ode_deriv_f f, ode_stop_f stop, const void *params,
+		 double *x, int n, int m, double dt, double t_max,
+		 double *t_stop, double *x_stop,
+		 ode_sample_f sample, void *data){
+	assert(f);
+	assert(stop);
+	assert(x);
+	assert(n > 0);
+	assert(m > 0);
+	assert(dt >= 0.0);
+	assert(t_max > 0.0);
+
+	int i, j, s, size = n*m;
+
+	// k[0..6] are the stages, r[0..4] the dense output coefficients, and
+	//y, ytmp and buffer are temporaries.
+	double *work = malloc(15 * size * sizeof(*work));
+	bool *is_done = malloc(m * sizeof(*is_done));
+	if (!work || !is_done){ free(work); free(is_done); return -1; }
+
+	double *k[7], *r[5];
+	for (s=0; s < 7; s++){ k[s] = work + s*size; }
+	for (s=0; s < 5; s++){ r[s] = work + (7+s)*size; }
+	double *y      = work + 12*size;
+	double *ytmp   = work + 13*size;
+	double *buffer = work + 14*size;
+
+	double t = 0.0;
+	int num_done = 0;
+
+	for (j=0; j < m; j++){
+		is_done[j] = stop(t, x, m, j, params);
+		if (t_stop){ t_stop[j] = is_done[j] ? t : t_max; }
+		if (is_done[j]){
+			num_done++;
+			if (x_stop){ for (i=0; i < n; i++){ x_stop[i*m+j] = x[i*m+j]; } }
+		}
+	}
+
+	if (sample){ sample(t, x, n, m, data); }
+	int num_sample = 1;
+
+	f(k[0], x, m, params);
+	double h = ode_initial_step(x, k[0], size, t_max);
+
+	int num_steps = 0, num_tries = 0;
+	bool is_failure = false;
+	double t_final = t;
+
+	while (num_done < m && t < t_max){
+		if (num_tries++ == ODE_MAX_STEPS || h < 1e-14 * (1.0 + t)){
+			is_failure = true;
+			break;
+		}
+		if (t + h > t_max){ h = t_max - t; }
+
+		// Stages
+		for (i=0; i < size; i++){
+			ytmp[i] = x[i] + h*a21*k[0][i];
+		}
+		f(k[1], ytmp, m, params);
+		for (i=0; i < size; i++){
+			ytmp[i] = x[i] + h*(a31*k[0][i] + a32*k[1][i]);
+		}
+		f(k[2], ytmp, m, params);
+		for (i=0; i < size; i++){
+			ytmp[i] = x[i] + h*(a41*k[0][i] + a42*k[1][i] + a43*k[2][i]);
+		}
+		f(k[3], ytmp, m, params);
+		for (i=0; i < size; i++){
+			ytmp[i] = x[i] + h*(a51*k[0][i] + a52*k[1][i] + a53*k[2][i] +
+			                    a54*k[3][i]);
+		}
+		f(k[4], ytmp, m, params);
+		for (i=0; i < size; i++){
+			ytmp[i] = x[i] + h*(a61*k[0][i] + a62*k[1][i] + a63*k[2][i] +
+			                    a64*k[3][i] + a65*k[4][i]);
+		}
+		f(k[5], ytmp, m, params);
+		for (i=0; i < size; i++){
+			y[i] = x[i] + h*(a71*k[0][i] + a73*k[2][i] + a74*k[3][i] +
+			                 a75*k[4][i] + a76*k[5][i]);
+		}
+		f(k[6], y, m, params);
+
+		// Scaled RMS norm of the local error estimate
+		double err = 0.0;
+		for (i=0; i < size; i++){
+			double e = h*(e1*k[0][i] + e3*k[2][i] + e4*k[3][i] +
+			              e5*k[4][i] + e6*k[5][i] + e7*k[6][i]);
+			double xmax = fabs(x[i]) > fabs(y[i]) ? fabs(x[i]) : fabs(y[i]);
+			double sc = ODE_ABSOLUTE_TOLERANCE + ODE_RELATIVE_TOLERANCE * xmax;
+			err += (e/sc) * (e/sc);
+		}
+		err = sqrt(err/size);
+
+		double factor = err > 0.0 ? 0.9 * pow(err, -0.2) : 10.0;
+		if (err > 1.0){
+			// Rejected step
+			h *= factor < 0.2 ? 0.2 : factor;
+			continue;
+		}
+		num_steps++;
+
+		// Dense output coefficients of the accepted step
+		for (i=0; i < size; i++){
+			double dy = y[i] - x[i];
+			r[0][i] = x[i];
+			r[1][i] = dy;
+			r[2][i] = h*k[0][i] - dy;
+			r[3][i] = dy - h*k[6][i] - r[2][i];
+			r[4][i] = h*(d1*k[0][i] + d3*k[2][i] + d4*k[3][i] +
+			             d5*k[4][i] + d6*k[5][i] + d7*k[6][i]);
+		}
+
+		// Stop events
+		double theta_final = 1.0;
+		bool is_new_done = false;
+		for (j=0; j < m; j++){
+			if (!is_done[j] && stop(t+h, y, m, j, params)){
+				double theta =
+					ode_locate_event(stop, params, r, n, m, j, t, h, buffer);
+				is_done[j] = true;
+				num_done++;
+
+				if (t_stop){ t_stop[j] = t + theta*h; }
+				if (x_stop){
+					ode_dense_member(r, n, m, j, theta, buffer);
+					for (i=0; i < n; i++){ x_stop[i*m+j] = buffer[i*m+j]; }
+				}
+
+				if (!is_new_done || theta > theta_final){ theta_final = theta; }
+				is_new_done = true;
+			}
+		}
+		if (num_done < m){ theta_final = 1.0; }
+		t_final = t + theta_final*h;
+
+		// Samples strictly inside the step; the final time is sampled at the end
+		while (sample && dt > 0.0 && num_sample*dt < t_final){
+			double theta = (num_sample*dt - t)/h;
+			ode_dense_all(r, size, theta, buffer);
+			sample(num_sample*dt, buffer, n, m, data);
+			num_sample++;
+		}
+
+		if (num_done == m && theta_final < 1.0)
+		{
+			ode_dense_all(r, size, theta_final, x);
+		}
+		else
+		{
+			memcpy(x, y, size * sizeof(*x));
+			memcpy(k[0], k[6], size * sizeof(*k[0])); // First same as last
+		}
+		t = t_final;
+
+		h *= factor > 10.0 ? 10.0 : factor;
+	}
+
+	if (sample && !is_failure && t > 0.0){ sample(t, x, n, m, data); }
+
+	free(work);
+	free(is_done);
+	return is_failure ? -1 : num_steps;
+}
@@ -8,6 +8,7 @@
 #include "graph.h"
 #include "graph_model.h"
 #include "graph_propagation.h"
+#include "table.h"
 
 #define NAN 0.0/0.0
 
@@ -243,8 +244,9 @@ void print_usage(){
 		  "       ((-d|--dataset) {folder}|\n"
 		  "        (-n|--network) <network-model> <params> [(-N|--network-seed) <value>])\n"
 		  "       (-p|--propagation) <propagation-model> [(-P|--propagation-seed) <value>]\n"
-		  "       [(-o|--outfile) <file>]\n"
+		  "       [(-o|--outfile) <file> [-b|--binary]]\n"
 		  "       [(-r|--repetition) <r>]\n"
+		  "       [(-a|--animation) <file>]\n"
 		  "\n");
 		
 		printf("<network-model> = (");
@@ -301,6 +303,8 @@ short propagation_model = -1;
 unsigned int propagation_seed = 1;
 const char *filename = NULL;
 int r = 1;
+const char *animation = NULL;
+bool is_binary = false;
 
 void parse_args(str_stream_t *stream){
 	stream->pos = 1;
@@ -357,6 +361,14 @@ void parse_args(str_stream_t *stream){
 		{
 			r = parse_uint(stream_next(stream), "repetition");
 		}
+		else if (is_arg(arg, 'a', "animation"))
+		{
+			animation = stream_next(stream);
+		}
+		else if (is_arg(arg, 'b', "binary"))
+		{
+			is_binary = true;
+		}
 	}
 }
 
@@ -370,6 +382,8 @@ void print_args(){
 	printf("propagation-seed : %d\n", propagation_seed);
 	printf("outfile: %s\n", filename ? filename : "");
 	printf("repetition : %d\n", r);
+	printf("animation : %s\n", animation ? animation : "");
+	printf("binary : %s\n", is_binary ? "true" : "false");
 }
 
 void check(){
@@ -399,6 +413,11 @@ void check(){
 		is_failure = true;
 	}
 	
+	if (is_binary && !filename){
+		fprintf(stderr, "Binary output needs an outfile\n");
+		is_failure = true;
+	}
+	
 	if (is_failure){
 		exit(1);
 	}
@@ -502,13 +521,26 @@ int main(int argc, const char *argv[]){
 		((graph_sizr_params_t *)params)->c = propagation_params[5];
 	}
 	
-	FILE *outfile = filename ? fopen(filename, "wt") : stdout;
-	fprintf(outfile, "#num_step num_message num_state...\n");
-	
 	int n = graph_num_vertices(g);
 	short *state = malloc(n * sizeof(*state));
 	
 	int i, j, s;
+	
+	// Binary output has one column per field and is written at the end
+	FILE *outfile = NULL;
+	int num_column = 2 + model.num_state;
+	int **result = NULL;
+	if (is_binary){
+		result = malloc(num_column * sizeof(*result));
+		result[0] = malloc(num_column * r * sizeof(*result[0]));
+		for (j=1; j < num_column; j++){
+			result[j] = result[0] + j*r;
+		}
+	} else {
+		outfile = filename ? fopen(filename, "wt") : stdout;
+		fprintf(outfile, "#num_step num_message num_state...\n");
+	}
+	
 	clock_t tstart, tstop;
 	tstart = clock();
 	for (i=0; i < r; i++){
@@ -534,13 +566,21 @@ int main(int argc, const char *argv[]){
 			num_message += step[s].num_message;
 		}
 		
-		fprintf(outfile, "%d %d ", num_step, num_message);
-		for (j=0; j < model.num_state; j++){
-			short *final_state = step[num_step-1].state;
-			int final_n = step[num_step-1].n;
-			fprintf(outfile, "%d ", graph_count_state(j, final_state, final_n));
+		short *final_state = step[num_step-1].state;
+		int final_n = step[num_step-1].n;
+		if (is_binary){
+			result[0][i] = num_step;
+			result[1][i] = num_message;
+			for (j=0; j < model.num_state; j++){
+				result[2+j][i] = graph_count_state(j, final_state, final_n);
+			}
+		} else {
+			fprintf(outfile, "%d %d ", num_step, num_message);
+			for (j=0; j < model.num_state; j++){
+				fprintf(outfile, "%d ", graph_count_state(j, final_state, final_n));
+			}
+			fprintf(outfile, "\n");
 		}
-		fprintf(outfile, "\n");
 		
 		if (r == 1){
 			int **freq = malloc(num_step * sizeof(*freq));
@@ -559,6 +599,17 @@ int main(int argc, const char *argv[]){
 			}
 			
 			free(freq[0]); free(freq);
+			
+			if (animation){
+				int radius = 5, width = 1;
+				coord_t *p = malloc(n * sizeof(*p));
+				graph_layout_core_shell(g, radius+width, true, p);
+				if (graph_save_propagation(animation, g, p, model.num_state, 
+				                           step, num_step) != ERROR_SUCCESS){
+					fprintf(stderr, "Couldn't write animation %s\n", animation);
+				}
+				free(p);
+			}
 		}
 		
 		delete_propagation_steps(step, num_step);
@@ -567,7 +618,23 @@ int main(int argc, const char *argv[]){
 	//printf("\nTempo de execucao: %ld\n\n", (tstop-tstart)/(CLOCKS_PER_SEC/1000));
  
 	free(params);
-	if (outfile != stdout){
+	if (is_binary){
+		table_column_t *column = malloc(num_column * sizeof(*column));
+		char (*name)[24] = malloc(num_column * sizeof(*name));
+		for (j=0; j < num_column; j++){
+			if (j < 2){ strcpy(name[j], j == 0 ? "num_step" : "num_message"); }
+			else      { snprintf(name[j], 24, "state_%d", j-2); }
+			column[j].name = name[j];
+			column[j].type = TABLE_INT;
+			column[j].data = result[j];
+		}
+		if (table_write(filename, column, num_column, r) != ERROR_SUCCESS){
+			fprintf(stderr, "Couldn't write %s\n", filename);
+		}
+		free(name);
+		free(column);
+		free(result[0]); free(result);
+	} else if (outfile != stdout){
 		fclose(outfile);
 	}
 	
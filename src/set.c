@@ -14,6 +14,17 @@
 	#define SET_UTILIZATION_RATE 0.75
 #endif
 
+// Keys of free slots. Removed keys leave a deleted mark, so that linear probing
+//still finds keys inserted after them.
+#define SET_EMPTY   -1
+#define SET_DELETED -2
+
+// Slot of the hash table, with the position of key in the dense array.
+typedef struct {
+	int key;
+	int pos;
+} set_slot_t;
+
 uint64_t set_primes[] = {
 	2uL, 3uL, 7uL, 13uL, 23uL, 47uL, 97uL, 193uL, 383uL, 769uL, 1531uL, 3067uL, 
 	6143uL, 12289uL, 24571uL, 49157uL, 98299uL, 196613uL, 393209uL, 786433uL, 
@@ -32,44 +43,52 @@ uint64_t set_primes[] = {
 
 const int num_primes = sizeof(set_primes)/sizeof(set_primes[0]);
 
-uint64_t set_primes_sqrt[] = {
-	2, 2, 3, 4, 5, 7, 10, 14, 20, 28, 40, 56, 79, 111, 157, 222, 314, 444, 628, 
-	887, 1255, 1774, 2509, 3548, 5017, 7095, 10034, 14189, 20067, 28378, 40133, 
-	56756, 80265, 113512, 160530, 227024, 321060, 454047, 642120, 908094, 1284239,
-	1816187, 2568477, 3632374, 5136953, 7264748, 10273905, 14529496, 20547810, 
-	29058991, 41095619, 58117982, 82191238, 116235963, 164382475, 232471925, 
-	328764949, 464943849, 657529897, 929887697, 1315059793, 1859775394, 
-	2630119585u, 3719550787u
-};
-
 struct set_t {
 	int size_idx;
 	int n;
+	int num_deleted;
+	
+	set_slot_t *slot; // Hash table from keys to positions in entry
+	set_entry_t *entry; // Dense array of elements, linked in this order
+	int capacity;
 	
-	set_entry_t *entry;
-	set_entry_t *head, *tail;
+	double *value;    // Value of each position, NULL if no value was put
 };
 
 /**** Allocation and deallocation ****/
-set_t *new_set(int minimum){
+
+// Index of the smallest table that holds minimum elements.
+int set_size_index(int minimum){
 	if (minimum < 8){
 		minimum = 8;
 	}
-	set_t *set = malloc(sizeof(*set));
-	if (!set){ return NULL; }
-	
 	int preferred_size = (int) ceil(minimum/SET_UTILIZATION_RATE);
 	int i;
 	for (i=0; i < num_primes-1; i++){
 		if (set_primes[i] >=	preferred_size)
 			break;
 	}
-	set->size_idx = i;
-	int size = set_primes[i];
-	set->entry = malloc(size * sizeof(*set->entry));
-	if (!set->entry){
-		free(set); return NULL;
+	return i;
+}
+
+// Elements that fit in a table before it's rebuilt, plus the one that
+//triggers it.
+int set_capacity(int size_idx){
+	return (int)(set_primes[size_idx] * SET_UTILIZATION_RATE) + 1;
+}
+
+set_t *new_set(int minimum){
+	set_t *set = malloc(sizeof(*set));
+	if (!set){ return NULL; }
+	
+	set->size_idx = set_size_index(minimum);
+	set->capacity = set_capacity(set->size_idx);
+	set->slot = malloc(set_primes[set->size_idx] * sizeof(*set->slot));
+	set->entry = malloc(set->capacity * sizeof(*set->entry));
+	if (!set->slot || !set->entry){
+		free(set->slot); free(set->entry); free(set); return NULL;
 	}
+	set->value = NULL;
 	
 	set_clean(set);
 	
@@ -78,29 +97,59 @@ set_t *new_set(int minimum){
 
 void delete_set(set_t *set){
 	assert(set);
+	free(set->value);
 	free(set->entry);
+	free(set->slot);
 	free(set);
 }
 
-error_t set_realloc(set_t *set){
-	int size = set_primes[set->size_idx];
-	if (set->n > size * SET_UTILIZATION_RATE){
-		int new_size = set_primes[set->size_idx+1];
-		set_t *other = new_set(new_size);
-		if (!other){ return ERROR_NO_MEMORY; }
-		
-		set_entry_t *p;
-		for (p = set->head; p != NULL; p = p->next){
-			set_put(other, p->key);
+int set_locate(const set_t *set, int key);
+
+// Rebuilds the table with the given size, keeping elements in their positions.
+error_t set_rehash(set_t *set, int size_idx){
+	int i, size = set_primes[size_idx], capacity = set_capacity(size_idx);
+	set_slot_t *slot = malloc(size * sizeof(*slot));
+	if (!slot){ return ERROR_NO_MEMORY; }
+	
+	if (capacity > set->capacity){
+		if (set->value){
+			double *value = realloc(set->value, capacity * sizeof(*value));
+			if (!value){ free(slot); return ERROR_NO_MEMORY; }
+			set->value = value;
 		}
+		set_entry_t *entry = realloc(set->entry, capacity * sizeof(*entry));
+		if (!entry){ free(slot); return ERROR_NO_MEMORY; }
+		set->entry = entry;
+		set->capacity = capacity;
 		
-		free(set->entry);
-		set->size_idx = other->size_idx;
-		set->n        = other->n;
-		set->entry    = other->entry;
-		set->head     = other->head;
-		set->tail     = other->tail;
-		free(other);
+		// Entries may have moved, so links are rebuilt
+		for (i=0; i < set->n-1; i++){
+			set->entry[i].next = &set->entry[i+1];
+		}
+	}
+	
+	free(set->slot);
+	set->slot = slot;
+	set->size_idx = size_idx;
+	set->num_deleted = 0;
+	for (i=0; i < size; i++){
+		slot[i].key = SET_EMPTY;
+	}
+	for (i=0; i < set->n; i++){
+		int pos = set_locate(set, set->entry[i].key);
+		slot[pos].key = set->entry[i].key;
+		slot[pos].pos = i;
+	}
+	return ERROR_SUCCESS;
+}
+
+error_t set_realloc(set_t *set){
+	int size = set_primes[set->size_idx];
+	if (set->n + set->num_deleted > size * SET_UTILIZATION_RATE){
+		// Grows the table, or just discards deleted marks if it's not too full
+		int size_idx = set->n > size * SET_UTILIZATION_RATE / 2 ? 
+		               set->size_idx+1 : set_size_index(set->n);
+		return set_rehash(set, size_idx);
 	}
 	return ERROR_SUCCESS;
 }
@@ -114,8 +163,8 @@ int set_hash(int key, int size){
 int set_locate(const set_t *set, int key){
 	int size = set_primes[set->size_idx];
 	int pos = set_hash(key, size);
-	while (set->entry[pos].key != key && 
-	       set->entry[pos].key >= 0){
+	while (set->slot[pos].key != key && 
+	       set->slot[pos].key != SET_EMPTY){
 		pos = (pos + 1) % size;             // Linear probing collision resolution
 	}
 	return pos;
@@ -126,23 +175,50 @@ error_t set_put(set_t *set, int key){
 	assert(key >= 0);
 	
 	int pos = set_locate(set, key);
-	set_entry_t *addr = &set->entry[pos];
+	set_slot_t *addr = &set->slot[pos];
+	if (addr->key >= 0){ return ERROR_SUCCESS; }
+	if (set->n == set->capacity){ return ERROR_NO_MEMORY; } // Growth failed before
+	
+	// Appends the element to the dense array and the linked list
+	int i = set->n++;
+	addr->key = key;
+	addr->pos = i;
+	set->entry[i].key = key;
+	set->entry[i].next = NULL;
+	if (i > 0){ set->entry[i-1].next = &set->entry[i]; }
+	if (set->value){ set->value[i] = 0.0; }
 	
-	if (set->n == 0)
-	{
-		set->head = set->tail = addr;
-		set->n++;
-	}
-	else if (addr->key < 0)
-	{
-		set->tail->next = addr;
-		set->tail = addr;
-		set->n++;
+	return set_realloc(set);
+}
+
+error_t set_put_value(set_t *set, int key, double value){
+	assert(set);
+	assert(key >= 0);
+	
+	if (!set->value){
+		set->value = calloc(set->capacity, sizeof(*set->value));
+		if (!set->value){ return ERROR_NO_MEMORY; }
 	}
 	
-	set->entry[pos].key = key;
+	error_t error = set_put(set, key);
+	if (error){ return error; }
+	set->value[set->slot[set_locate(set, key)].pos] = value;
+	return ERROR_SUCCESS;
+}
+
+double set_value(const set_t *set, int key){
+	assert(set);
+	assert(key >= 0);
 	
-	return set_realloc(set);
+	int pos = set_locate(set, key);
+	if (set->slot[pos].key < 0 || !set->value){ return 0.0; }
+	return set->value[set->slot[pos].pos];
+}
+
+double set_entry_value(const set_t *set, const set_entry_t *entry){
+	assert(set);
+	assert(entry >= set->entry && entry < set->entry + set->n);
+	return set->value ? set->value[entry - set->entry] : 0.0;
 }
 
 bool set_contains(const set_t *set, int key){
@@ -150,34 +226,30 @@ bool set_contains(const set_t *set, int key){
 	assert(key >= 0);
 	int pos = set_locate(set, key);
 	
-	if (set->entry[pos].key < 0){ return false; }
-	else                        { return true; }
+	if (set->slot[pos].key < 0){ return false; }
+	else                       { return true; }
 }
 
 bool set_remove(set_t *set, int key){
 	assert(set);
 	assert(key >= 0);
 	
-	// Constant time checking before walking the linked list
-	if (!set_contains(set, key)){ return false; }
-	
-	if (set->head->key == key){
-		if (set->tail->key == key){ set->tail = NULL; }
-		set->head->key = -1;
-		set->head = set->head->next;
-	}
-	
-	set_entry_t *p;
-	for (p = set->head; p != set->tail; p = p->next){
-		if (p->next->key == key){
-			if (set->tail->key == key){ set->tail = p; }
-			p->next->key = -1;
-			p->next = p->next->next;
-			break;
-		}
+	int pos = set_locate(set, key);
+	set_slot_t *addr = &set->slot[pos];
+	if (addr->key < 0){ return false; }
+	
+	// Moves the last element to the position of the removed one
+	int i = addr->pos, last = --set->n;
+	if (i != last){
+		int moved = set->entry[last].key;
+		set->entry[i].key = moved;
+		if (set->value){ set->value[i] = set->value[last]; }
+		set->slot[set_locate(set, moved)].pos = i;
 	}
+	if (last > 0){ set->entry[last-1].next = NULL; }
 	
-	set->n--;
+	addr->key = SET_DELETED;
+	set->num_deleted++;
 	return true;
 }
 
@@ -186,12 +258,11 @@ void set_clean(set_t *set){
 	
 	uint64_t i, size = set_primes[set->size_idx];
 	for (i=0; i < size; i++){
-		set->entry[i].key = -1;
-		set->entry[i].next = NULL;
+		set->slot[i].key = SET_EMPTY;
 	}
-	set->head = set->tail = NULL;
 	
 	set->n = 0;
+	set->num_deleted = 0;
 }
 
 /**** Set operations ****/
@@ -199,9 +270,9 @@ error_t set_union(set_t *dest, const set_t *other){
 	assert(dest);
 	assert(other);
 	
-	set_entry_t *p;
-	for (p=other->head; p != NULL; p = p->next){
-		error_t error = set_put(dest, p->key);
+	int i;
+	for (i=0; i < other->n; i++){
+		error_t error = set_put(dest, other->entry[i].key);
 		if (error){ return error; }
 	}
 	return ERROR_SUCCESS;
@@ -211,9 +282,9 @@ void set_difference(set_t *dest, const set_t *other){
 	assert(dest);
 	assert(other);
 	
-	set_entry_t *p;
-	for (p=other->head; p != NULL; p = p->next){
-		set_remove(dest, p->key);
+	int i;
+	for (i=0; i < other->n; i++){
+		set_remove(dest, other->entry[i].key);
 	}
 }
 
@@ -221,34 +292,13 @@ void set_intersection(set_t *dest, const set_t *other){
 	assert(dest);
 	assert(other);
 	
-	// Iterates over all elements in dest, except the head, checking if they
-	//are present in other
-	set_entry_t *p;
-	for (p=dest->head; p->next != NULL;){
-		if (!set_contains(other, p->next->key))
-		{
-			set_entry_t *q = p->next;
-			p->next = q->next;
-			q->key = -1;
-			q->next = NULL;
-			dest->n--;
-		}
-		else
-		{
-			p = p->next;
-		}
-	}
-	dest->tail = p;
-	
-	// Treat the head case
-	if (!set_contains(other, dest->head->key)){
-		set_entry_t *p = dest->head;
-		dest->head = p->next;
-		p->key = -1;
-		p->next = NULL;
-		dest->n--;
-		if (dest->n == 0){
-			dest->tail = NULL;
+	// Iterates backwards, so that elements moved by set_remove were already
+	//checked
+	int i;
+	for (i=dest->n-1; i >= 0; i--){
+		int key = dest->entry[i].key;
+		if (!set_contains(other, key)){
+			set_remove(dest, key);
 		}
 	}
 }
@@ -258,14 +308,7 @@ void set_intersection(set_t *dest, const set_t *other){
 int set_get(const set_t *set, int pos){
 	assert(set);
 	assert(pos >= 0 && pos < set->n);
-	
-	int i;
-	set_entry_t *p = set->head;
-	for (i=0; i < pos; i++){
-		p = p->next;
-	}
-	
-	return p->key;
+	return set->entry[pos].key;
 }
 
 int set_size(const set_t *set){
@@ -282,37 +325,15 @@ int set_index(const set_t *set, int key){
 	assert(set);
 	assert(key >= 0);
 	
-	if (!set_contains(set, key)){ return -1; }
-	
-	int i;
-	set_entry_t *p = set->head;
-	for (i=0; i < set->n; i++){
-		if (p->key == key) { break; }
-		p = p->next;
-	}
-	
-	return i;
+	int pos = set_locate(set, key);
+	if (set->slot[pos].key < 0){ return -1; }
+	return set->slot[pos].pos;
 }
 
 set_entry_t *set_head(const set_t *set){
-	return set->head;
+	return set->n > 0 ? set->entry : NULL;
 }
 
-// Let N be the number of elements in the table, and P the size of the table.
-//The utilization rate r is given as r = N/P.
-//
-// The probability to choose a non-empty slot uniformly at the first try is r; 
-//in the second try is r*(1-r); in the third try is r*(1-r)^2 and so on.
-// The expected number of tries k is 1*r + 2*r*(1-r) + 3*r*(1-r)^2 + ...
-// k = r * sum_{n=1}^\infty {n*(1-r)^(n-1)} = r * (1/r^2) = 1/r
-// k = P/N
-//
-// We can also pick a random number by selecting a number between 0 and N-1 and
-//walking the linked list. The expected number of steps s is N/2. 
-// Let a be the time per random try, and b be the time of a step. We should
-//use random picking if
-// a * P/N < b * N/2 => (2a/b) * P < N^2 => N > sqrt(2a/b * P)
-// For practical reasons we use a/b = 8, so we have N > 4*sqrt(P)
 int set_get_random(const set_t *set){
 	return set_get_random_r(set, NULL);
 }
@@ -320,45 +341,15 @@ int set_get_random(const set_t *set){
 int set_get_random_r(const set_t *set, unsigned int *seedp){
 	assert(set);
 	if (set->n == 0){ return -1; }
-	
-	// Random picking
-	if (set->n > 4*set_primes_sqrt[set->size_idx])
-	{
-		int size = set_primes[set->size_idx];
-		int pos;
-		do {
-			pos = uniform(size, seedp);
-		} while (set->entry[pos].key < 0);
-		
-		return set->entry[pos].key;
-	}
-	
-	// List traversal
-	return set_get(set, uniform(set->n, seedp));
+	return set->entry[uniform(set->n, seedp)].key;
 }
 
 /**** Optimize linked list ****/
 
-// Organize links to point to next element in succession at the entry table,
-//hopefully improving memory locality
+// Entries are already stored and linked in sequence in a dense array, so there
+//is nothing to reorganize.
 void set_optimize(set_t *set){
 	assert(set);
-	if (set->n < 2){ return; }
-	
-	set_entry_t *curr = set->entry, *prev = NULL;
-	while(curr->key < 0){ curr++; }
-	set->head = prev = curr;
-	curr++;
-	
-	int i;
-	for (i=1; i < set->n; i++){
-		while(curr->key < 0){ curr++; }
-		prev->next = curr;
-		prev = curr;
-		curr++;
-	}
-	prev->next = NULL;
-	set->tail = prev;
 }
 
 /**** Printing ****/
@@ -371,11 +362,9 @@ void set_fprint(FILE *stream, const set_t *set){
 	assert(set);
 	
 	int i, n = set->n;
-	set_entry_t *p = set->head;
 	fprintf(stream, "{");
 	for (i=0; i < n; i++){
-		fprintf(stream, "%d", p->key);
-		p = p->next;
+		fprintf(stream, "%d", set->entry[i].key);
 		if (i < n-1){ fprintf(stream, ", "); }
 	}
 	fprintf(stream, "}");
@@ -388,9 +377,12 @@ set_t *set_copy(const set_t *set){
 	set_t *copy = new_set(set->n);
 	if (!copy){ return NULL; }
 	
-	set_entry_t *p;
-	for (p=set->head; p != NULL; p = p->next){
-		set_put(copy, p->key);
+	int i;
+	for (i=0; i < set->n; i++){
+		error_t error = set->value ? 
+			set_put_value(copy, set->entry[i].key, set->value[i]) :
+			set_put(copy, set->entry[i].key);
+		if (error){ delete_set(copy); return NULL; }
 	}
 	
 	return copy;
@@ -400,10 +392,8 @@ void set_to_array(const set_t *set, int *arr){
 	assert(set);
 	assert(arr);
 	int i;
-	set_entry_t *p = set->head;
 	for (i=0; i < set->n; i++){
-		arr[i] = p->key;
-		p = p->next;
+		arr[i] = set->entry[i].key;
 	}
 }
 
@@ -1,5 +1,11 @@
 
+#include <assert.h>
 #include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "error.h"
 #include "sorting.h"
 
 void * linsearch(
@@ -76,3 +82,205 @@ int comp_double_desc(const void *p_d1, const void *p_d2){
 	if (d1 < d2){ return +1; }
 	return 0;
 }
+
+/******************************* Radix sorts **********************************/
+
+#define RADIX_BITS 8
+#define RADIX_SIZE (1 << RADIX_BITS)
+
+typedef struct {
+	const void *key;          // 32 or 64-bit keys, as given by key_size
+	const double *value;
+	void *key_out;
+	double *value_out;
+	int key_size;
+	size_t first, last;
+	int shift;
+	bool is_running;
+	size_t count[RADIX_SIZE]; // Histogram, then each digit's first position
+} radix_task_params_t;
+
+void *radix_count_task(void *args){
+	radix_task_params_t *params = args;
+	int shift = params->shift;
+	
+	memset(params->count, 0, sizeof(params->count));
+	size_t i;
+	if (params->key_size == sizeof(uint32_t)){
+		const uint32_t *key = params->key;
+		for (i=params->first; i < params->last; i++){
+			params->count[(key[i] >> shift) & (RADIX_SIZE-1)]++;
+		}
+	} else {
+		const uint64_t *key = params->key;
+		for (i=params->first; i < params->last; i++){
+			params->count[(key[i] >> shift) & (RADIX_SIZE-1)]++;
+		}
+	}
+	return params;
+}
+
+void *radix_move_task(void *args){
+	radix_task_params_t *params = args;
+	const double *value = params->value;
+	int shift = params->shift;
+	
+	size_t i;
+	if (params->key_size == sizeof(uint32_t)){
+		const uint32_t *key = params->key;
+		uint32_t *key_out = params->key_out;
+		for (i=params->first; i < params->last; i++){
+			size_t pos = params->count[(key[i] >> shift) & (RADIX_SIZE-1)]++;
+			key_out[pos] = key[i];
+			if (value){ params->value_out[pos] = value[i]; }
+		}
+	} else {
+		const uint64_t *key = params->key;
+		uint64_t *key_out = params->key_out;
+		for (i=params->first; i < params->last; i++){
+			size_t pos = params->count[(key[i] >> shift) & (RADIX_SIZE-1)]++;
+			key_out[pos] = key[i];
+			if (value){ params->value_out[pos] = value[i]; }
+		}
+	}
+	return params;
+}
+
+// Runs task over all params, where the caller is thread 0 and ranges of 
+//threads that fail to start are run by it.
+void radix_launch
+		(void *(*task)(void *), radix_task_params_t *params, pthread_t *thread,
+		 int num_processors){
+	int i;
+	params[0].is_running = false;
+	for (i=1; i < num_processors; i++){
+		params[i].is_running = 
+			pthread_create(&thread[i], NULL, task, &params[i]) == 0;
+	}
+	for (i=0; i < num_processors; i++){
+		if (!params[i].is_running){ task(&params[i]); }
+	}
+	for (i=1; i < num_processors; i++){
+		if (params[i].is_running){ pthread_join(thread[i], NULL); }
+	}
+}
+
+/* Sorts n keys of key_size bytes, 4 or 8, so that 32-bit keys take half the
+ * passes and memory of 64-bit ones. */
+error_t radix_sort_words
+		(void *key, int key_size, double *value, size_t n, int num_processors){
+	assert(key || n == 0);
+	assert(key_size == sizeof(uint32_t) || key_size == sizeof(uint64_t));
+	if (n < 2){ return ERROR_SUCCESS; }
+	if (num_processors > n/SORTING_MIN_TASK){ 
+		num_processors = n/SORTING_MIN_TASK;
+	}
+	if (num_processors < 1){ num_processors = 1; }
+	
+	void *key_buffer = malloc(n * key_size);
+	double *value_buffer = value ? malloc(n * sizeof(*value_buffer)) : NULL;
+	radix_task_params_t *params = malloc(num_processors * sizeof(*params));
+	pthread_t *thread = malloc(num_processors * sizeof(*thread));
+	if (!key_buffer || (value && !value_buffer) || !params || !thread){
+		free(key_buffer); free(value_buffer); free(params); free(thread);
+		return ERROR_NO_MEMORY;
+	}
+	
+	int i, d, shift;
+	for (i=0; i < num_processors; i++){
+		params[i].first = (size_t)i * n / num_processors;
+		params[i].last  = (size_t)(i+1) * n / num_processors;
+	}
+	
+	void *key_in = key, *key_out = key_buffer;
+	double *value_in = value, *value_out = value_buffer;
+	for (shift=0; shift < 8*key_size; shift += RADIX_BITS){
+		for (i=0; i < num_processors; i++){
+			params[i].key = key_in;
+			params[i].value = value_in;
+			params[i].key_out = key_out;
+			params[i].value_out = value_out;
+			params[i].key_size = key_size;
+			params[i].shift = shift;
+		}
+		radix_launch(radix_count_task, params, thread, num_processors);
+		
+		// Bytes shared by all keys don't change the order
+		size_t total = 0;
+		bool is_trivial = false;
+		for (d=0; d < RADIX_SIZE; d++){
+			size_t count_d = 0;
+			for (i=0; i < num_processors; i++){
+				count_d += params[i].count[d];
+			}
+			if (count_d == n){ is_trivial = true; break; }
+			
+			// Thread i moves its keys with digit d after those of threads < i
+			for (i=0; i < num_processors; i++){
+				size_t count = params[i].count[d];
+				params[i].count[d] = total;
+				total += count;
+			}
+		}
+		if (is_trivial){ continue; }
+		
+		radix_launch(radix_move_task, params, thread, num_processors);
+		void *key_tmp = key_in; key_in = key_out; key_out = key_tmp;
+		double *value_tmp = value_in; value_in = value_out; value_out = value_tmp;
+	}
+	
+	if (key_in != key){
+		memcpy(key, key_in, n * key_size);
+		if (value){ memcpy(value, value_in, n * sizeof(*value)); }
+	}
+	
+	free(key_buffer);
+	free(value_buffer);
+	free(params);
+	free(thread);
+	return ERROR_SUCCESS;
+}
+
+error_t radix_sort_keys
+		(uint64_t *key, double *value, size_t n, int num_processors){
+	return radix_sort_words(key, sizeof(*key), value, n, num_processors);
+}
+
+// Maps ints to unsigned ints keeping their order.
+#define RADIX_INT_KEY(x) ((uint32_t)(x) ^ 0x80000000u)
+
+error_t radix_sort_int(int *v, size_t n, int num_processors){
+	assert(v || n == 0);
+	
+	// Ints are sorted in place as unsigned keys with the sign bit flipped
+	uint32_t *key = (uint32_t *)v;
+	size_t i;
+	for (i=0; i < n; i++){
+		key[i] = RADIX_INT_KEY(v[i]);
+	}
+	error_t error = radix_sort_words(key, sizeof(*key), NULL, n, num_processors);
+	for (i=0; i < n; i++){
+		v[i] = (int)(key[i] ^ 0x80000000u);
+	}
+	return error;
+}
+
+error_t radix_sort_pairs(int *v, size_t n, int num_processors){
+	assert(v || n == 0);
+	uint64_t *key = malloc(n * sizeof(*key));
+	if (!key && n > 0){ return ERROR_NO_MEMORY; }
+	
+	size_t i;
+	for (i=0; i < n; i++){
+		key[i] = ((uint64_t)RADIX_INT_KEY(v[2*i]) << 32) | RADIX_INT_KEY(v[2*i+1]);
+	}
+	error_t error = radix_sort_keys(key, NULL, n, num_processors);
+	if (!error){
+		for (i=0; i < n; i++){
+			v[2*i]   = (int)(uint32_t)((key[i] >> 32) ^ 0x80000000u);
+			v[2*i+1] = (int)(uint32_t)(key[i] ^ 0x80000000u);
+		}
+	}
+	free(key);
+	return error;
+}
@@ -66,7 +66,7 @@ double stat_int_sum(const int *v, int n){
 	return s;
 }
 
-double stat_int_dist_sum(const int *v, int n){
+double stat_int_dist_sum(const int64_t *v, int n){
 	assert(v);
 	assert(n > 0);
 	
@@ -78,7 +78,7 @@ double stat_int_dist_sum(const int *v, int n){
 	return s;
 }
 
-double stat_int_dist_harmonic_sum(const int *v, int n){
+double stat_int_dist_harmonic_sum(const int64_t *v, int n){
 	assert(v);
 	assert(n > 0);
 	
@@ -106,9 +106,9 @@ double stat_int_variance(const int *v, int n){
 	double m = stat_int_average(v, n);
 	int i;
 	for (i=0; i < n; i++){
-		s += (v[i] - m)*(v[i] - m)/(n - 1);
+		s += (v[i] - m)*(v[i] - m);
 	}
-	return s;
+	return s / (n - 1);
 }
 
 double stat_int_entropy(const int *v, int n){
@@ -128,51 +128,135 @@ double stat_int_entropy(const int *v, int n){
 	return l;
 }
 
-double stat_int_dist_average(const int *v, int n){
+double stat_int_dist_average(const int64_t *v, int n){
 	assert(v);
 	assert(n > 0);
 	
 	double s = stat_int_dist_sum(v, n);
-	double total = stat_int_sum(v, n);
+	double total = 0.0;
+	int i;
+	for (i=0; i < n; i++){
+		total += v[i];
+	}
 	
 	return (s / total);
 }
 
+/****************************** Block kernels *********************************/
+/* Kernels keep four independent partial sums, so that compilers can use 
+ * vector registers without reassociating floating-point additions. */
+
+double stat_block_sum(const double *v, int n){
+	double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+	int i;
+	for (i=0; i+4 <= n; i+=4){
+		s0 += v[i]; s1 += v[i+1]; s2 += v[i+2]; s3 += v[i+3];
+	}
+	for (; i < n; i++){
+		s0 += v[i];
+	}
+	return (s0 + s1) + (s2 + s3);
+}
+
+// Sum of products of deviations (x[i] - mx)*(y[i] - my)
+double stat_block_comoment(const double *x, double mx, const double *y, double my, int n){
+	double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+	int i;
+	for (i=0; i+4 <= n; i+=4){
+		s0 += (x[i]   - mx) * (y[i]   - my);
+		s1 += (x[i+1] - mx) * (y[i+1] - my);
+		s2 += (x[i+2] - mx) * (y[i+2] - my);
+		s3 += (x[i+3] - mx) * (y[i+3] - my);
+	}
+	for (; i < n; i++){
+		s0 += (x[i] - mx) * (y[i] - my);
+	}
+	return (s0 + s1) + (s2 + s3);
+}
+
 double stat_double_sum(const double *v, int n){
 	assert(v);
 	assert(n > 0);
-	
-	double s = 0.0;
-	int i;
-	for (i=0; i < n; i++){
-		s += v[i];
-	}
-	return s;
+	return stat_block_sum(v, n);
 }
 
 double stat_double_average(const double *v, int n){
 	assert(v);
 	assert(n > 0);
-	
-	double s = 0.0;
-	int i;
-	for (i=0; i < n; i++){
-		s += v[i]/n;
-	}
-	return s;
+	return stat_block_sum(v, n) / n;
 }
 
 double stat_double_variance(const double *v, int n){
 	assert(v);
 	assert(n > 0);
 	
-	double m = stat_double_average(v, n);
-	double s = 0.0;
-	int i;
-	for (i=0; i < n; i++){
-		s += (v[i] - m)*(v[i] - m)/(n - 1);
+	stat_stream_t s;
+	stat_stream_init(&s);
+	stat_stream_push_array(&s, v, n);
+	return stat_stream_variance(&s);
+}
+
+/********************************* Streams ************************************/
+
+void stat_stream_init(stat_stream_t *s){
+	assert(s);
+	s->n = 0.0;
+	s->mean = 0.0;
+	s->m2 = 0.0;
+	s->min = +1.0/0.0;
+	s->max = -1.0/0.0;
+}
+
+void stat_stream_push(stat_stream_t *s, double x){
+	assert(s);
+	s->n += 1.0;
+	double delta = x - s->mean;
+	s->mean += delta / s->n;
+	s->m2 += delta * (x - s->mean);
+	if (x < s->min){ s->min = x; }
+	if (x > s->max){ s->max = x; }
+}
+
+void stat_stream_merge(stat_stream_t *s, const stat_stream_t *other){
+	assert(s);
+	assert(other);
+	if (other->n == 0.0){ return; }
+	
+	double n = s->n + other->n;
+	double delta = other->mean - s->mean;
+	s->mean += delta * (other->n / n);
+	s->m2 += other->m2 + delta * delta * (s->n * other->n / n);
+	s->n = n;
+	if (other->min < s->min){ s->min = other->min; }
+	if (other->max > s->max){ s->max = other->max; }
+}
+
+void stat_stream_push_array(stat_stream_t *s, const double *v, int n){
+	assert(s);
+	assert(v);
+	
+	int i, j;
+	for (i=0; i < n; i += STAT_BLOCK_SIZE){
+		int size = n - i < STAT_BLOCK_SIZE ? n - i : STAT_BLOCK_SIZE;
+		const double *block = v + i;
+		
+		stat_stream_t b;
+		b.n = size;
+		b.mean = stat_block_sum(block, size) / size;
+		b.m2 = stat_block_comoment(block, b.mean, block, b.mean, size);
+		b.min = b.max = block[0];
+		for (j=1; j < size; j++){
+			if (block[j] < b.min){ b.min = block[j]; }
+			if (block[j] > b.max){ b.max = block[j]; }
+		}
+		stat_stream_merge(s, &b);
 	}
-	return s;
+}
+
+double stat_stream_variance(const stat_stream_t *s){
+	assert(s);
+	assert(s->n > 1.0);
+	return s->m2 / (s->n - 1.0);
 }
 
 void stat_double_normalization(double *v, int n){
@@ -203,77 +287,145 @@ int *stat_sort_copy(const int *v, int n){
 	return copy;
 }
 
+// Counts values in [min, max] directly in an array.
+pair_t *stat_counting_frequencies(const int *v, int n, int min, int max, int *_num_keys){
+	int *count = calloc((size_t)max - min + 1, sizeof(*count));
+	if (!count){ return NULL; }
+	
+	int i, num_keys = 0;
+	for (i=0; i < n; i++){
+		if (count[ v[i] - min ]++ == 0){ num_keys++; }
+	}
+	
+	pair_t *freq = malloc(num_keys * sizeof(*freq));
+	if (!freq){ free(count); return NULL; }
+	
+	int k = 0;
+	for (i=0; k < num_keys; i++){
+		if (count[i] > 0){
+			freq[k].key   = min + i;
+			freq[k].value = count[i];
+			k++;
+		}
+	}
+	free(count);
+	
+	if (_num_keys){ *_num_keys = num_keys; }
+	return freq;
+}
+
 pair_t *stat_frequencies(const int *v, int n, int *_num_keys){
 	assert(v);
 	assert(n > 0);
 	
+	int i, min = v[0], max = v[0];
+	for (i=1; i < n; i++){
+		if (v[i] < min){ min = v[i]; }
+		if (v[i] > max){ max = v[i]; }
+	}
+	if ((double)max - min < (double)STAT_COUNTING_RANGE * n){
+		return stat_counting_frequencies(v, n, min, max, _num_keys);
+	}
+	
 	int *copy = stat_sort_copy(v, n);
+	if (!copy){ return NULL; }
+	
+	int num_keys = 1;
+	for (i=1; i < n; i++){
+		if (copy[i] != copy[i-1]){ num_keys++; }
+	}
 	
-	int i, count = 1, num_keys = 1;
 	pair_t *freq = malloc(num_keys * sizeof(*freq));
+	if (!freq){ free(copy); return NULL; }
 	
+	int k = 0;
+	freq[0].key   = copy[0];
+	freq[0].value = 1;
 	for (i=1; i < n; i++){
 		if (copy[i] == copy[i-1])
 		{
-			count++;
+			freq[k].value++;
 		}
 		else
 		{
-			freq[num_keys-1].key   = copy[i-1];
-			freq[num_keys-1].value = count;
-			
-			count = 1;
-			num_keys++;
-			
-			pair_t *new_freq = realloc(freq, num_keys * sizeof(*freq));
-			if (!new_freq){ free(freq); free(copy); return NULL; }
-			freq = new_freq;
+			k++;
+			freq[k].key   = copy[i];
+			freq[k].value = 1;
 		}
 	}
-	freq[num_keys-1].key   = copy[n-1];
-	freq[num_keys-1].value = count;
-			
 	free(copy);
 	
 	if (_num_keys){ *_num_keys = num_keys; }
 	return freq;
 }
 
-interval_t *stat_histogram(const double *_v, int n, int num_bins){
-	assert(_v);
+interval_t *stat_histogram(const double *v, int n, int num_bins){
+	assert(v);
 	assert(n > 1);
 	assert(num_bins > 0);
 	
-	double *v = malloc(n * sizeof(*v));
-	if (!v){ return NULL; }
-	memcpy(v, _v, n * sizeof(*v));
-	qsort(v, n, sizeof(*v), comp_double_asc);
-	
-	double max = v[n-1], min = v[0];
-	double range = max - min;
-	double delta = range/num_bins;
+	int i;
+	double min = v[0], max = v[0];
+	for (i=1; i < n; i++){
+		if (v[i] < min){ min = v[i]; }
+		if (v[i] > max){ max = v[i]; }
+	}
+	double delta = (max - min)/num_bins;
 	
-	interval_t *interval = malloc ((num_bins+1) * sizeof(*interval));
-	if (!interval){ free(v); return NULL; }
+	interval_t *interval = malloc (num_bins * sizeof(*interval));
+	if (!interval){ return NULL; }
 	
-	int i, pos = 0;
 	for (i=0; i < num_bins; i++){
 		interval[i].min = min + i*delta;
 		interval[i].max = min + (i+1)*delta;
 		interval[i].value = 0;
-		
-		while (pos < n && v[pos] < interval[i].max)
-		{
-			interval[i].value++;
-			pos++;
-		}
 	}
+	interval[num_bins-1].max = max;
+	
+	double scale = max > min ? num_bins/(max - min) : 0.0;
+	for (i=0; i < n; i++){
+		int bin = (int) ((v[i] - min) * scale);
+		if (bin >= num_bins){ bin = num_bins-1; }
+		interval[bin].value++;
+	}
+	
+	return interval;
+}
+
+interval_t *stat_log_histogram(const double *v, int n, int num_bins){
+	assert(v);
+	assert(n > 0);
+	assert(num_bins > 0);
+	
+	int i;
+	double min = +1.0/0.0, max = 0.0;
+	for (i=0; i < n; i++){
+		if (v[i] > 0.0 && v[i] < min){ min = v[i]; }
+		if (v[i] > max){ max = v[i]; }
+	}
+	if (max <= 0.0){ return NULL; }
+	
+	interval_t *interval = malloc (num_bins * sizeof(*interval));
+	if (!interval){ return NULL; }
+	
+	double log_min = log(min), delta = (log(max) - log_min)/num_bins;
+	for (i=0; i < num_bins; i++){
+		interval[i].min = exp(log_min + i*delta);
+		interval[i].max = exp(log_min + (i+1)*delta);
+		interval[i].value = 0;
+	}
+	interval[0].min = min;
+	interval[num_bins-1].max = max;
 	
-	interval[num_bins].min = max;
-	interval[num_bins].max = +1.0/0.0;
-	interval[num_bins].value = n - pos;
+	double scale = delta > 0.0 ? 1.0/delta : 0.0;
+	for (i=0; i < n; i++){
+		if (v[i] > 0.0){
+			int bin = (int) ((log(v[i]) - log_min) * scale);
+			if (bin >= num_bins){ bin = num_bins-1; }
+			interval[bin].value++;
+		}
+	}
 	
-	free(v);
 	return interval;
 }
 
@@ -282,18 +434,404 @@ double stat_pearson(const double *x, const double *y, int n){
 	assert(y);
 	assert(n > 0);
 	
-	double x_mean = stat_double_average(x, n);
-	double x_stddev = sqrt(stat_double_variance(x, n));
+	const double *v[2] = {x, y};
+	double r[4];
+	if (stat_correlation_matrix(v, 2, n, r) != ERROR_SUCCESS){ return 0.0/0.0; }
+	return r[1];
+}
+
+error_t stat_correlation_matrix
+		(const double * const *v, int num_var, int n, double *r){
+	assert(v);
+	assert(num_var > 0);
+	assert(n > 0);
+	assert(r);
+	
+	// Running means and co-moments, and the same for the current block
+	double *mean = malloc(2 * num_var * sizeof(*mean));
+	double *c = malloc(2 * num_var * num_var * sizeof(*c));
+	if (!mean || !c){ free(mean); free(c); return ERROR_NO_MEMORY; }
+	double *block_mean = mean + num_var;
+	double *block_c = c + num_var * num_var;
+	
+	memset(mean, 0, num_var * sizeof(*mean));
+	memset(c, 0, num_var * num_var * sizeof(*c));
+	
+	// Each block of values of all variables is read once from memory, and 
+	//its co-moments are merged as in stat_stream_merge.
+	int i, j, k;
+	double count = 0.0;
+	for (k=0; k < n; k += STAT_BLOCK_SIZE){
+		int size = n - k < STAT_BLOCK_SIZE ? n - k : STAT_BLOCK_SIZE;
+		for (i=0; i < num_var; i++){
+			block_mean[i] = stat_block_sum(v[i] + k, size) / size;
+		}
+		for (i=0; i < num_var; i++){
+			for (j=i; j < num_var; j++){
+				block_c[i*num_var + j] = stat_block_comoment
+					(v[i] + k, block_mean[i], v[j] + k, block_mean[j], size);
+			}
+		}
+		
+		double total = count + size;
+		double weight = count * size / total;
+		for (i=0; i < num_var; i++){
+			for (j=i; j < num_var; j++){
+				c[i*num_var + j] += block_c[i*num_var + j] + weight * 
+					(block_mean[i] - mean[i]) * (block_mean[j] - mean[j]);
+			}
+		}
+		for (i=0; i < num_var; i++){
+			mean[i] += (block_mean[i] - mean[i]) * (size / total);
+		}
+		count = total;
+	}
+	
+	for (i=0; i < num_var; i++){
+		for (j=i; j < num_var; j++){
+			double cij = c[i*num_var + j];
+			double cii = c[i*num_var + i], cjj = c[j*num_var + j];
+			r[i*num_var + j] = r[j*num_var + i] = cij / sqrt(cii * cjj);
+		}
+	}
 	
-	double y_mean = stat_double_average(y, n);
-	double y_stddev = sqrt(stat_double_variance(y, n));
+	free(mean);
+	free(c);
+	return ERROR_SUCCESS;
+}
+
+/******************************** KLL sketch **********************************/
+
+stat_kll_t *new_stat_kll(int k, unsigned int seed){
+	assert(k >= 2);
+	
+	stat_kll_t *s = malloc(sizeof(*s));
+	if (!s){ return NULL; }
+	
+	s->k = k;
+	s->num_levels = 0;
+	s->level = NULL;
+	s->size = NULL;
+	s->capacity = NULL;
+	s->n = 0.0;
+	s->min = +1.0/0.0;
+	s->max = -1.0/0.0;
+	s->seed = seed;
+	return s;
+}
+
+void delete_stat_kll(stat_kll_t *s){
+	if (!s){ return; }
+	int h;
+	for (h=0; h < s->num_levels; h++){
+		free(s->level[h]);
+	}
+	free(s->level);
+	free(s->size);
+	free(s->capacity);
+	free(s);
+}
+
+// Maximum number of items in level h, that decreases geometrically from the
+//top level.
+int stat_kll_level_capacity(const stat_kll_t *s, int h){
+	int cap = (int) ceil(s->k * pow(2.0/3.0, s->num_levels - 1 - h));
+	return cap > 2 ? cap : 2;
+}
+
+error_t stat_kll_add_level(stat_kll_t *s){
+	int num_levels = s->num_levels + 1;
+	double **level = realloc(s->level, num_levels * sizeof(*level));
+	if (!level){ return ERROR_NO_MEMORY; }
+	s->level = level;
+	int *size = realloc(s->size, num_levels * sizeof(*size));
+	if (!size){ return ERROR_NO_MEMORY; }
+	s->size = size;
+	int *capacity = realloc(s->capacity, num_levels * sizeof(*capacity));
+	if (!capacity){ return ERROR_NO_MEMORY; }
+	s->capacity = capacity;
+	
+	s->level[s->num_levels] = NULL;
+	s->size[s->num_levels] = 0;
+	s->capacity[s->num_levels] = 0;
+	s->num_levels = num_levels;
+	return ERROR_SUCCESS;
+}
+
+// Ensures level h has space for extra items
+error_t stat_kll_reserve(stat_kll_t *s, int h, int extra){
+	if (s->size[h] + extra <= s->capacity[h]){ return ERROR_SUCCESS; }
+	
+	int capacity = s->capacity[h] > 0 ? s->capacity[h] : s->k;
+	while (capacity < s->size[h] + extra){ capacity *= 2; }
+	double *level = realloc(s->level[h], capacity * sizeof(*level));
+	if (!level){ return ERROR_NO_MEMORY; }
+	s->level[h] = level;
+	s->capacity[h] = capacity;
+	return ERROR_SUCCESS;
+}
+
+// Compacts full levels, from the bottom up.
+error_t stat_kll_compress(stat_kll_t *s){
+	int h, i;
+	for (h=0; h < s->num_levels; h++){
+		if (s->size[h] < stat_kll_level_capacity(s, h)){ continue; }
+		
+		if (h+1 == s->num_levels && stat_kll_add_level(s) != ERROR_SUCCESS){
+			return ERROR_NO_MEMORY;
+		}
+		int size = s->size[h];
+		int num_pairs = size/2;
+		if (stat_kll_reserve(s, h+1, num_pairs) != ERROR_SUCCESS){
+			return ERROR_NO_MEMORY;
+		}
+		
+		double *level = s->level[h];
+		qsort(level, size, sizeof(*level), comp_double_asc);
+		
+		// Each promoted item stands for itself and its neighbor
+		int offset = my_rand_r(&s->seed) & 1;
+		double *next = s->level[h+1] + s->size[h+1];
+		for (i=0; i < num_pairs; i++){
+			next[i] = level[2*i + offset];
+		}
+		s->size[h+1] += num_pairs;
+		
+		// An odd item is kept
+		if (size % 2 == 1){
+			level[0] = level[size-1];
+			s->size[h] = 1;
+		} else {
+			s->size[h] = 0;
+		}
+	}
+	return ERROR_SUCCESS;
+}
+
+error_t stat_kll_push(stat_kll_t *s, double x){
+	assert(s);
+	if (s->num_levels == 0 && stat_kll_add_level(s) != ERROR_SUCCESS){
+		return ERROR_NO_MEMORY;
+	}
+	if (stat_kll_reserve(s, 0, 1) != ERROR_SUCCESS){ return ERROR_NO_MEMORY; }
+	
+	s->level[0][ s->size[0]++ ] = x;
+	s->n += 1.0;
+	if (x < s->min){ s->min = x; }
+	if (x > s->max){ s->max = x; }
 	
-	double r = 0.0;
+	if (s->size[0] >= stat_kll_level_capacity(s, 0)){
+		return stat_kll_compress(s);
+	}
+	return ERROR_SUCCESS;
+}
+
+error_t stat_kll_push_array(stat_kll_t *s, const double *v, int n){
+	assert(s);
+	assert(v);
 	int i;
 	for (i=0; i < n; i++){
-		double x_score = (x[i] - x_mean)/x_stddev;
-		double y_score = (y[i] - y_mean)/y_stddev;
-		r +=  x_score * y_score / (n-1);
+		error_t error = stat_kll_push(s, v[i]);
+		if (error != ERROR_SUCCESS){ return error; }
+	}
+	return ERROR_SUCCESS;
+}
+
+error_t stat_kll_merge(stat_kll_t *s, const stat_kll_t *other){
+	assert(s);
+	assert(other);
+	assert(s->k == other->k);
+	
+	int h;
+	for (h=0; h < other->num_levels; h++){
+		if (h == s->num_levels && stat_kll_add_level(s) != ERROR_SUCCESS){
+			return ERROR_NO_MEMORY;
+		}
+		if (stat_kll_reserve(s, h, other->size[h]) != ERROR_SUCCESS){
+			return ERROR_NO_MEMORY;
+		}
+		memcpy(s->level[h] + s->size[h], other->level[h], 
+		       other->size[h] * sizeof(*s->level[h]));
+		s->size[h] += other->size[h];
+	}
+	s->n += other->n;
+	if (other->min < s->min){ s->min = other->min; }
+	if (other->max > s->max){ s->max = other->max; }
+	
+	return stat_kll_compress(s);
+}
+
+typedef struct {
+	double x, weight;
+} stat_weighted_t;
+
+int comp_weighted_asc(const void *p1, const void *p2){
+	const stat_weighted_t *w1 = p1, *w2 = p2;
+	if (w1->x < w2->x){ return -1; }
+	if (w1->x > w2->x){ return +1; }
+	return 0;
+}
+
+double stat_kll_quantile(const stat_kll_t *s, double q){
+	assert(s);
+	assert(q >= 0.0 && q <= 1.0);
+	
+	if (s->n == 0.0){ return 0.0/0.0; }
+	if (q == 0.0){ return s->min; }
+	if (q == 1.0){ return s->max; }
+	
+	int h, i, num_items = 0;
+	for (h=0; h < s->num_levels; h++){
+		num_items += s->size[h];
+	}
+	stat_weighted_t *item = malloc(num_items * sizeof(*item));
+	if (!item){ return 0.0/0.0; }
+	
+	int pos = 0;
+	for (h=0; h < s->num_levels; h++){
+		for (i=0; i < s->size[h]; i++){
+			item[pos].x = s->level[h][i];
+			item[pos].weight = ldexp(1.0, h);
+			pos++;
+		}
+	}
+	qsort(item, num_items, sizeof(*item), comp_weighted_asc);
+	
+	double target = q * s->n, cumulative = 0.0, x = s->max;
+	for (i=0; i < num_items; i++){
+		cumulative += item[i].weight;
+		if (cumulative >= target){
+			x = item[i].x;
+			break;
+		}
+	}
+	free(item);
+	return x;
+}
+
+double stat_kll_rank(const stat_kll_t *s, double x){
+	assert(s);
+	if (s->n == 0.0){ return 0.0/0.0; }
+	
+	int h, i;
+	double weight = 0.0;
+	for (h=0; h < s->num_levels; h++){
+		for (i=0; i < s->size[h]; i++){
+			if (s->level[h][i] <= x){ weight += ldexp(1.0, h); }
+		}
+	}
+	return weight / s->n;
+}
+
+/****************************** Logarithmic bins ******************************/
+
+void stat_log_bins_init(stat_log_bins_t *b, double xmin, int bins_per_decade){
+	assert(b);
+	assert(xmin > 0.0);
+	assert(bins_per_decade > 0);
+	
+	b->xmin = xmin;
+	b->bins_per_decade = bins_per_decade;
+	b->num_bins = 0;
+	b->count = NULL;
+	b->n = 0.0;
+}
+
+void stat_log_bins_free(stat_log_bins_t *b){
+	assert(b);
+	free(b->count);
+	b->count = NULL;
+	b->num_bins = 0;
+}
+
+// Ensures there are at least num_bins bins
+error_t stat_log_bins_reserve(stat_log_bins_t *b, int num_bins){
+	if (num_bins <= b->num_bins){ return ERROR_SUCCESS; }
+	
+	double *count = realloc(b->count, num_bins * sizeof(*count));
+	if (!count){ return ERROR_NO_MEMORY; }
+	memset(count + b->num_bins, 0, (num_bins - b->num_bins) * sizeof(*count));
+	b->count = count;
+	b->num_bins = num_bins;
+	return ERROR_SUCCESS;
+}
+
+error_t stat_log_bins_push(stat_log_bins_t *b, double x){
+	assert(b);
+	b->n += 1.0;
+	if (!(x >= b->xmin) || isinf(x)){ return ERROR_SUCCESS; }
+	
+	int bin = (int) floor(log10(x / b->xmin) * b->bins_per_decade);
+	if (stat_log_bins_reserve(b, bin+1) != ERROR_SUCCESS){
+		return ERROR_NO_MEMORY;
+	}
+	b->count[bin] += 1.0;
+	return ERROR_SUCCESS;
+}
+
+error_t stat_log_bins_merge(stat_log_bins_t *b, const stat_log_bins_t *other){
+	assert(b);
+	assert(other);
+	assert(b->xmin == other->xmin);
+	assert(b->bins_per_decade == other->bins_per_decade);
+	
+	if (stat_log_bins_reserve(b, other->num_bins) != ERROR_SUCCESS){
+		return ERROR_NO_MEMORY;
+	}
+	int i;
+	for (i=0; i < other->num_bins; i++){
+		b->count[i] += other->count[i];
+	}
+	b->n += other->n;
+	return ERROR_SUCCESS;
+}
+
+double stat_log_bins_edge(const stat_log_bins_t *b, int i){
+	assert(b);
+	return b->xmin * pow(10.0, (double)i / b->bins_per_decade);
+}
+
+double stat_log_bins_density(const stat_log_bins_t *b, int i){
+	assert(b);
+	assert(i >= 0 && i < b->num_bins);
+	double width = stat_log_bins_edge(b, i+1) - stat_log_bins_edge(b, i);
+	return b->count[i] / (b->n * width);
+}
+
+/********************************* Power law **********************************/
+
+void stat_power_law_init(stat_power_law_t *p, double xmin, bool is_discrete){
+	assert(p);
+	assert(is_discrete ? xmin > 0.5 : xmin > 0.0);
+	p->xmin = xmin;
+	p->is_discrete = is_discrete;
+	p->n = 0.0;
+	p->sum_log = 0.0;
+}
+
+void stat_power_law_push(stat_power_law_t *p, double x){
+	assert(p);
+	if (x >= p->xmin){
+		p->n += 1.0;
+		p->sum_log += log(x / (p->is_discrete ? p->xmin - 0.5 : p->xmin));
+	}
+}
+
+void stat_power_law_merge(stat_power_law_t *p, const stat_power_law_t *other){
+	assert(p);
+	assert(other);
+	assert(p->xmin == other->xmin && p->is_discrete == other->is_discrete);
+	p->n += other->n;
+	p->sum_log += other->sum_log;
+}
+
+double stat_power_law_alpha(const stat_power_law_t *p, double *error){
+	assert(p);
+	if (p->n == 0.0 || p->sum_log <= 0.0){
+		if (error){ *error = 0.0/0.0; }
+		return 0.0/0.0;
 	}
-	return r;
+	double alpha = 1.0 + p->n / p->sum_log;
+	if (error){ *error = (alpha - 1.0) / sqrt(p->n); }
+	return alpha;
 }
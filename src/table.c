@@ -0,0 +1,126 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "table.h"
+
+int table_type_size(table_type_t type){
+	switch(type){
+		case TABLE_INT:    return sizeof(int32_t);
+		case TABLE_DOUBLE: return sizeof(double);
+		default: break;
+	}
+	return 0;
+}
+
+void table_write_int(FILE *fp, int value){
+	int32_t x = value;
+	fwrite(&x, sizeof(x), 1, fp);
+}
+
+bool table_read_int(FILE *fp, int *value){
+	int32_t x;
+	if (fread(&x, sizeof(x), 1, fp) != 1){ return false; }
+	*value = x;
+	return true;
+}
+
+error_t table_write
+		(const char *filename, const table_column_t *column, int num_column,
+		 int num_row){
+	assert(filename);
+	assert(column || num_column == 0);
+	assert(num_column >= 0 && num_row >= 0);
+	assert(sizeof(int) == sizeof(int32_t));
+
+	FILE *fp = fopen(filename, "wb");
+	if (!fp){ return ERROR_UNDEFINED; }
+
+	fwrite(TABLE_MAGIC, 1, 4, fp);
+	table_write_int(fp, 1);
+	table_write_int(fp, num_column);
+	table_write_int(fp, num_row);
+
+	int i;
+	for (i=0; i < num_column; i++){
+		assert(column[i].type < TABLE_NUM_TYPE);
+		int length = strlen(column[i].name);
+		table_write_int(fp, column[i].type);
+		table_write_int(fp, length);
+		fwrite(column[i].name, 1, length, fp);
+	}
+	for (i=0; i < num_column; i++){
+		fwrite(column[i].data, table_type_size(column[i].type), num_row, fp);
+	}
+
+	error_t error = ferror(fp) ? ERROR_UNDEFINED : ERROR_SUCCESS;
+	if (fclose(fp) != 0){ error = ERROR_UNDEFINED; }
+	return error;
+}
+
+table_column_t *table_read
+		(const char *filename, int *num_column, int *num_row){
+	assert(filename);
+	assert(num_column);
+	assert(num_row);
+
+	FILE *fp = fopen(filename, "rb");
+	if (!fp){ return NULL; }
+
+	char magic[4];
+	int bom;
+	table_column_t *column = NULL;
+	if (fread(magic, 1, 4, fp) != 4 || memcmp(magic, TABLE_MAGIC, 4) != 0 ||
+	    !table_read_int(fp, &bom) || bom != 1 ||
+	    !table_read_int(fp, num_column) || *num_column < 0 ||
+	    !table_read_int(fp, num_row) || *num_row < 0){
+		goto failure;
+	}
+
+	// Columns are zeroed, so that all of them can be deleted on failure
+	column = calloc(*num_column, sizeof(*column));
+	if (!column){ goto failure; }
+
+	int i, type, length;
+	for (i=0; i < *num_column; i++){
+		if (!table_read_int(fp, &type) || type < 0 || type >= TABLE_NUM_TYPE ||
+		    !table_read_int(fp, &length) || length < 0){
+			goto failure;
+		}
+		column[i].type = type;
+		column[i].name = malloc(length+1);
+		if (!column[i].name || fread(column[i].name, 1, length, fp) != length){
+			goto failure;
+		}
+		column[i].name[length] = '\0';
+	}
+	for (i=0; i < *num_column; i++){
+		size_t size = table_type_size(column[i].type);
+		column[i].data = malloc(*num_row * size + 1);
+		if (!column[i].data ||
+		    fread(column[i].data, size, *num_row, fp) != *num_row){
+			goto failure;
+		}
+	}
+
+	fclose(fp);
+	return column;
+
+failure:
+	delete_table_columns(column, *num_column);
+	fclose(fp);
+	return NULL;
+}
+
+void delete_table_columns(table_column_t *column, int num_column){
+	if (!column){ return; }
+	int i;
+	for (i=0; i < num_column; i++){
+		free(column[i].name);
+		free(column[i].data);
+	}
+	free(column);
+}